@@ -55,6 +55,13 @@ ifneq ($(YAUL_OPTION_MALLOC_IMPL),$(filter $(YAUL_OPTION_MALLOC_IMPL),tlsf))
   $(error Invalid value for YAUL_OPTION_MALLOC_IMPL (malloc implementation))
 endif
 
+ifneq (1,$(words [$(strip $(YAUL_OPTION_BCL_DECOMPRESS_IMPL))]))
+  $(error YAUL_OPTION_BCL_DECOMPRESS_IMPL (BCL decompressors) contains spaces)
+endif
+ifneq ($(YAUL_OPTION_BCL_DECOMPRESS_IMPL),$(filter $(YAUL_OPTION_BCL_DECOMPRESS_IMPL),c sh2))
+  $(error Invalid value for YAUL_OPTION_BCL_DECOMPRESS_IMPL (BCL decompressors))
+endif
+
 ifeq ($(OS),Windows_NT)
 EXE_EXT:= .exe
 endif
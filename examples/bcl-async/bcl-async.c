@@ -0,0 +1,294 @@
+/*
+ * Copyright (c) Israel Jacquez
+ * See LICENSE for details.
+ *
+ * Israel Jacquez <mrkotfw@gmail.com>
+ */
+
+/* Measures how much of the master CPU's time background decompression on the
+ * slave CPU gives back.
+ *
+ * The same sample is decompressed into a number of output buffers three ways:
+ * by the master CPU alone, by the slave CPU while the master CPU polls for
+ * completion between units of its own work, and by both CPUs while the master
+ * CPU waits on the last request. For each, the time until every output is
+ * ready is reported, along with the time the master CPU spent in libbcl. The
+ * outputs are checked against the original sample, and the callbacks are
+ * checked to arrive in submission order.
+ *
+ * The time taken is read from the CPU-FRT, with interrupts left enabled, as
+ * they would be in a game */
+
+#include <yaul.h>
+
+#include <bcl.h>
+#include <bcl_async.h>
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+/* Must match sample.c */
+#define SAMPLE_SIZE      (8192)
+
+#define REQUEST_COUNT    (8)
+
+#define JOB_LOCK_BASE    (0)
+
+/* Roughly what the master CPU gets done between two polls */
+#define WORK_UNIT_LOOPS  (256)
+
+/* The CPU-FRT counts every 8 CPU cycles */
+#define FRT_TICK_CYCLES  (8)
+
+typedef enum {
+    MODE_SYNC,
+    MODE_POLL,
+    MODE_WAIT,
+    MODE_COUNT
+} run_mode_t;
+
+typedef struct {
+    const char *name;
+    bcl_codec_t codec;
+    uint8_t *in;
+    const uint8_t *in_end;
+} codec_t;
+
+typedef struct {
+    uint32_t total_ticks;
+    uint32_t master_ticks;
+    uint32_t work_units;
+    uint32_t errors;
+} result_t;
+
+extern uint8_t asset_sample[];
+
+extern uint8_t asset_sample_lz[];
+extern uint8_t asset_sample_lz_end[];
+extern uint8_t asset_sample_lz4[];
+extern uint8_t asset_sample_lz4_end[];
+
+static const codec_t _codecs[] = {
+    {
+        .name   = "LZ",
+        .codec  = BCL_CODEC_LZ,
+        .in     = asset_sample_lz,
+        .in_end = asset_sample_lz_end
+    }, {
+        .name   = "LZ4",
+        .codec  = BCL_CODEC_LZ4,
+        .in     = asset_sample_lz4,
+        .in_end = asset_sample_lz4_end
+    }
+};
+
+#define CODEC_COUNT (sizeof(_codecs) / sizeof(*_codecs))
+
+static bcl_async_request_t _requests[REQUEST_COUNT];
+static uint8_t _outputs[REQUEST_COUNT][SAMPLE_SIZE] __aligned(16);
+
+static uint32_t _delivered;
+static uint32_t _order_errors;
+
+static result_t _results[CODEC_COUNT][MODE_COUNT];
+
+static void _run(const codec_t *codec, run_mode_t mode, result_t *result);
+static void _sync_decompress(const codec_t *codec, uint8_t *out);
+static void _requests_submit(const codec_t *codec);
+static void _request_done(bcl_async_request_t *request, void *work);
+static void _work_unit(void);
+
+static void _results_print(void);
+
+int
+main(void)
+{
+    dbgio_dev_default_init(DBGIO_DEV_VDP2_ASYNC);
+    dbgio_dev_font_load();
+
+    dbgio_printf("Decompressing...\n");
+    dbgio_flush();
+
+    vdp2_sync();
+    vdp2_sync_wait();
+
+    cpu_job_init(JOB_LOCK_BASE);
+
+    for (uint32_t codec = 0; codec < CODEC_COUNT; codec++) {
+        for (uint32_t mode = 0; mode < MODE_COUNT; mode++) {
+            _run(&_codecs[codec], mode, &_results[codec][mode]);
+        }
+    }
+
+    while (true) {
+        _results_print();
+
+        dbgio_flush();
+
+        vdp2_sync();
+        vdp2_sync_wait();
+    }
+}
+
+void
+user_init(void)
+{
+    vdp2_tvmd_display_res_set(VDP2_TVMD_INTERLACE_NONE, VDP2_TVMD_HORZ_NORMAL_A,
+        VDP2_TVMD_VERT_224);
+
+    vdp2_scrn_back_color_set(VDP2_VRAM_ADDR(3, 0x01FFFE),
+        RGB1555(1, 0, 3, 15));
+
+    vdp2_tvmd_display_set();
+}
+
+static void
+_run(const codec_t *codec, run_mode_t mode, result_t *result)
+{
+    (void)memset(_outputs, 0x00, sizeof(_outputs));
+
+    _delivered = 0;
+    _order_errors = 0;
+
+    const uint32_t start_ticks = vdp_sync_ticks_get();
+
+    switch (mode) {
+    case MODE_SYNC:
+        for (uint32_t i = 0; i < REQUEST_COUNT; i++) {
+            _sync_decompress(codec, _outputs[i]);
+        }
+
+        result->master_ticks = vdp_sync_ticks_get() - start_ticks;
+        break;
+    case MODE_POLL:
+        _requests_submit(codec);
+
+        result->master_ticks = vdp_sync_ticks_get() - start_ticks;
+
+        while (true) {
+            const uint32_t poll_ticks = vdp_sync_ticks_get();
+            const uint32_t count = bcl_async_poll();
+
+            result->master_ticks += vdp_sync_ticks_get() - poll_ticks;
+
+            if (count == 0) {
+                break;
+            }
+
+            _work_unit();
+
+            result->work_units++;
+        }
+        break;
+    case MODE_WAIT:
+        _requests_submit(codec);
+
+        bcl_async_wait(&_requests[REQUEST_COUNT - 1]);
+
+        result->master_ticks = vdp_sync_ticks_get() - start_ticks;
+        break;
+    default:
+        break;
+    }
+
+    result->total_ticks = vdp_sync_ticks_get() - start_ticks;
+
+    result->errors = _order_errors;
+
+    if ((mode != MODE_SYNC) && (_delivered != REQUEST_COUNT)) {
+        result->errors++;
+    }
+
+    for (uint32_t i = 0; i < REQUEST_COUNT; i++) {
+        if ((memcmp(_outputs[i], asset_sample, SAMPLE_SIZE)) != 0) {
+            result->errors++;
+        }
+    }
+}
+
+static void
+_sync_decompress(const codec_t *codec, uint8_t *out)
+{
+    const uint32_t in_size = codec->in_end - codec->in;
+
+    switch (codec->codec) {
+    case BCL_CODEC_LZ:
+        bcl_lz_decompress(codec->in, out, in_size);
+        break;
+    case BCL_CODEC_LZ4:
+        bcl_lz4_decompress(codec->in, out, in_size);
+        break;
+    default:
+        break;
+    }
+}
+
+static void
+_requests_submit(const codec_t *codec)
+{
+    const uint32_t in_size = codec->in_end - codec->in;
+
+    for (uint32_t i = 0; i < REQUEST_COUNT; i++) {
+        const int ret __unused = bcl_async_submit(&_requests[i], codec->codec,
+            codec->in, in_size, _outputs[i], SAMPLE_SIZE, _request_done,
+            (void *)(uintptr_t)i);
+
+        /* REQUEST_COUNT is well under the size of the job deque */
+        assert(ret == 0);
+    }
+}
+
+static void
+_request_done(bcl_async_request_t *request __unused, void *work)
+{
+    const uint32_t index = (uintptr_t)work;
+
+    if (index != _delivered) {
+        _order_errors++;
+    }
+
+    _delivered++;
+}
+
+static void
+_work_unit(void)
+{
+    static volatile uint32_t counter;
+
+    for (uint32_t i = 0; i < WORK_UNIT_LOOPS; i++) {
+        counter++;
+    }
+}
+
+static void
+_results_print(void)
+{
+    static const char * const mode_names[] = {
+        "sync",
+        "poll",
+        "wait"
+    };
+
+    dbgio_printf("\e[H\e[2J"
+                 "%i requests of %i bytes\n"
+                 "\n"
+                 "          total cyc  master cyc  units  errors\n",
+        REQUEST_COUNT,
+        SAMPLE_SIZE);
+
+    for (uint32_t codec = 0; codec < CODEC_COUNT; codec++) {
+        for (uint32_t mode = 0; mode < MODE_COUNT; mode++) {
+            const result_t * const result = &_results[codec][mode];
+
+            dbgio_printf("%-3s %-4s  %9lu  %10lu  %5lu  %6lu\n",
+                _codecs[codec].name,
+                mode_names[mode],
+                result->total_ticks * FRT_TICK_CYCLES,
+                result->master_ticks * FRT_TICK_CYCLES,
+                result->work_units,
+                result->errors);
+        }
+    }
+}
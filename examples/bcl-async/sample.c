@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) Israel Jacquez
+ * See LICENSE for details.
+ *
+ * Israel Jacquez <mrkotfw@gmail.com>
+ */
+
+/* Host program that writes the sample that bcl-async.c decompresses.
+ *
+ * The first half of the sample is text built from a small vocabulary, and the
+ * second half is rows of 8-bit pixels made of runs. It's generated from a
+ * fixed seed, so the numbers can be compared between builds */
+
+#define PROGNAME "sample"
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Must match bcl-async.c */
+#define SAMPLE_SIZE (8192)
+
+static const char * const _words[] = {
+    "the", "saturn", "sprite", "is", "drawn", "by", "vdp1", "while", "a",
+    "scroll", "screen", "of", "vdp2", "moves", "under", "it", "and", "each",
+    "frame", "the", "master", "cpu", "carries", "on", "as", "slave",
+    "decompresses", "next", "level", "from", "disc", "into", "work", "ram"
+};
+
+static uint32_t _seed = 0x2545F491;
+
+static void _usage_print(void);
+static void _error_print(const char *fmt, ...);
+
+static uint32_t _random_next(void);
+
+static void _text_generate(uint8_t *buffer, size_t size);
+static void _runs_generate(uint8_t *buffer, size_t size);
+
+int
+main(int argc, char *argv[])
+{
+    if (argc != 2) {
+        _usage_print();
+
+        return 1;
+    }
+
+    static uint8_t buffer[SAMPLE_SIZE];
+
+    _text_generate(buffer, SAMPLE_SIZE / 2);
+    _runs_generate(&buffer[SAMPLE_SIZE / 2], SAMPLE_SIZE / 2);
+
+    FILE *fp;
+
+    if ((fp = fopen(argv[1], "wb")) == NULL) {
+        _error_print("%s: %s\n", argv[1], strerror(errno));
+
+        return 1;
+    }
+
+    if ((fwrite(buffer, 1, sizeof(buffer), fp)) != sizeof(buffer)) {
+        _error_print("%s: %s\n", argv[1], strerror(errno));
+
+        (void)fclose(fp);
+
+        return 1;
+    }
+
+    (void)fclose(fp);
+
+    return 0;
+}
+
+static void
+_usage_print(void)
+{
+    (void)fprintf(stderr, "Usage: %s sample-file\n", PROGNAME);
+}
+
+static void
+_error_print(const char *fmt, ...)
+{
+    va_list ap;
+
+    va_start(ap, fmt);
+
+    (void)fprintf(stderr, "Error: %s: ", PROGNAME);
+    (void)vfprintf(stderr, fmt, ap);
+
+    va_end(ap);
+}
+
+/* xorshift32 */
+static uint32_t
+_random_next(void)
+{
+    _seed ^= _seed << 13;
+    _seed ^= _seed >> 17;
+    _seed ^= _seed << 5;
+
+    return _seed;
+}
+
+static void
+_text_generate(uint8_t *buffer, size_t size)
+{
+    const uint32_t word_count = sizeof(_words) / sizeof(*_words);
+
+    size_t offset;
+    offset = 0;
+
+    while (offset < size) {
+        const char * const word = _words[_random_next() % word_count];
+        const char separator = ((_random_next() % 12) == 0) ? '\n' : ' ';
+
+        for (const char *p = word; (*p != '\0') && (offset < size); p++) {
+            buffer[offset++] = *p;
+        }
+
+        if (offset < size) {
+            buffer[offset++] = separator;
+        }
+    }
+}
+
+static void
+_runs_generate(uint8_t *buffer, size_t size)
+{
+    size_t offset;
+    offset = 0;
+
+    while (offset < size) {
+        const uint8_t color = _random_next() % 6;
+
+        size_t length;
+        length = 1 + (_random_next() % 96);
+
+        if ((offset + length) > size) {
+            length = size - offset;
+        }
+
+        (void)memset(&buffer[offset], color, length);
+
+        offset += length;
+    }
+}
@@ -0,0 +1,360 @@
+/*
+ * Copyright (c) Israel Jacquez
+ * See LICENSE for details.
+ *
+ * Israel Jacquez <mrkotfw@gmail.com>
+ */
+
+/* Checks the SH-2 versions of the LZ, PRS, and RLE decompressors against the C
+ * versions, and measures both. The LZ4 decompressor only has a C version, and
+ * is measured alongside them.
+ *
+ * Every codec decompresses every sample of the corpus (see corpus.c) at all
+ * four output alignments. The output has to match the original sample, and
+ * the guard bytes around it have to be left untouched. The time taken is read
+ * from the CPU-FRT with interrupts masked, and reported as CPU cycles per
+ * output byte */
+
+#include <yaul.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+/* Must match corpus.c */
+#define SAMPLE_SIZE  (8192)
+#define SAMPLE_COUNT (3)
+
+#define CODEC_COUNT  (4)
+
+#define IMPL_C       (0)
+#define IMPL_SH2     (1)
+#define IMPL_COUNT   (2)
+
+#define ALIGNMENT_COUNT (4)
+
+#define GUARD_SIZE   (16)
+#define GUARD_BYTE   (0xA5)
+
+/* The CPU-FRT counts every 8 CPU cycles */
+#define FRT_TICK_CYCLES (8)
+/* FRT ticks per second at the 28.64MHz (NTSC) CPU clock, divided by 1024 */
+#define FRT_TICKS_PER_KIB_SECOND (3496)
+
+typedef void (*decompress_t)(uint8_t *in, uint8_t *out, uint32_t in_size);
+
+typedef struct {
+    const char *name;
+    decompress_t impls[IMPL_COUNT];
+} codec_t;
+
+typedef struct {
+    const char *name;
+    const uint8_t *raw;
+    uint8_t *compressed[CODEC_COUNT];
+    const uint8_t *compressed_end[CODEC_COUNT];
+} sample_t;
+
+typedef struct {
+    uint32_t bytes;
+    uint32_t ticks;
+    uint32_t errors;
+} result_t;
+
+extern void bcl_lz_decompress_c(uint8_t *in, uint8_t *out, uint32_t in_size);
+extern void bcl_lz_decompress_sh2(uint8_t *in, uint8_t *out, uint32_t in_size);
+extern void bcl_prs_decompress_c(void *in, void *out);
+extern void bcl_prs_decompress_sh2(void *in, void *out);
+extern void bcl_rle_decompress_c(uint8_t *in, uint8_t *out, uint32_t in_size);
+extern void bcl_rle_decompress_sh2(uint8_t *in, uint8_t *out, uint32_t in_size);
+extern void bcl_lz4_decompress_c(void *in, void *out, uint32_t in_size);
+
+extern uint8_t asset_text[];
+extern uint8_t asset_runs[];
+extern uint8_t asset_noise[];
+
+extern uint8_t asset_text_lz[];
+extern uint8_t asset_text_lz_end[];
+extern uint8_t asset_runs_lz[];
+extern uint8_t asset_runs_lz_end[];
+extern uint8_t asset_noise_lz[];
+extern uint8_t asset_noise_lz_end[];
+
+extern uint8_t asset_text_prs[];
+extern uint8_t asset_text_prs_end[];
+extern uint8_t asset_runs_prs[];
+extern uint8_t asset_runs_prs_end[];
+extern uint8_t asset_noise_prs[];
+extern uint8_t asset_noise_prs_end[];
+
+extern uint8_t asset_text_rle[];
+extern uint8_t asset_text_rle_end[];
+extern uint8_t asset_runs_rle[];
+extern uint8_t asset_runs_rle_end[];
+extern uint8_t asset_noise_rle[];
+extern uint8_t asset_noise_rle_end[];
+
+extern uint8_t asset_text_lz4[];
+extern uint8_t asset_text_lz4_end[];
+extern uint8_t asset_runs_lz4[];
+extern uint8_t asset_runs_lz4_end[];
+extern uint8_t asset_noise_lz4[];
+extern uint8_t asset_noise_lz4_end[];
+
+static void _prs_c(uint8_t *in, uint8_t *out, uint32_t in_size);
+static void _prs_sh2(uint8_t *in, uint8_t *out, uint32_t in_size);
+static void _lz4_c(uint8_t *in, uint8_t *out, uint32_t in_size);
+
+static const codec_t _codecs[CODEC_COUNT] = {
+    {
+        .name  = "LZ",
+        .impls = {
+            bcl_lz_decompress_c,
+            bcl_lz_decompress_sh2
+        }
+    }, {
+        .name  = "PRS",
+        .impls = {
+            _prs_c,
+            _prs_sh2
+        }
+    }, {
+        .name  = "RLE",
+        .impls = {
+            bcl_rle_decompress_c,
+            bcl_rle_decompress_sh2
+        }
+    }, {
+        .name  = "LZ4",
+        .impls = {
+            _lz4_c,
+            NULL
+        }
+    }
+};
+
+static const sample_t _samples[SAMPLE_COUNT] = {
+    {
+        .name           = "text",
+        .raw            = asset_text,
+        .compressed     = {
+            asset_text_lz,
+            asset_text_prs,
+            asset_text_rle,
+            asset_text_lz4
+        },
+        .compressed_end = {
+            asset_text_lz_end,
+            asset_text_prs_end,
+            asset_text_rle_end,
+            asset_text_lz4_end
+        }
+    }, {
+        .name           = "runs",
+        .raw            = asset_runs,
+        .compressed     = {
+            asset_runs_lz,
+            asset_runs_prs,
+            asset_runs_rle,
+            asset_runs_lz4
+        },
+        .compressed_end = {
+            asset_runs_lz_end,
+            asset_runs_prs_end,
+            asset_runs_rle_end,
+            asset_runs_lz4_end
+        }
+    }, {
+        .name           = "noise",
+        .raw            = asset_noise,
+        .compressed     = {
+            asset_noise_lz,
+            asset_noise_prs,
+            asset_noise_rle,
+            asset_noise_lz4
+        },
+        .compressed_end = {
+            asset_noise_lz_end,
+            asset_noise_prs_end,
+            asset_noise_rle_end,
+            asset_noise_lz4_end
+        }
+    }
+};
+
+static result_t _results[CODEC_COUNT][IMPL_COUNT];
+
+static uint8_t _buffer[GUARD_SIZE + (ALIGNMENT_COUNT - 1) + SAMPLE_SIZE + GUARD_SIZE] __aligned(4);
+
+static void _codec_run(uint32_t codec, uint32_t impl);
+static bool _output_check(const uint8_t *out, const uint8_t *raw);
+
+static void _results_print(void);
+
+int
+main(void)
+{
+    dbgio_dev_default_init(DBGIO_DEV_VDP2_ASYNC);
+    dbgio_dev_font_load();
+
+    dbgio_printf("Decompressing...\n");
+    dbgio_flush();
+
+    vdp2_sync();
+    vdp2_sync_wait();
+
+    for (uint32_t codec = 0; codec < CODEC_COUNT; codec++) {
+        for (uint32_t impl = 0; impl < IMPL_COUNT; impl++) {
+            _codec_run(codec, impl);
+        }
+    }
+
+    while (true) {
+        _results_print();
+
+        dbgio_flush();
+
+        vdp2_sync();
+        vdp2_sync_wait();
+    }
+}
+
+void
+user_init(void)
+{
+    vdp2_tvmd_display_res_set(VDP2_TVMD_INTERLACE_NONE, VDP2_TVMD_HORZ_NORMAL_A,
+        VDP2_TVMD_VERT_224);
+
+    vdp2_scrn_back_color_set(VDP2_VRAM_ADDR(3, 0x01FFFE),
+        RGB1555(1, 0, 3, 15));
+
+    vdp2_tvmd_display_set();
+}
+
+static void
+_prs_c(uint8_t *in, uint8_t *out, uint32_t in_size __unused)
+{
+    bcl_prs_decompress_c(in, out);
+}
+
+static void
+_prs_sh2(uint8_t *in, uint8_t *out, uint32_t in_size __unused)
+{
+    bcl_prs_decompress_sh2(in, out);
+}
+
+static void
+_lz4_c(uint8_t *in, uint8_t *out, uint32_t in_size)
+{
+    bcl_lz4_decompress_c(in, out, in_size);
+}
+
+static void
+_codec_run(uint32_t codec, uint32_t impl)
+{
+    const decompress_t decompress = _codecs[codec].impls[impl];
+    result_t * const result = &_results[codec][impl];
+
+    if (decompress == NULL) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < SAMPLE_COUNT; i++) {
+        const sample_t * const sample = &_samples[i];
+
+        uint8_t * const in = sample->compressed[codec];
+        const uint32_t in_size = sample->compressed_end[codec] - in;
+
+        for (uint32_t alignment = 0; alignment < ALIGNMENT_COUNT; alignment++) {
+            uint8_t * const out = &_buffer[GUARD_SIZE + alignment];
+
+            (void)memset(_buffer, GUARD_BYTE, sizeof(_buffer));
+
+            /* A single decompression is well under the ~18ms it takes for the
+             * 16-bit count to wrap twice, so the two reads are enough to
+             * catch the wrap */
+            const uint8_t sr_mask = cpu_intc_mask_get();
+            cpu_intc_mask_set(15);
+
+            const uint32_t start_ticks = vdp_sync_ticks_get();
+
+            decompress(in, out, in_size);
+
+            const uint32_t ticks = vdp_sync_ticks_get() - start_ticks;
+
+            cpu_intc_mask_set(sr_mask);
+
+            result->bytes += SAMPLE_SIZE;
+            result->ticks += ticks;
+
+            if (!(_output_check(out, sample->raw))) {
+                result->errors++;
+            }
+        }
+    }
+}
+
+static bool
+_output_check(const uint8_t *out, const uint8_t *raw)
+{
+    if ((memcmp(out, raw, SAMPLE_SIZE)) != 0) {
+        return false;
+    }
+
+    for (const uint8_t *p = _buffer; p < out; p++) {
+        if (*p != GUARD_BYTE) {
+            return false;
+        }
+    }
+
+    for (const uint8_t *p = &out[SAMPLE_SIZE]; p < &_buffer[sizeof(_buffer)]; p++) {
+        if (*p != GUARD_BYTE) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void
+_results_print(void)
+{
+    static const char * const impl_names[] = {
+        "C",
+        "SH-2"
+    };
+
+    dbgio_printf("\e[H\e[2J"
+                 "Corpus: %s, %s, %s (%i bytes each)\n"
+                 "at output alignments 0 to 3\n"
+                 "\n"
+                 "           cycles/byte   KiB/s  errors\n",
+        _samples[0].name,
+        _samples[1].name,
+        _samples[2].name,
+        SAMPLE_SIZE);
+
+    for (uint32_t codec = 0; codec < CODEC_COUNT; codec++) {
+        for (uint32_t impl = 0; impl < IMPL_COUNT; impl++) {
+            const result_t * const result = &_results[codec][impl];
+
+            if (_codecs[codec].impls[impl] == NULL) {
+                continue;
+            }
+
+            const uint32_t cycles_100 =
+                (result->ticks * FRT_TICK_CYCLES * 100) / result->bytes;
+            const uint32_t kib_second = (result->ticks != 0)
+                ? ((result->bytes * FRT_TICKS_PER_KIB_SECOND) / result->ticks)
+                : 0;
+
+            dbgio_printf("%-4s %-4s   %6lu.%02lu     %6lu  %lu\n",
+                _codecs[codec].name,
+                impl_names[impl],
+                cycles_100 / 100,
+                cycles_100 % 100,
+                kib_second,
+                result->errors);
+        }
+    }
+}
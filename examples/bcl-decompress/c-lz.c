@@ -0,0 +1,13 @@
+/*
+ * Copyright (c) Israel Jacquez
+ * See LICENSE for details.
+ *
+ * Israel Jacquez <mrkotfw@gmail.com>
+ */
+
+/* The C version of bcl_lz_decompress, renamed so that it can be linked next
+ * to the SH-2 version, whichever one libbcl was built with */
+
+#define bcl_lz_decompress bcl_lz_decompress_c
+
+#include "../../libbcl/lz.c"
@@ -0,0 +1,13 @@
+/*
+ * Copyright (c) Israel Jacquez
+ * See LICENSE for details.
+ *
+ * Israel Jacquez <mrkotfw@gmail.com>
+ */
+
+/* The C version of bcl_lz4_decompress, renamed to match the other codecs.
+ * There is no SH-2 version of it */
+
+#define bcl_lz4_decompress bcl_lz4_decompress_c
+
+#include "../../libbcl/lz4.c"
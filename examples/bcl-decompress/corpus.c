@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) Israel Jacquez
+ * See LICENSE for details.
+ *
+ * Israel Jacquez <mrkotfw@gmail.com>
+ */
+
+/* Host program that writes the corpus that bcl-decompress.c decompresses.
+ *
+ * The corpus is text built from a small vocabulary, a run-heavy image-like
+ * buffer, and noise that doesn't compress. All three are generated from a
+ * fixed seed, so the numbers can be compared between builds */
+
+#define PROGNAME "corpus"
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Must match bcl-decompress.c */
+#define SAMPLE_SIZE (8192)
+
+static const char * const _words[] = {
+    "the", "saturn", "sprite", "is", "drawn", "by", "vdp1", "while", "a",
+    "scroll", "screen", "of", "vdp2", "moves", "under", "it", "and", "each",
+    "frame", "the", "master", "cpu", "waits", "for", "slave", "to", "finish",
+    "decompressing", "next", "level", "from", "disc", "into", "work", "ram"
+};
+
+static uint32_t _seed = 0x2545F491;
+
+static void _usage_print(void);
+static void _error_print(const char *fmt, ...);
+
+static uint32_t _random_next(void);
+static int _file_write(const char *filename, const uint8_t *buffer, size_t size);
+
+static void _text_generate(uint8_t *buffer);
+static void _runs_generate(uint8_t *buffer);
+static void _noise_generate(uint8_t *buffer);
+
+int
+main(int argc, char *argv[])
+{
+    if (argc != 4) {
+        _usage_print();
+
+        return 1;
+    }
+
+    static uint8_t buffer[SAMPLE_SIZE];
+
+    _text_generate(buffer);
+
+    if ((_file_write(argv[1], buffer, sizeof(buffer))) != 0) {
+        return 1;
+    }
+
+    _runs_generate(buffer);
+
+    if ((_file_write(argv[2], buffer, sizeof(buffer))) != 0) {
+        return 1;
+    }
+
+    _noise_generate(buffer);
+
+    if ((_file_write(argv[3], buffer, sizeof(buffer))) != 0) {
+        return 1;
+    }
+
+    return 0;
+}
+
+static void
+_usage_print(void)
+{
+    (void)fprintf(stderr, "Usage: %s text-file runs-file noise-file\n",
+        PROGNAME);
+}
+
+static void
+_error_print(const char *fmt, ...)
+{
+    va_list ap;
+
+    va_start(ap, fmt);
+
+    (void)fprintf(stderr, "Error: %s: ", PROGNAME);
+    (void)vfprintf(stderr, fmt, ap);
+
+    va_end(ap);
+}
+
+/* xorshift32 */
+static uint32_t
+_random_next(void)
+{
+    _seed ^= _seed << 13;
+    _seed ^= _seed >> 17;
+    _seed ^= _seed << 5;
+
+    return _seed;
+}
+
+static int
+_file_write(const char *filename, const uint8_t *buffer, size_t size)
+{
+    FILE *fp;
+
+    if ((fp = fopen(filename, "wb")) == NULL) {
+        _error_print("%s: %s\n", filename, strerror(errno));
+
+        return 1;
+    }
+
+    if ((fwrite(buffer, 1, size, fp)) != size) {
+        _error_print("%s: %s\n", filename, strerror(errno));
+
+        (void)fclose(fp);
+
+        return 1;
+    }
+
+    (void)fclose(fp);
+
+    return 0;
+}
+
+static void
+_text_generate(uint8_t *buffer)
+{
+    const uint32_t word_count = sizeof(_words) / sizeof(*_words);
+
+    size_t offset;
+    offset = 0;
+
+    while (offset < SAMPLE_SIZE) {
+        const char * const word = _words[_random_next() % word_count];
+        const char separator = ((_random_next() % 12) == 0) ? '\n' : ' ';
+
+        for (const char *p = word; (*p != '\0') && (offset < SAMPLE_SIZE); p++) {
+            buffer[offset++] = *p;
+        }
+
+        if (offset < SAMPLE_SIZE) {
+            buffer[offset++] = separator;
+        }
+    }
+}
+
+/* Rows of 8-bit pixels, where runs of a few colors are broken up by the odd
+ * stray pixel */
+static void
+_runs_generate(uint8_t *buffer)
+{
+    size_t offset;
+    offset = 0;
+
+    while (offset < SAMPLE_SIZE) {
+        const uint8_t color = _random_next() % 6;
+
+        size_t length;
+        length = 1 + (_random_next() % 96);
+
+        if ((offset + length) > SAMPLE_SIZE) {
+            length = SAMPLE_SIZE - offset;
+        }
+
+        (void)memset(&buffer[offset], color, length);
+
+        offset += length;
+
+        if (((_random_next() % 4) == 0) && (offset < SAMPLE_SIZE)) {
+            buffer[offset++] = _random_next();
+        }
+    }
+}
+
+static void
+_noise_generate(uint8_t *buffer)
+{
+    for (size_t offset = 0; offset < SAMPLE_SIZE; offset++) {
+        buffer[offset] = _random_next() >> 24;
+    }
+}
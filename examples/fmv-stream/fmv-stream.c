@@ -0,0 +1,363 @@
+/*
+ * Copyright (c) Israel Jacquez
+ * See LICENSE for details.
+ *
+ * Israel Jacquez <mrkotfw@gmail.com>
+ */
+
+/* Plays the stream track written by make-fmv-track, and checks that every
+ * video frame and audio chunk arrives in the right place, at the right time.
+ *
+ * Each video frame and audio chunk starts with a marker holding its tag and
+ * index (see test-pattern.c). A frame that ends up in the audio buffer, or a
+ * chunk that ends up in a bitmap, shows up as a marker error. This exercises
+ * the CD-block filter routing by channel */
+
+#include <yaul.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Must match the Makefile */
+#define VIDEO_FRAME_COUNT        (60)
+#define VIDEO_FRAME_SECTOR_COUNT (8)
+#define VIDEO_FRAME_PERIOD       (6)
+
+#define AUDIO_CHUNK_COUNT        (30)
+#define AUDIO_CHUNK_SECTOR_COUNT (2)
+#define AUDIO_CHUNK_PERIOD       (12)
+
+/* Must match make-fmv-track */
+#define VIDEO_CHANNEL (1)
+#define AUDIO_CHANNEL (2)
+
+#define VIDEO_TAG ('V')
+#define AUDIO_TAG ('A')
+
+#define PALETTE_COLOR_COUNT (64)
+
+#define BITMAP_0  VDP2_VRAM_ADDR(0, 0x000000)
+#define BITMAP_1  VDP2_VRAM_ADDR(2, 0x000000)
+#define PALETTE   VDP2_CRAM_MODE_0_OFFSET(1, 0, 0)
+#define BACK_SCRN VDP2_VRAM_ADDR(3, 0x01FFFE)
+
+#define PCM_BUFFER (0x25A40000UL)
+
+/* The ISO9660 primary volume descriptor */
+#define PVD_FAD                   (150 + 16)
+#define PVD_VOLUME_SPACE_SIZE_LSB (80)
+
+/* Track 2 follows the data track, after a 2 second pregap */
+#define TRACK_PREGAP_SECTOR_COUNT (150)
+
+static struct {
+    volatile uint32_t vblanks;
+
+    uint32_t frames_presented;
+    uint32_t chunks_played;
+    uint32_t last_present_vblank;
+    uint32_t present_gap_max;
+
+    uint32_t video_marker_errors;
+    uint32_t audio_marker_errors;
+
+    bool started;
+    bool ended;
+    uint32_t start_vblank;
+    uint32_t end_vblank;
+} _state;
+
+static uint8_t _sector[CDFS_SECTOR_SIZE] __aligned(4);
+
+static fad_t _stream_fad_get(void);
+
+static void _playback_check(void);
+static void _stats_print(fmv_status_t status);
+
+static uint32_t _marker_read(uintptr_t address);
+
+static void _vblank_out_handler(void *work);
+static void _start_handler(void *work);
+
+int
+main(void)
+{
+    dbgio_dev_default_init(DBGIO_DEV_VDP2_ASYNC);
+    dbgio_dev_font_load();
+
+    if ((cd_block_init()) != 0) {
+        dbgio_printf("cd_block_init() failed\n");
+        dbgio_flush();
+
+        vdp2_sync();
+        vdp2_sync_wait();
+
+        abort();
+    }
+
+    const fad_t fad = _stream_fad_get();
+
+    if (fad == 0) {
+        dbgio_printf("Couldn't read the primary volume descriptor\n");
+        dbgio_flush();
+
+        vdp2_sync();
+        vdp2_sync_wait();
+
+        abort();
+    }
+
+    const fmv_config_t config = {
+        .fad          = fad,
+        .sector_count = (VIDEO_FRAME_COUNT * VIDEO_FRAME_SECTOR_COUNT) +
+                        (AUDIO_CHUNK_COUNT * AUDIO_CHUNK_SECTOR_COUNT),
+
+        .video_channel = VIDEO_CHANNEL,
+        .audio_channel = AUDIO_CHANNEL,
+
+        .bitmap_format = {
+            .scroll_screen = VDP2_SCRN_NBG0,
+            .ccc           = VDP2_SCRN_CCC_PALETTE_256,
+            .bitmap_size   = VDP2_SCRN_BITMAP_SIZE_512X256,
+            .palette_base  = PALETTE,
+            .bitmap_base   = BITMAP_0
+        },
+        .bitmap_bases = {
+            BITMAP_0,
+            BITMAP_1
+        },
+
+        .video_frame_count        = VIDEO_FRAME_COUNT,
+        .video_frame_sector_count = VIDEO_FRAME_SECTOR_COUNT,
+        .video_frame_period       = VIDEO_FRAME_PERIOD,
+        .video_decode             = NULL,
+        .video_buffer             = NULL,
+        .video_work               = NULL,
+
+        /* No SCSP slot is started. The chunks are checked by their markers
+         * instead */
+        .pcm_buffer               = (void *)PCM_BUFFER,
+        .audio_chunk_count        = AUDIO_CHUNK_COUNT,
+        .audio_chunk_sector_count = AUDIO_CHUNK_SECTOR_COUNT,
+        .audio_chunk_period       = AUDIO_CHUNK_PERIOD,
+
+        .start_handler = _start_handler,
+        .start_work    = NULL
+    };
+
+    int ret;
+
+    if ((ret = fmv_start(&config)) != 0) {
+        dbgio_printf("fmv_start() failed: %i\n", ret);
+    }
+
+    while (true) {
+        const fmv_status_t status = fmv_update();
+
+        _playback_check();
+        _stats_print(status);
+
+        dbgio_flush();
+
+        vdp2_sync();
+        vdp2_sync_wait();
+    }
+}
+
+void
+user_init(void)
+{
+    const vdp2_scrn_bitmap_format_t bitmap_format = {
+        .scroll_screen = VDP2_SCRN_NBG0,
+        .ccc           = VDP2_SCRN_CCC_PALETTE_256,
+        .bitmap_size   = VDP2_SCRN_BITMAP_SIZE_512X256,
+        .palette_base  = PALETTE,
+        .bitmap_base   = BITMAP_0
+    };
+
+    vdp2_scrn_bitmap_format_set(&bitmap_format);
+    vdp2_scrn_priority_set(VDP2_SCRN_NBG0, 6);
+    vdp2_scrn_display_set(VDP2_SCRN_DISP_NBG0);
+
+    /* A 256-color bitmap takes two accesses per bank. Each bitmap has a bank
+     * to itself */
+    const vdp2_vram_cycp_bank_t cycp_bank = {
+        .t0 = VDP2_VRAM_CYCP_CHPNDR_NBG0,
+        .t1 = VDP2_VRAM_CYCP_CHPNDR_NBG0,
+        .t2 = VDP2_VRAM_CYCP_CPU_RW,
+        .t3 = VDP2_VRAM_CYCP_CPU_RW,
+        .t4 = VDP2_VRAM_CYCP_CPU_RW,
+        .t5 = VDP2_VRAM_CYCP_CPU_RW,
+        .t6 = VDP2_VRAM_CYCP_CPU_RW,
+        .t7 = VDP2_VRAM_CYCP_CPU_RW
+    };
+
+    vdp2_vram_cycp_bank_set(VDP2_VRAM_BANK_A0, &cycp_bank);
+    vdp2_vram_cycp_bank_set(VDP2_VRAM_BANK_B0, &cycp_bank);
+
+    /* Color 0 is transparent, so the gradient starts at 1 */
+    rgb1555_t * const palette = (rgb1555_t *)PALETTE;
+
+    for (uint32_t i = 0; i < PALETTE_COLOR_COUNT; i++) {
+        const uint8_t level = (i < 32) ? i : (63 - i);
+
+        palette[i + 1] = RGB1555(1, level, 31 - level, 16);
+    }
+
+    vdp2_tvmd_display_res_set(VDP2_TVMD_INTERLACE_NONE, VDP2_TVMD_HORZ_NORMAL_A,
+        VDP2_TVMD_VERT_224);
+
+    vdp2_scrn_back_color_set(BACK_SCRN, RGB1555(1, 0, 0, 0));
+
+    vdp_sync_vblank_out_set(_vblank_out_handler, NULL);
+
+    vdp2_tvmd_display_set();
+}
+
+static fad_t
+_stream_fad_get(void)
+{
+    if ((cd_block_sector_read(PVD_FAD, _sector)) != 0) {
+        return 0;
+    }
+
+    const uint8_t * const p = &_sector[PVD_VOLUME_SPACE_SIZE_LSB];
+
+    const uint32_t volume_sector_count =
+        p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+
+    return 150 + volume_sector_count + TRACK_PREGAP_SECTOR_COUNT;
+}
+
+static void
+_playback_check(void)
+{
+    const fmv_stats_t * const stats = fmv_stats_get();
+    const uint32_t vblanks = _state.vblanks;
+
+    /* The front bitmap should hold the last frame presented */
+    if (stats->frames_presented != _state.frames_presented) {
+        _state.frames_presented = stats->frames_presented;
+
+        if (_state.frames_presented > 1) {
+            const uint32_t gap = vblanks - _state.last_present_vblank;
+
+            if (gap > _state.present_gap_max) {
+                _state.present_gap_max = gap;
+            }
+        }
+
+        _state.last_present_vblank = vblanks;
+
+        const uint32_t index = _state.frames_presented - 1;
+        const vdp2_vram_t front =
+            BITMAP_0 + ((_state.frames_presented & 1) * (BITMAP_1 - BITMAP_0));
+
+        if ((_marker_read(front)) != ((VIDEO_TAG << 24) | index)) {
+            _state.video_marker_errors++;
+        }
+    }
+
+    /* The half that last finished playing is either about to be refilled, or
+     * already was */
+    if (stats->chunks_played != _state.chunks_played) {
+        _state.chunks_played = stats->chunks_played;
+
+        const uint32_t index = _state.chunks_played - 1;
+        const uintptr_t half = PCM_BUFFER +
+            ((index & 1) * AUDIO_CHUNK_SECTOR_COUNT * CDFS_SECTOR_SIZE);
+
+        const uint32_t marker = _marker_read(half);
+
+        if ((marker != ((AUDIO_TAG << 24) | index)) &&
+            (marker != ((AUDIO_TAG << 24) | (index + 2)))) {
+            _state.audio_marker_errors++;
+        }
+    }
+}
+
+static void
+_stats_print(fmv_status_t status)
+{
+    static const char * const status_names[] = {
+        "idle",
+        "prebuffering",
+        "playing",
+        "done",
+        "error"
+    };
+
+    const fmv_stats_t * const stats = fmv_stats_get();
+
+    if (((status == FMV_STATUS_DONE) || (status == FMV_STATUS_ERROR)) &&
+        !_state.ended) {
+        _state.ended = true;
+        _state.end_vblank = _state.vblanks;
+    }
+
+    const uint32_t end_vblank = (_state.ended)
+        ? _state.end_vblank
+        : _state.vblanks;
+    const uint32_t play_vblanks = (_state.started)
+        ? (end_vblank - _state.start_vblank)
+        : 0;
+
+    /* Frames per 100 seconds, at 60 vertical blanks per second */
+    const uint32_t fps_100 = (play_vblanks != 0)
+        ? ((stats->frames_presented * 6000) / play_vblanks)
+        : 0;
+
+    dbgio_printf("\e[H\e[2J"
+                 "Status:         %s\n"
+                 "VBLANKs:        %lu\n"
+                 "\n"
+                 "Frames:         %lu/%i\n"
+                 "Chunks:         %lu/%i\n"
+                 "Video underrun: %lu\n"
+                 "Audio underrun: %lu\n"
+                 "\n"
+                 "Video markers:  %lu errors\n"
+                 "Audio markers:  %lu errors\n"
+                 "\n"
+                 "FPS:            %lu.%02lu (expected %i)\n"
+                 "Max frame gap:  %lu VBLANKs (expected %i)\n",
+        status_names[status],
+        _state.vblanks,
+        stats->frames_presented,
+        VIDEO_FRAME_COUNT,
+        stats->chunks_played,
+        AUDIO_CHUNK_COUNT,
+        stats->video_underruns,
+        stats->audio_underruns,
+        _state.video_marker_errors,
+        _state.audio_marker_errors,
+        fps_100 / 100,
+        fps_100 % 100,
+        60 / VIDEO_FRAME_PERIOD,
+        _state.present_gap_max,
+        VIDEO_FRAME_PERIOD);
+}
+
+/* Sound RAM sits on a 16-bit bus, so read the marker as two halves */
+static uint32_t
+_marker_read(uintptr_t address)
+{
+    const volatile uint16_t * const p = (const volatile uint16_t *)address;
+
+    return ((uint32_t)p[0] << 16) | p[1];
+}
+
+static void
+_vblank_out_handler(void *work __unused)
+{
+    _state.vblanks++;
+
+    fmv_vblank(NULL);
+}
+
+static void
+_start_handler(void *work __unused)
+{
+    _state.started = true;
+    _state.start_vblank = _state.vblanks;
+}
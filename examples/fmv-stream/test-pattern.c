@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) Israel Jacquez
+ * See LICENSE for details.
+ *
+ * Israel Jacquez <mrkotfw@gmail.com>
+ */
+
+/* Host program that writes the raw video and audio that make-fmv-track
+ * interleaves into the stream track.
+ *
+ * Each video frame is a scrolling 512-wide 256-color bitmap strip, and each
+ * audio chunk a 16-bit triangle wave. Both start with a big-endian marker of
+ * the tag in the upper 8 bits and the index in the lower 24 bits, which
+ * fmv-stream.c checks against where it expects the frame or chunk to be */
+
+#define PROGNAME "test-pattern"
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SECTOR_SIZE    (2048)
+
+#define BITMAP_WIDTH   (512)
+/* Must match the palette set up in fmv-stream.c */
+#define PALETTE_COLOR_COUNT (64)
+
+#define VIDEO_TAG ('V')
+#define AUDIO_TAG ('A')
+
+#define TRIANGLE_PERIOD (128)
+
+static void _usage_print(void);
+static void _error_print(const char *fmt, ...);
+
+static uint32_t _count_parse(const char *arg);
+static int _file_write(const char *filename, const uint8_t *buffer, size_t size);
+
+static void _marker_write(uint8_t *p, uint8_t tag, uint32_t index);
+
+int
+main(int argc, char *argv[])
+{
+    if (argc != 7) {
+        _usage_print();
+
+        return 1;
+    }
+
+    const uint32_t frame_count = _count_parse(argv[1]);
+    const uint32_t frame_sector_count = _count_parse(argv[2]);
+    const uint32_t chunk_count = _count_parse(argv[3]);
+    const uint32_t chunk_sector_count = _count_parse(argv[4]);
+
+    if ((frame_count == 0) || (frame_sector_count == 0) ||
+        (chunk_count == 0) || (chunk_sector_count == 0)) {
+        _usage_print();
+
+        return 1;
+    }
+
+    const size_t frame_size = frame_sector_count * SECTOR_SIZE;
+    const size_t chunk_size = chunk_sector_count * SECTOR_SIZE;
+
+    uint8_t * const video = malloc(frame_count * frame_size);
+    uint8_t * const audio = malloc(chunk_count * chunk_size);
+
+    if ((video == NULL) || (audio == NULL)) {
+        _error_print("%s\n", strerror(ENOMEM));
+
+        return 1;
+    }
+
+    for (uint32_t i = 0; i < frame_count; i++) {
+        uint8_t * const frame = &video[i * frame_size];
+
+        for (size_t offset = 0; offset < frame_size; offset++) {
+            const uint32_t x = offset % BITMAP_WIDTH;
+
+            frame[offset] = 1 + (((x / 8) + i) % PALETTE_COLOR_COUNT);
+        }
+
+        _marker_write(frame, VIDEO_TAG, i);
+    }
+
+    for (uint32_t j = 0; j < chunk_count; j++) {
+        uint8_t * const chunk = &audio[j * chunk_size];
+
+        for (size_t offset = 0; offset < chunk_size; offset += 2) {
+            const uint32_t phase = (offset / 2) % TRIANGLE_PERIOD;
+            const uint32_t half_period = TRIANGLE_PERIOD / 2;
+
+            const int32_t level = (phase < half_period)
+                ? (int32_t)phase
+                : (int32_t)(TRIANGLE_PERIOD - phase);
+            const int16_t sample =
+                ((level * 0x7FFF) / (int32_t)half_period) - 0x4000;
+
+            chunk[offset] = (uint16_t)sample >> 8;
+            chunk[offset + 1] = (uint16_t)sample & 0xFF;
+        }
+
+        _marker_write(chunk, AUDIO_TAG, j);
+    }
+
+    int ret;
+
+    ret = _file_write(argv[5], video, frame_count * frame_size);
+
+    if (ret == 0) {
+        ret = _file_write(argv[6], audio, chunk_count * chunk_size);
+    }
+
+    free(video);
+    free(audio);
+
+    return ret;
+}
+
+static void
+_usage_print(void)
+{
+    (void)fprintf(stderr,
+            "Usage: %s frame-count frame-sectors chunk-count chunk-sectors video-file audio-file\n",
+            PROGNAME);
+}
+
+static void
+_error_print(const char *fmt, ...)
+{
+    va_list ap;
+
+    va_start(ap, fmt);
+
+    (void)fprintf(stderr, "Error: %s: ", PROGNAME);
+    (void)vfprintf(stderr, fmt, ap);
+
+    va_end(ap);
+}
+
+static uint32_t
+_count_parse(const char *arg)
+{
+    char *end;
+
+    const unsigned long value = strtoul(arg, &end, 0);
+
+    if ((*arg == '\0') || (*end != '\0')) {
+        return 0;
+    }
+
+    return value;
+}
+
+static int
+_file_write(const char *filename, const uint8_t *buffer, size_t size)
+{
+    FILE *fp;
+
+    if ((fp = fopen(filename, "wb")) == NULL) {
+        _error_print("%s: %s\n", filename, strerror(errno));
+
+        return 1;
+    }
+
+    if ((fwrite(buffer, 1, size, fp)) != size) {
+        _error_print("%s: %s\n", filename, strerror(errno));
+
+        (void)fclose(fp);
+
+        return 1;
+    }
+
+    (void)fclose(fp);
+
+    return 0;
+}
+
+static void
+_marker_write(uint8_t *p, uint8_t tag, uint32_t index)
+{
+    p[0] = tag;
+    p[1] = (index >> 16) & 0xFF;
+    p[2] = (index >> 8) & 0xFF;
+    p[3] = index & 0xFF;
+}
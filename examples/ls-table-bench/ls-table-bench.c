@@ -0,0 +1,265 @@
+/*
+ * Copyright (c) Israel Jacquez
+ * See LICENSE for details.
+ *
+ * Israel Jacquez <mrkotfw@gmail.com>
+ */
+
+/* Measures the CPU cost of building and syncing a full 224-line line scroll
+ * table every frame.
+ *
+ * Each entry holds a horizontal scroll, a vertical scroll, and a horizontal
+ * coordinate increment. Both the sine wobble and the perspective floor
+ * generators are timed every frame, and the one on display switches every few
+ * seconds. The time taken is read from the CPU-FRT, with interrupts left
+ * enabled, as they would be in a game */
+
+#include <yaul.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define LINE_COUNT       (224)
+#define LS_TYPE          (VDP2_SCRN_LS_TYPE_HORZ |                             \
+                          VDP2_SCRN_LS_TYPE_VERT |                             \
+                          VDP2_SCRN_LS_TYPE_ZOOM_HORZ)
+
+#define BITMAP_WIDTH     (512)
+#define BITMAP_HEIGHT    (256)
+#define CHECKER_SIZE     (16)
+
+#define BITMAP           VDP2_VRAM_ADDR(0, 0x000000)
+#define LS_TABLE         VDP2_VRAM_ADDR(2, 0x000000)
+#define PALETTE          VDP2_CRAM_MODE_0_OFFSET(1, 0, 0)
+#define BACK_SCRN        VDP2_VRAM_ADDR(3, 0x01FFFE)
+
+#define EFFECT_PERIOD    (300)
+
+/* The CPU-FRT counts every 8 CPU cycles */
+#define FRT_TICK_CYCLES  (8)
+/* FRT ticks in a 60Hz frame at the 28.64MHz (NTSC) CPU clock */
+#define FRT_FRAME_TICKS  (59659)
+
+typedef enum {
+    BENCH_WOBBLE,
+    BENCH_FLOOR,
+    BENCH_SYNC,
+    BENCH_COUNT
+} bench_t;
+
+typedef struct {
+    uint32_t last;
+    uint32_t max;
+    uint32_t total;
+} bench_stats_t;
+
+static vdp2_scrn_ls_table_t _ls_table;
+static uint8_t _ls_buffer[VDP2_SCRN_LS_TABLE_SIZE(LS_TYPE, LINE_COUNT)] __aligned(4);
+
+static bench_stats_t _stats[BENCH_COUNT];
+static uint32_t _frames;
+
+static void _bitmap_fill(void);
+
+static void _wobble_build(void);
+static void _floor_build(void);
+
+static void _bench_add(bench_t bench, uint32_t ticks);
+static void _stats_print(bench_t displayed);
+
+int
+main(void)
+{
+    dbgio_dev_default_init(DBGIO_DEV_VDP2_ASYNC);
+    dbgio_dev_font_load();
+
+    _bitmap_fill();
+
+    const vdp2_scrn_ls_format_t ls_format = {
+        .scroll_screen = VDP2_SCRN_NBG0,
+        .table_base    = LS_TABLE,
+        .interval      = 0,
+        .type          = LS_TYPE
+    };
+
+    vdp2_scrn_ls_table_init(&_ls_table, &ls_format, LINE_COUNT, _ls_buffer);
+
+    while (true) {
+        const bench_t displayed = ((_frames / EFFECT_PERIOD) & 1)
+            ? BENCH_FLOOR
+            : BENCH_WOBBLE;
+
+        uint32_t start_ticks;
+
+        /* The generator on display runs last, so that its table is the one
+         * that gets synced */
+        if (displayed == BENCH_WOBBLE) {
+            start_ticks = vdp_sync_ticks_get();
+            _floor_build();
+            _bench_add(BENCH_FLOOR, vdp_sync_ticks_get() - start_ticks);
+
+            start_ticks = vdp_sync_ticks_get();
+            _wobble_build();
+            _bench_add(BENCH_WOBBLE, vdp_sync_ticks_get() - start_ticks);
+        } else {
+            start_ticks = vdp_sync_ticks_get();
+            _wobble_build();
+            _bench_add(BENCH_WOBBLE, vdp_sync_ticks_get() - start_ticks);
+
+            start_ticks = vdp_sync_ticks_get();
+            _floor_build();
+            _bench_add(BENCH_FLOOR, vdp_sync_ticks_get() - start_ticks);
+        }
+
+        start_ticks = vdp_sync_ticks_get();
+        vdp2_scrn_ls_table_sync(&_ls_table);
+        _bench_add(BENCH_SYNC, vdp_sync_ticks_get() - start_ticks);
+
+        _frames++;
+
+        _stats_print(displayed);
+
+        dbgio_flush();
+
+        vdp2_sync();
+        vdp2_sync_wait();
+    }
+}
+
+void
+user_init(void)
+{
+    const vdp2_scrn_bitmap_format_t bitmap_format = {
+        .scroll_screen = VDP2_SCRN_NBG0,
+        .ccc           = VDP2_SCRN_CCC_PALETTE_256,
+        .bitmap_size   = VDP2_SCRN_BITMAP_SIZE_512X256,
+        .palette_base  = PALETTE,
+        .bitmap_base   = BITMAP
+    };
+
+    vdp2_scrn_bitmap_format_set(&bitmap_format);
+    vdp2_scrn_priority_set(VDP2_SCRN_NBG0, 6);
+    vdp2_scrn_display_set(VDP2_SCRN_DISP_NBG0);
+
+    /* A 256-color bitmap takes two accesses per bank */
+    const vdp2_vram_cycp_bank_t cycp_bank = {
+        .t0 = VDP2_VRAM_CYCP_CHPNDR_NBG0,
+        .t1 = VDP2_VRAM_CYCP_CHPNDR_NBG0,
+        .t2 = VDP2_VRAM_CYCP_CPU_RW,
+        .t3 = VDP2_VRAM_CYCP_CPU_RW,
+        .t4 = VDP2_VRAM_CYCP_CPU_RW,
+        .t5 = VDP2_VRAM_CYCP_CPU_RW,
+        .t6 = VDP2_VRAM_CYCP_CPU_RW,
+        .t7 = VDP2_VRAM_CYCP_CPU_RW
+    };
+
+    vdp2_vram_cycp_bank_set(VDP2_VRAM_BANK_A0, &cycp_bank);
+
+    rgb1555_t * const palette = (rgb1555_t *)PALETTE;
+
+    palette[1] = RGB1555(1, 31, 31, 31);
+    palette[2] = RGB1555(1, 8, 12, 24);
+
+    vdp2_tvmd_display_res_set(VDP2_TVMD_INTERLACE_NONE, VDP2_TVMD_HORZ_NORMAL_A,
+        VDP2_TVMD_VERT_224);
+
+    vdp2_scrn_back_color_set(BACK_SCRN, RGB1555(1, 0, 0, 0));
+
+    vdp2_tvmd_display_set();
+}
+
+static void
+_bitmap_fill(void)
+{
+    uint8_t * const bitmap = (uint8_t *)BITMAP;
+
+    for (uint32_t y = 0; y < BITMAP_HEIGHT; y++) {
+        for (uint32_t x = 0; x < BITMAP_WIDTH; x++) {
+            const uint32_t checker = ((x / CHECKER_SIZE) + (y / CHECKER_SIZE)) & 1;
+
+            bitmap[(y * BITMAP_WIDTH) + x] = 1 + checker;
+        }
+    }
+}
+
+static void
+_wobble_build(void)
+{
+    const vdp2_scrn_wobble_t wobble = {
+        .scroll = {
+            .x = FIX16(0.0),
+            .y = fix16_int32_from(_frames)
+        },
+        .amplitude = FIX16(24.0),
+        .frequency = DEG2ANGLE(4.0),
+        .phase     = _frames * DEG2ANGLE(3.0)
+    };
+
+    vdp2_scrn_ls_table_wobble_build(&_ls_table, &wobble);
+}
+
+static void
+_floor_build(void)
+{
+    const vdp2_scrn_floor_t floor = {
+        .position = {
+            .x = fix16_int32_from(_frames),
+            .y = fix16_int32_from(_frames * 2)
+        },
+        .height   = FIX16(48.0),
+        .distance = FIX16(128.0),
+        .horizon  = 64,
+        .width    = 320
+    };
+
+    vdp2_scrn_ls_table_floor_build(&_ls_table, &floor);
+}
+
+static void
+_bench_add(bench_t bench, uint32_t ticks)
+{
+    bench_stats_t * const stats = &_stats[bench];
+
+    stats->last = ticks;
+    stats->total += ticks;
+
+    if (ticks > stats->max) {
+        stats->max = ticks;
+    }
+}
+
+static void
+_stats_print(bench_t displayed)
+{
+    static const char * const bench_names[] = {
+        "Wobble build",
+        "Floor build",
+        "Sync"
+    };
+
+    dbgio_printf("\e[H\e[2J"
+                 "%i-line table, 12 bytes per line\n"
+                 "Showing: %s\n"
+                 "Frames:  %lu\n"
+                 "\n"
+                 "              cycles  avg cycles  max cycles  %%frame\n",
+        LINE_COUNT,
+        bench_names[displayed],
+        _frames);
+
+    for (uint32_t bench = 0; bench < BENCH_COUNT; bench++) {
+        const bench_stats_t * const stats = &_stats[bench];
+
+        const uint32_t average = stats->total / _frames;
+        /* Hundredths of a percent of the frame */
+        const uint32_t frame_10000 = (average * 10000) / FRT_FRAME_TICKS;
+
+        dbgio_printf("%-12s  %6lu  %10lu  %10lu  %2lu.%02lu\n",
+            bench_names[bench],
+            stats->last * FRT_TICK_CYCLES,
+            average * FRT_TICK_CYCLES,
+            stats->max * FRT_TICK_CYCLES,
+            frame_10000 / 100,
+            frame_10000 % 100);
+    }
+}
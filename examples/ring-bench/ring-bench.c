@@ -0,0 +1,235 @@
+/*
+ * Copyright (c) Israel Jacquez
+ * See LICENSE for details.
+ *
+ * Israel Jacquez <mrkotfw@gmail.com>
+ */
+
+/* Measures the throughput of a ring buffer from the master CPU to the slave
+ * CPU.
+ *
+ * The master CPU pushes a fixed number of 16-byte messages in batches, and the
+ * slave CPU drains the ring from its ICI entry handler, which only runs when a
+ * push finds the ring empty. The time is taken from the first push until the
+ * slave CPU has popped the last message. The slave CPU checks the sequence
+ * number of every message, so a lost, repeated, or reordered message shows up
+ * as an error.
+ *
+ * The single-producer ring is measured at a few batch sizes. The
+ * multi-producer ring is measured with the master CPU as its only producer,
+ * which isolates the cost of taking the lock */
+
+#include <yaul.h>
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define MESSAGE_COUNT    (8192)
+#define RING_COUNT       (64)
+#define BATCH_COUNT_MAX  (32)
+
+#define RING_LOCK        (0)
+
+/* The CPU-FRT counts every 8 CPU cycles */
+#define FRT_TICK_CYCLES  (8)
+/* FRT ticks per second at the 28.64MHz (NTSC) CPU clock, divided by 1024 */
+#define FRT_TICKS_PER_KIB_SECOND (3496)
+
+typedef struct {
+    uint32_t sequence;
+    uint32_t value;
+    uint32_t reserved[2];
+} message_t;
+
+static_assert(sizeof(message_t) == 16);
+
+typedef struct {
+    const char *name;
+    cpu_ring_flags_t flags;
+    uint32_t batch_count;
+} run_t;
+
+typedef struct {
+    uint32_t ticks;
+    uint32_t notifications;
+    uint32_t errors;
+} result_t;
+
+static const run_t _runs[] = {
+    {
+        .name        = "SPSC x1",
+        .flags       = CPU_RING_FLAG_NOTIFY,
+        .batch_count = 1
+    }, {
+        .name        = "SPSC x8",
+        .flags       = CPU_RING_FLAG_NOTIFY,
+        .batch_count = 8
+    }, {
+        .name        = "SPSC x32",
+        .flags       = CPU_RING_FLAG_NOTIFY,
+        .batch_count = 32
+    }, {
+        .name        = "MPSC x8",
+        .flags       = CPU_RING_FLAG_NOTIFY | CPU_RING_FLAG_MP,
+        .batch_count = 8
+    }
+};
+
+#define RUN_COUNT (sizeof(_runs) / sizeof(*_runs))
+
+static cpu_ring_t _ring;
+static message_t _ring_buffer[RING_COUNT];
+
+/* Written by the slave CPU */
+static struct {
+    volatile uint32_t popped;
+    volatile uint32_t notifications;
+    volatile uint32_t errors;
+} _slave_state __uncached;
+
+static result_t _results[RUN_COUNT];
+
+static void _run(const run_t *run, result_t *result);
+static void _results_print(void);
+
+static void _slave_entry(void);
+
+int
+main(void)
+{
+    dbgio_dev_default_init(DBGIO_DEV_VDP2_ASYNC);
+    dbgio_dev_font_load();
+
+    dbgio_printf("Running...\n");
+    dbgio_flush();
+
+    vdp2_sync();
+    vdp2_sync_wait();
+
+    cpu_dual_slave_set(_slave_entry);
+    cpu_dual_comm_mode_set(CPU_DUAL_ENTRY_ICI);
+
+    for (uint32_t i = 0; i < RUN_COUNT; i++) {
+        _run(&_runs[i], &_results[i]);
+    }
+
+    while (true) {
+        _results_print();
+
+        dbgio_flush();
+
+        vdp2_sync();
+        vdp2_sync_wait();
+    }
+}
+
+void
+user_init(void)
+{
+    vdp2_tvmd_display_res_set(VDP2_TVMD_INTERLACE_NONE, VDP2_TVMD_HORZ_NORMAL_A,
+        VDP2_TVMD_VERT_224);
+
+    vdp2_scrn_back_color_set(VDP2_VRAM_ADDR(3, 0x01FFFE),
+        RGB1555(1, 0, 3, 15));
+
+    vdp2_tvmd_display_set();
+}
+
+static void
+_run(const run_t *run, result_t *result)
+{
+    cpu_ring_init(&_ring, _ring_buffer, RING_COUNT, sizeof(message_t),
+        run->flags, RING_LOCK);
+
+    _slave_state.popped = 0;
+    _slave_state.notifications = 0;
+    _slave_state.errors = 0;
+
+    message_t messages[BATCH_COUNT_MAX];
+
+    uint32_t sequence;
+    sequence = 0;
+
+    const uint32_t start_ticks = vdp_sync_ticks_get();
+
+    while (sequence < MESSAGE_COUNT) {
+        const uint32_t count = run->batch_count;
+
+        for (uint32_t i = 0; i < count; i++) {
+            messages[i].sequence = sequence + i;
+            messages[i].value = (sequence + i) * 0x9E3779B9UL;
+        }
+
+        /* When the ring is full, wait for the slave CPU to make room */
+        uint32_t pushed;
+        pushed = 0;
+
+        while (pushed < count) {
+            pushed += cpu_ring_push(&_ring, &messages[pushed], count - pushed);
+        }
+
+        sequence += count;
+    }
+
+    while (_slave_state.popped < MESSAGE_COUNT) {
+    }
+
+    result->ticks = vdp_sync_ticks_get() - start_ticks;
+    result->notifications = _slave_state.notifications;
+    result->errors = _slave_state.errors;
+}
+
+static void
+_results_print(void)
+{
+    dbgio_printf("\e[H\e[2J"
+                 "%i messages of %i bytes, ring of %i\n"
+                 "\n"
+                 "          cycles/msg   KiB/s  notifies  errors\n",
+        MESSAGE_COUNT,
+        (int)sizeof(message_t),
+        RING_COUNT);
+
+    for (uint32_t i = 0; i < RUN_COUNT; i++) {
+        const result_t * const result = &_results[i];
+
+        const uint32_t bytes = MESSAGE_COUNT * sizeof(message_t);
+        const uint32_t cycles = (result->ticks * FRT_TICK_CYCLES) / MESSAGE_COUNT;
+        const uint32_t kib_second = (result->ticks != 0)
+            ? ((bytes * FRT_TICKS_PER_KIB_SECOND) / result->ticks)
+            : 0;
+
+        dbgio_printf("%-8s  %10lu  %6lu  %8lu  %6lu\n",
+            _runs[i].name,
+            cycles,
+            kib_second,
+            result->notifications,
+            result->errors);
+    }
+}
+
+static void
+_slave_entry(void)
+{
+    message_t messages[BATCH_COUNT_MAX];
+
+    _slave_state.notifications++;
+
+    uint32_t popped;
+
+    while ((popped = cpu_ring_pop(&_ring, messages, BATCH_COUNT_MAX)) > 0) {
+        const uint32_t sequence = _slave_state.popped;
+
+        for (uint32_t i = 0; i < popped; i++) {
+            const uint32_t expected = sequence + i;
+
+            if ((messages[i].sequence != expected) ||
+                (messages[i].value != (expected * 0x9E3779B9UL))) {
+                _slave_state.errors++;
+            }
+        }
+
+        _slave_state.popped = sequence + popped;
+    }
+}
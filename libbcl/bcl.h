@@ -9,6 +9,7 @@
 #define _BCL_H_
 
 #include <sys/cdefs.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 __BEGIN_DECLS
@@ -27,6 +28,18 @@ __BEGIN_DECLS
 extern void bcl_huffman_decompress(uint8_t *in, uint8_t *out, uint32_t in_size,
     uint32_t out_size);
 
+/// @brief Decompress a block of data using canonical Huffman coding.
+///
+/// @details Decoding is table driven, and is several times faster than
+/// @ref bcl_huffman_decompress. Use `bcl_huffman -c` to compress.
+///
+/// @param[in]  in       The input buffer.
+/// @param[out] out      The output buffer.
+/// @param      in_size  The size of the input buffer in bytes.
+/// @param      out_size The size of the output buffer in bytes.
+extern void bcl_huffman_canonical_decompress(uint8_t *in, uint8_t *out,
+    uint32_t in_size, uint32_t out_size);
+
 /// @brief Decompress a block of data using PRS.
 ///
 /// @param[in]  in      The input buffer.
@@ -40,6 +53,17 @@ extern void bcl_prs_decompress(void *in, void *out);
 /// @param      in_size Size of input buffer in bytes.
 extern void bcl_lz_decompress(uint8_t *in, uint8_t *out, uint32_t in_size);
 
+/// @brief Decompress a block of data in the LZ4 block format.
+///
+/// @details Decoding is byte oriented, with no bit-serial work. See
+/// `examples/bcl-decompress` for its throughput against the other codecs. Use
+/// `bcl_lz4` to compress.
+///
+/// @param[in]  in      The input buffer.
+/// @param[out] out     The output buffer.
+/// @param      in_size The size of the input buffer in bytes.
+extern void bcl_lz4_decompress(void *in, void *out, uint32_t in_size);
+
 /// @brief Decompress a block of data using RLE.
 ///
 /// @param[in]  in      The input buffer.
@@ -47,6 +71,135 @@ extern void bcl_lz_decompress(uint8_t *in, uint8_t *out, uint32_t in_size);
 /// @param      in_size The size of the input buffer in bytes.
 extern void bcl_rle_decompress(uint8_t *in, uint8_t *out, uint32_t in_size);
 
+/// @brief Smallest history window that can hold any PRS back-reference.
+#define BCL_PRS_STREAM_WINDOW_SIZE (8192)
+
+/// @brief History window of a streaming decoder.
+typedef struct bcl_window {
+    uint8_t *buffer;
+    uint32_t mask;
+    uint32_t position;
+} bcl_window_t;
+
+/// @brief Streaming LZ77 decoder context.
+///
+/// @details Do not access the fields directly.
+typedef struct bcl_lz_stream {
+    bcl_window_t window;
+
+    /// Chunk being consumed.
+    const uint8_t *in;
+    uint32_t in_size;
+    /// Compressed bytes not yet fed.
+    uint32_t in_left;
+
+    uint8_t state;
+    uint8_t marker;
+    uint32_t value;
+    uint32_t length;
+
+    uint32_t copy_length;
+    uint32_t copy_distance;
+} bcl_lz_stream_t;
+
+/// @brief Streaming PRS decoder context.
+///
+/// @details Do not access the fields directly.
+typedef struct bcl_prs_stream {
+    bcl_window_t window;
+
+    /// Chunk being consumed.
+    const uint8_t *in;
+    uint32_t in_size;
+
+    uint8_t state;
+    uint8_t control;
+    uint8_t control_bits;
+    uint8_t value;
+
+    uint32_t copy_length;
+    uint32_t copy_distance;
+} bcl_prs_stream_t;
+
+/// @brief Initialize a streaming LZ77 decoder.
+///
+/// @details The window must be at least as large as the largest offset used
+/// by the compressor (see the `max-offset` argument of `bcl_lz`).
+///
+/// @param[out] stream      The decoder context.
+/// @param      window      The history window.
+/// @param      window_size The size of the window in bytes. Must be a power of
+///                         two.
+/// @param      in_size     The size of the whole compressed input in bytes.
+extern void bcl_lz_stream_init(bcl_lz_stream_t *stream, void *window,
+    uint32_t window_size, uint32_t in_size);
+
+/// @brief Hand the next chunk of compressed input to the decoder.
+///
+/// @details The chunk is not copied, so it must remain valid until
+/// @ref bcl_lz_stream_input_needed returns `true`. Anything past the end of the
+/// compressed input is ignored, so whole sectors can be fed.
+///
+/// @param      stream The decoder context.
+/// @param[in]  in     The chunk.
+/// @param      size   The size of the chunk in bytes.
+extern void bcl_lz_stream_feed(bcl_lz_stream_t *stream, const void *in,
+    uint32_t size);
+
+/// @brief Decompress as much as possible into @p out.
+///
+/// @param      stream The decoder context.
+/// @param[out] out    The output chunk.
+/// @param      size   The size of the output chunk in bytes.
+///
+/// @returns The number of bytes written to @p out. Fewer than @p size bytes
+/// are written only when the decoder needs more input, or is done.
+extern uint32_t bcl_lz_stream_drain(bcl_lz_stream_t *stream, void *out,
+    uint32_t size);
+
+/// @brief Determine if the decoder has consumed the chunk that was fed.
+extern bool bcl_lz_stream_input_needed(const bcl_lz_stream_t *stream);
+
+/// @brief Determine if all of the output has been drained.
+extern bool bcl_lz_stream_done(const bcl_lz_stream_t *stream);
+
+/// @brief Initialize a streaming PRS decoder.
+///
+/// @param[out] stream      The decoder context.
+/// @param      window      The history window.
+/// @param      window_size The size of the window in bytes. Must be a power of
+///                         two, and at least @ref BCL_PRS_STREAM_WINDOW_SIZE.
+extern void bcl_prs_stream_init(bcl_prs_stream_t *stream, void *window,
+    uint32_t window_size);
+
+/// @brief Hand the next chunk of compressed input to the decoder.
+///
+/// @details The chunk is not copied, so it must remain valid until
+/// @ref bcl_prs_stream_input_needed returns `true`.
+///
+/// @param      stream The decoder context.
+/// @param[in]  in     The chunk.
+/// @param      size   The size of the chunk in bytes.
+extern void bcl_prs_stream_feed(bcl_prs_stream_t *stream, const void *in,
+    uint32_t size);
+
+/// @brief Decompress as much as possible into @p out.
+///
+/// @param      stream The decoder context.
+/// @param[out] out    The output chunk.
+/// @param      size   The size of the output chunk in bytes.
+///
+/// @returns The number of bytes written to @p out. Fewer than @p size bytes
+/// are written only when the decoder needs more input, or is done.
+extern uint32_t bcl_prs_stream_drain(bcl_prs_stream_t *stream, void *out,
+    uint32_t size);
+
+/// @brief Determine if the decoder has consumed the chunk that was fed.
+extern bool bcl_prs_stream_input_needed(const bcl_prs_stream_t *stream);
+
+/// @brief Determine if all of the output has been drained.
+extern bool bcl_prs_stream_done(const bcl_prs_stream_t *stream);
+
 /// @}
 
 __END_DECLS
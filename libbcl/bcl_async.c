@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) Israel Jacquez
+ * See LICENSE for details.
+ *
+ * Israel Jacquez <mrkotfw@gmail.com>
+ */
+
+#include <assert.h>
+#include <stddef.h>
+
+#include <cpu/cache.h>
+#include <cpu/dual.h>
+
+#include "bcl.h"
+#include "bcl_async.h"
+
+/* Purging line by line costs a write per 16 bytes, so past the size of the
+ * cache, purging the whole cache is cheaper */
+#define PURGE_AREA_MAX (4096)
+
+/* Requests in flight, in submission order. Only ever touched by the master
+ * CPU */
+static struct {
+    bcl_async_request_t *head;
+    bcl_async_request_t *tail;
+    uint32_t count;
+} _state;
+
+static void _job(cpu_job_t *job, void *work);
+
+static void _area_purge(void *address, uint32_t len);
+static void _head_deliver(void);
+
+int
+bcl_async_submit(bcl_async_request_t *request, bcl_codec_t codec, void *in,
+    uint32_t in_size, void *out, uint32_t out_size,
+    bcl_async_callback_t callback, void *work)
+{
+    assert(request != NULL);
+    assert(in != NULL);
+    assert(out != NULL);
+    assert(codec <= BCL_CODEC_LZ4);
+    assert(cpu_dual_executor_get() == CPU_MASTER);
+
+    request->codec = codec;
+    request->in = in;
+    request->out = out;
+    request->in_size = in_size;
+    request->out_size = out_size;
+    request->callback = callback;
+    request->work = work;
+    request->next = NULL;
+
+    /* The request itself is the work area, so it's purged from the cache of
+     * the slave CPU before the job is run */
+    cpu_job_create(&request->job, _job, request, sizeof(bcl_async_request_t),
+        NULL);
+
+    if ((cpu_job_submit(&request->job)) < 0) {
+        return -1;
+    }
+
+    if (_state.tail == NULL) {
+        _state.head = request;
+    } else {
+        _state.tail->next = request;
+    }
+
+    _state.tail = request;
+    _state.count++;
+
+    return 0;
+}
+
+uint32_t
+bcl_async_poll(void)
+{
+    assert(cpu_dual_executor_get() == CPU_MASTER);
+
+    while ((_state.head != NULL) && (cpu_job_done(&_state.head->job))) {
+        _head_deliver();
+    }
+
+    return _state.count;
+}
+
+bool
+bcl_async_done(const bcl_async_request_t *request)
+{
+    assert(request != NULL);
+
+    return cpu_job_done(&request->job);
+}
+
+void
+bcl_async_wait(bcl_async_request_t *request)
+{
+    assert(request != NULL);
+    assert(cpu_dual_executor_get() == CPU_MASTER);
+
+    while (_state.head != NULL) {
+        bcl_async_request_t * const head = _state.head;
+
+        cpu_job_wait(&head->job);
+
+        _head_deliver();
+
+        if (head == request) {
+            break;
+        }
+    }
+}
+
+static void
+_job(cpu_job_t *job __unused, void *work)
+{
+    bcl_async_request_t * const request = work;
+
+    /* The slave CPU may hold stale lines of either buffer from a previous
+     * use. Back-references read the output buffer, so it has to be purged as
+     * well */
+    if ((cpu_dual_executor_get()) == CPU_SLAVE) {
+        _area_purge(request->in, request->in_size);
+        _area_purge(request->out, request->out_size);
+    }
+
+    switch (request->codec) {
+    case BCL_CODEC_LZ:
+        bcl_lz_decompress(request->in, request->out, request->in_size);
+        break;
+    case BCL_CODEC_PRS:
+        bcl_prs_decompress(request->in, request->out);
+        break;
+    case BCL_CODEC_RLE:
+        bcl_rle_decompress(request->in, request->out, request->in_size);
+        break;
+    case BCL_CODEC_HUFFMAN:
+        bcl_huffman_decompress(request->in, request->out, request->in_size,
+            request->out_size);
+        break;
+    case BCL_CODEC_HUFFMAN_CANONICAL:
+        bcl_huffman_canonical_decompress(request->in, request->out,
+            request->in_size, request->out_size);
+        break;
+    case BCL_CODEC_LZ4:
+        bcl_lz4_decompress(request->in, request->out, request->in_size);
+        break;
+    }
+
+    /* The cache is write-through, so the output is already in HWRAM */
+}
+
+static void
+_area_purge(void *address, uint32_t len)
+{
+    if (len > PURGE_AREA_MAX) {
+        cpu_cache_purge();
+    } else {
+        cpu_cache_area_purge(address, len);
+    }
+}
+
+static void
+_head_deliver(void)
+{
+    bcl_async_request_t * const request = _state.head;
+
+    _state.head = request->next;
+
+    if (_state.head == NULL) {
+        _state.tail = NULL;
+    }
+
+    _state.count--;
+
+    /* The output was likely written by the slave CPU, so the master CPU can't
+     * trust whatever it has cached of it */
+    _area_purge(request->out, request->out_size);
+
+    if (request->callback != NULL) {
+        request->callback(request, request->work);
+    }
+}
@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) Israel Jacquez
+ * See LICENSE for details.
+ *
+ * Israel Jacquez <mrkotfw@gmail.com>
+ */
+
+#ifndef _BCL_ASYNC_H_
+#define _BCL_ASYNC_H_
+
+#include <sys/cdefs.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <cpu/job.h>
+
+__BEGIN_DECLS
+
+/// @defgroup BCL_ASYNC BCL Asynchronous Decompression
+///
+/// @details Decompress on the slave CPU while the master CPU carries on.
+///
+/// Each request is submitted as a job (see @ref CPU_JOB), so
+/// @ref cpu_job_init must be called first. The slave CPU steals the job from
+/// the deque of the master CPU, and the master CPU only decompresses itself
+/// when it ends up waiting on a request via @ref bcl_async_wait.
+///
+/// Requests are only to be submitted, polled, and waited on from the master
+/// CPU. Callbacks are called from the master CPU, within @ref bcl_async_poll
+/// or @ref bcl_async_wait.
+///
+/// Cache rules:
+///
+/// - Before decompressing on the slave CPU, the input and output buffers are
+///   purged from the cache of the slave CPU.
+/// - Before the callback is called, the output buffer is purged from the cache
+///   of the master CPU.
+/// - Neither buffer is to be touched while the request is in flight.
+
+/// @addtogroup BCL_ASYNC
+/// @{
+
+/// @brief Codec used by a request.
+typedef enum bcl_codec {
+    /// @brief See @ref bcl_lz_decompress.
+    BCL_CODEC_LZ,
+    /// @brief See @ref bcl_prs_decompress.
+    BCL_CODEC_PRS,
+    /// @brief See @ref bcl_rle_decompress.
+    BCL_CODEC_RLE,
+    /// @brief See @ref bcl_huffman_decompress.
+    BCL_CODEC_HUFFMAN,
+    /// @brief See @ref bcl_huffman_canonical_decompress.
+    BCL_CODEC_HUFFMAN_CANONICAL,
+    /// @brief See @ref bcl_lz4_decompress.
+    BCL_CODEC_LZ4
+} bcl_codec_t;
+
+/// @brief Not yet documented.
+typedef struct bcl_async_request bcl_async_request_t;
+
+/// @brief Completion callback.
+///
+/// @param request The finished request.
+/// @param work    The work pointer passed to @ref bcl_async_submit.
+typedef void (*bcl_async_callback_t)(bcl_async_request_t *request, void *work);
+
+/// @brief Request.
+///
+/// @details Use @ref bcl_async_submit to initialize. The fields are private.
+/// The request must outlive the decompression, and may not be resubmitted
+/// before its callback is called.
+struct bcl_async_request {
+    cpu_job_t job;
+    bcl_codec_t codec;
+    void *in;
+    void *out;
+    uint32_t in_size;
+    uint32_t out_size;
+    bcl_async_callback_t callback;
+    void *work;
+    bcl_async_request_t *next;
+};
+
+/// @brief Submit a request to be decompressed on the slave CPU.
+///
+/// @param[out] request  The request.
+/// @param      codec    The codec.
+/// @param[in]  in       The input buffer.
+/// @param      in_size  The size of the input buffer in bytes.
+/// @param[out] out      The output buffer.
+/// @param      out_size The size of the output buffer in bytes. Only used by
+///                      @ref BCL_CODEC_HUFFMAN and
+///                      @ref BCL_CODEC_HUFFMAN_CANONICAL, but is always used to
+///                      purge the output buffer.
+/// @param      callback The completion callback. Can be `NULL`.
+/// @param      work     Passed to @p callback.
+///
+/// @returns `0` on success, or `-1` if the job deque is full, in which case the
+/// request is not submitted.
+extern int bcl_async_submit(bcl_async_request_t *request, bcl_codec_t codec,
+    void *in, uint32_t in_size, void *out, uint32_t out_size,
+    bcl_async_callback_t callback, void *work);
+
+/// @brief Call the callbacks of the requests that have finished.
+///
+/// @details Callbacks are called in submission order. A request that finished
+/// early is held back until the requests submitted before it have finished.
+///
+/// @returns The number of requests still in flight.
+extern uint32_t bcl_async_poll(void);
+
+/// @brief Determine if a request has finished decompressing.
+///
+/// @details The callback may not have been called yet.
+///
+/// @param request The request.
+///
+/// @returns `true` if finished, otherwise `false`.
+extern bool bcl_async_done(const bcl_async_request_t *request);
+
+/// @brief Wait for a request to finish, then call the callbacks of it and of
+/// every request submitted before it.
+///
+/// @details While waiting, the master CPU helps out by decompressing requests
+/// the slave CPU has not yet picked up.
+///
+/// @param request The request.
+extern void bcl_async_wait(bcl_async_request_t *request);
+
+/// @}
+
+__END_DECLS
+
+#endif /* _BCL_ASYNC_H_ */
@@ -1,12 +1,27 @@
 # -*- mode: makefile -*-
 
-LIB_SRCS:= huffman.c \
+LIB_SRCS:= bcl_async.c \
+	huffman.c \
+	huffman_canonical.c \
+	lz4.c \
+	lz_stream.c \
+	prs_stream.c
+
+ifeq ($(strip $(YAUL_OPTION_BCL_DECOMPRESS_IMPL)),sh2)
+LIB_SRCS+= \
+	lz_sh2.sx \
+	prs_sh2.sx \
+	rle_sh2.sx
+else
+LIB_SRCS+= \
 	lz.c \
 	prs.c \
 	rle.c
+endif
 
 INSTALL_HEADER_FILES:= \
-	./:bcl.h:./bcl/
+	./:bcl.h:./bcl/ \
+	./:bcl_async.h:./bcl/
 
 USER_FILES:= \
 	build/build.bcl.mk
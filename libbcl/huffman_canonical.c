@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) Israel Jacquez
+ * See LICENSE for details.
+ *
+ * Israel Jacquez <mrkotfw@gmail.com>
+ */
+
+/* Canonical Huffman decoder. The stream starts with a 4-bit code length for
+ * each of the 256 symbols, which is enough to rebuild the codes. Codes of up
+ * to TABLE_BITS bits are decoded with a single table look up, and the rare
+ * longer codes are decoded canonically, one length at a time */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "bcl.h"
+
+#define MAX_BITS     (15)
+#define TABLE_BITS   (9)
+#define HEADER_SIZE  (128)
+
+void
+bcl_huffman_canonical_decompress(uint8_t *in, uint8_t *out, uint32_t in_size,
+    uint32_t out_size)
+{
+    /* Each entry is the symbol in the upper byte, and the code length in the
+     * lower. An empty entry means the code is longer than TABLE_BITS */
+    uint16_t table[1 << TABLE_BITS];
+    uint8_t symbols[256];
+    uint16_t counts[MAX_BITS + 1];
+    uint16_t first_codes[MAX_BITS + 1];
+    uint16_t first_indices[MAX_BITS + 1];
+    uint16_t indices[MAX_BITS + 1];
+
+    /* Do we have anything to decompress? */
+    if (in_size <= HEADER_SIZE) {
+        return;
+    }
+
+    (void)memset(counts, 0, sizeof(counts));
+
+    for (uint32_t i = 0; i < HEADER_SIZE; i++) {
+        counts[in[i] >> 4]++;
+        counts[in[i] & 0x0F]++;
+    }
+
+    counts[0] = 0;
+
+    /* Symbols are sorted by code length, then by value */
+    uint32_t code;
+    code = 0;
+
+    uint32_t index;
+    index = 0;
+
+    for (uint32_t length = 1; length <= MAX_BITS; length++) {
+        first_codes[length] = code;
+        first_indices[length] = index;
+        indices[length] = index;
+
+        code = (code + counts[length]) << 1;
+        index += counts[length];
+    }
+
+    for (uint32_t symbol = 0; symbol < 256; symbol++) {
+        const uint32_t length = (symbol & 1)
+            ? (in[symbol >> 1] & 0x0F)
+            : (in[symbol >> 1] >> 4);
+
+        if (length > 0) {
+            symbols[indices[length]++] = symbol;
+        }
+    }
+
+    (void)memset(table, 0, sizeof(table));
+
+    for (uint32_t length = 1; length <= TABLE_BITS; length++) {
+        const uint32_t fill_count = 1 << (TABLE_BITS - length);
+
+        for (uint32_t i = 0; i < counts[length]; i++) {
+            const uint16_t entry =
+                (symbols[first_indices[length] + i] << 8) | length;
+
+            uint16_t *table_ptr;
+            table_ptr = &table[(first_codes[length] + i) << (TABLE_BITS - length)];
+
+            for (uint32_t j = 0; j < fill_count; j++) {
+                *table_ptr++ = entry;
+            }
+        }
+    }
+
+    const uint8_t *in_ptr;
+    in_ptr = in + HEADER_SIZE;
+
+    const uint8_t * const in_end = in + in_size;
+
+    /* Bits are consumed from the most significant end */
+    uint32_t bits;
+    bits = 0;
+
+    int32_t bit_count;
+    bit_count = 0;
+
+    for (uint32_t k = 0; k < out_size; k++) {
+        /* Only refill once the longest code might not fit */
+        if (bit_count < MAX_BITS) {
+            do {
+                const uint32_t byte = (in_ptr < in_end) ? *in_ptr++ : 0;
+
+                bits |= byte << (24 - bit_count);
+                bit_count += 8;
+            } while (bit_count <= 24);
+        }
+
+        const uint32_t entry = table[bits >> (32 - TABLE_BITS)];
+
+        uint32_t length;
+        uint32_t symbol;
+
+        if (entry != 0) {
+            length = entry & 0xFF;
+            symbol = entry >> 8;
+        } else {
+            for (length = TABLE_BITS + 1; length <= MAX_BITS; length++) {
+                const uint32_t offset =
+                    (bits >> (32 - length)) - first_codes[length];
+
+                if (offset < counts[length]) {
+                    break;
+                }
+            }
+
+            /* Not a valid code */
+            if (length > MAX_BITS) {
+                return;
+            }
+
+            symbol = symbols[first_indices[length] +
+                ((bits >> (32 - length)) - first_codes[length])];
+        }
+
+        bits <<= length;
+        bit_count -= length;
+
+        *out++ = symbol;
+    }
+}
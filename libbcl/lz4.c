@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) Israel Jacquez
+ * See LICENSE for details.
+ *
+ * Israel Jacquez <mrkotfw@gmail.com>
+ */
+
+/* Decoder for the LZ4 block format. Every field is byte aligned, and a
+ * sequence costs one token, so decoding needs no bit twiddling, and literals
+ * and non-overlapping matches are plain memcpy() calls */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "bcl.h"
+
+#define MIN_MATCH (4)
+
+static inline uint32_t __always_inline
+_length_read(const uint8_t **in_ptr, uint32_t length)
+{
+    /* A nibble of 15 is extended by bytes, until one is not 255 */
+    if (length == 15) {
+        uint32_t byte;
+
+        do {
+            byte = *(*in_ptr)++;
+            length += byte;
+        } while (byte == 255);
+    }
+
+    return length;
+}
+
+void
+bcl_lz4_decompress(void *in, void *out, uint32_t in_size)
+{
+    const uint8_t *in_ptr;
+    in_ptr = in;
+
+    const uint8_t * const in_end = in_ptr + in_size;
+
+    uint8_t *out_ptr;
+    out_ptr = out;
+
+    while (in_ptr < in_end) {
+        const uint32_t token = *in_ptr++;
+
+        const uint32_t literal_length = _length_read(&in_ptr, token >> 4);
+
+        (void)memcpy(out_ptr, in_ptr, literal_length);
+
+        in_ptr += literal_length;
+        out_ptr += literal_length;
+
+        /* The last sequence has no match */
+        if (in_ptr >= in_end) {
+            break;
+        }
+
+        const uint32_t offset = in_ptr[0] | (in_ptr[1] << 8);
+
+        in_ptr += 2;
+
+        uint32_t match_length;
+        match_length = _length_read(&in_ptr, token & 0x0F) + MIN_MATCH;
+
+        const uint8_t *match_ptr;
+        match_ptr = out_ptr - offset;
+
+        if (offset >= match_length) {
+            (void)memcpy(out_ptr, match_ptr, match_length);
+
+            out_ptr += match_length;
+        } else {
+            /* The match overlaps what it is producing, so go byte by byte */
+            do {
+                *out_ptr++ = *match_ptr++;
+            } while (--match_length != 0);
+        }
+    }
+}
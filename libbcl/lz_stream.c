@@ -0,0 +1,183 @@
+/* Copyright (c) 2003-2006 Marcus Geelnard
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim
+ *    that you wrote the original software. If you use this software in a
+ *    product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution. */
+
+/* Resumable version of bcl_lz_decompress(). The input is parsed one byte at a
+ * time, so a chunk can end anywhere, even in the middle of a length or an
+ * offset */
+
+#include <assert.h>
+#include <stddef.h>
+
+#include "bcl.h"
+#include "window.h"
+
+#define STATE_MARKER      (0)
+#define STATE_SYMBOL      (1)
+#define STATE_MARKER_NEXT (2)
+#define STATE_LENGTH      (3)
+#define STATE_OFFSET      (4)
+
+static bool _byte_get(bcl_lz_stream_t *stream, uint8_t *byte);
+
+void
+bcl_lz_stream_init(bcl_lz_stream_t *stream, void *window, uint32_t window_size,
+    uint32_t in_size)
+{
+    assert(stream != NULL);
+
+    _window_init(&stream->window, window, window_size);
+
+    stream->in = NULL;
+    stream->in_size = 0;
+    stream->in_left = in_size;
+
+    stream->state = STATE_MARKER;
+    stream->marker = 0;
+    stream->value = 0;
+    stream->length = 0;
+
+    stream->copy_length = 0;
+    stream->copy_distance = 0;
+}
+
+void
+bcl_lz_stream_feed(bcl_lz_stream_t *stream, const void *in, uint32_t size)
+{
+    assert(stream != NULL);
+    assert(in != NULL);
+    assert(stream->in_size == 0);
+
+    stream->in = in;
+    stream->in_size = (size < stream->in_left) ? size : stream->in_left;
+    stream->in_left -= stream->in_size;
+}
+
+uint32_t
+bcl_lz_stream_drain(bcl_lz_stream_t *stream, void *out, uint32_t size)
+{
+    assert(stream != NULL);
+    assert(out != NULL);
+
+    uint8_t *out_ptr;
+    out_ptr = out;
+
+    const uint8_t * const out_end = out_ptr + size;
+
+    while (out_ptr < out_end) {
+        if (stream->copy_length > 0) {
+            /* Copy corresponding data from history window */
+            out_ptr = _window_copy(&stream->window, stream->copy_distance,
+                &stream->copy_length, out_ptr, out_end);
+
+            continue;
+        }
+
+        uint8_t byte;
+
+        if (!(_byte_get(stream, &byte))) {
+            break;
+        }
+
+        switch (stream->state) {
+        case STATE_MARKER:
+            stream->marker = byte;
+            stream->state = STATE_SYMBOL;
+            break;
+        case STATE_SYMBOL:
+            if (byte == stream->marker) {
+                stream->state = STATE_MARKER_NEXT;
+            } else {
+                /* No marker, plain copy */
+                _window_put(&stream->window, byte);
+                *out_ptr++ = byte;
+            }
+            break;
+        case STATE_MARKER_NEXT:
+            if (byte == 0) {
+                /* It was a single occurrence of the marker byte */
+                _window_put(&stream->window, stream->marker);
+                *out_ptr++ = stream->marker;
+
+                stream->state = STATE_SYMBOL;
+
+                break;
+            }
+
+            /* The byte is the start of the length */
+            stream->value = 0;
+            stream->state = STATE_LENGTH;
+            /* Fall through */
+        case STATE_LENGTH:
+        case STATE_OFFSET:
+            stream->value = (stream->value << 7) | (byte & 0x7F);
+
+            /* Stop when byte contains zero in 8:th bit */
+            if ((byte & 0x80) != 0x00) {
+                break;
+            }
+
+            if (stream->state == STATE_LENGTH) {
+                stream->length = stream->value;
+
+                stream->value = 0;
+                stream->state = STATE_OFFSET;
+            } else {
+                stream->copy_length = stream->length;
+                stream->copy_distance = stream->value;
+
+                stream->state = STATE_SYMBOL;
+            }
+            break;
+        }
+    }
+
+    return (out_ptr - (uint8_t *)out);
+}
+
+bool
+bcl_lz_stream_input_needed(const bcl_lz_stream_t *stream)
+{
+    assert(stream != NULL);
+
+    return ((stream->in_size == 0) && (stream->in_left > 0));
+}
+
+bool
+bcl_lz_stream_done(const bcl_lz_stream_t *stream)
+{
+    assert(stream != NULL);
+
+    return ((stream->in_size == 0) &&
+            (stream->in_left == 0) &&
+            (stream->copy_length == 0));
+}
+
+static bool
+_byte_get(bcl_lz_stream_t *stream, uint8_t *byte)
+{
+    if (stream->in_size == 0) {
+        return false;
+    }
+
+    *byte = *stream->in++;
+    stream->in_size--;
+
+    return true;
+}
@@ -0,0 +1,203 @@
+/* Archive of the original code from fuzziqer. No license was provided with the
+ * released files, although fuzziqer stated using the source freely was fine as
+ * long as he's credited for the compression and decompression code. */
+
+/* Resumable version of bcl_prs_decompress(). Control bits and bytes are
+ * consumed in the same order, one at a time, so a chunk can end anywhere */
+
+#include <assert.h>
+#include <stddef.h>
+
+#include "bcl.h"
+#include "window.h"
+
+#define STATE_FLAG         (0)
+#define STATE_LITERAL      (1)
+#define STATE_COMMAND      (2)
+#define STATE_LONG_LOW     (3)
+#define STATE_LONG_HIGH    (4)
+#define STATE_LONG_SIZE    (5)
+#define STATE_SHORT_SIZE_1 (6)
+#define STATE_SHORT_SIZE_2 (7)
+#define STATE_SHORT_OFFSET (8)
+#define STATE_DONE         (9)
+
+static bool _byte_get(bcl_prs_stream_t *stream, uint8_t *byte);
+static bool _bit_get(bcl_prs_stream_t *stream, uint8_t *bit);
+
+void
+bcl_prs_stream_init(bcl_prs_stream_t *stream, void *window,
+    uint32_t window_size)
+{
+    assert(stream != NULL);
+    assert(window_size >= BCL_PRS_STREAM_WINDOW_SIZE);
+
+    _window_init(&stream->window, window, window_size);
+
+    stream->in = NULL;
+    stream->in_size = 0;
+
+    stream->state = STATE_FLAG;
+    stream->control = 0;
+    stream->control_bits = 0;
+    stream->value = 0;
+
+    stream->copy_length = 0;
+    stream->copy_distance = 0;
+}
+
+void
+bcl_prs_stream_feed(bcl_prs_stream_t *stream, const void *in, uint32_t size)
+{
+    assert(stream != NULL);
+    assert(in != NULL);
+    assert(stream->in_size == 0);
+
+    stream->in = in;
+    stream->in_size = size;
+}
+
+uint32_t
+bcl_prs_stream_drain(bcl_prs_stream_t *stream, void *out, uint32_t size)
+{
+    assert(stream != NULL);
+    assert(out != NULL);
+
+    uint8_t *out_ptr;
+    out_ptr = out;
+
+    const uint8_t * const out_end = out_ptr + size;
+
+    while ((out_ptr < out_end) && (stream->state != STATE_DONE)) {
+        if (stream->copy_length > 0) {
+            out_ptr = _window_copy(&stream->window, stream->copy_distance,
+                &stream->copy_length, out_ptr, out_end);
+
+            continue;
+        }
+
+        uint8_t value;
+
+        switch (stream->state) {
+        case STATE_FLAG:
+        case STATE_COMMAND:
+        case STATE_SHORT_SIZE_1:
+        case STATE_SHORT_SIZE_2:
+            if (!(_bit_get(stream, &value))) {
+                return (out_ptr - (uint8_t *)out);
+            }
+            break;
+        default:
+            if (!(_byte_get(stream, &value))) {
+                return (out_ptr - (uint8_t *)out);
+            }
+            break;
+        }
+
+        switch (stream->state) {
+        case STATE_FLAG:
+            stream->state = (value != 0) ? STATE_LITERAL : STATE_COMMAND;
+            break;
+        case STATE_LITERAL:
+            _window_put(&stream->window, value);
+            *out_ptr++ = value;
+
+            stream->state = STATE_FLAG;
+            break;
+        case STATE_COMMAND:
+            stream->state = (value != 0) ? STATE_LONG_LOW : STATE_SHORT_SIZE_1;
+            break;
+        case STATE_LONG_LOW:
+            stream->value = value;
+            stream->state = STATE_LONG_HIGH;
+            break;
+        case STATE_LONG_HIGH: {
+            const uint32_t offset = (value << 8) | stream->value;
+
+            if (offset == 0) {
+                stream->state = STATE_DONE;
+
+                break;
+            }
+
+            stream->copy_distance = 0x2000 - (offset >> 3);
+
+            if ((offset & 0x0007) == 0) {
+                stream->state = STATE_LONG_SIZE;
+            } else {
+                stream->copy_length = (offset & 0x0007) + 2;
+                stream->state = STATE_FLAG;
+            }
+        } break;
+        case STATE_LONG_SIZE:
+            stream->copy_length = value + 1;
+            stream->state = STATE_FLAG;
+            break;
+        case STATE_SHORT_SIZE_1:
+            stream->value = value << 1;
+            stream->state = STATE_SHORT_SIZE_2;
+            break;
+        case STATE_SHORT_SIZE_2:
+            stream->value |= value;
+            stream->state = STATE_SHORT_OFFSET;
+            break;
+        case STATE_SHORT_OFFSET:
+            stream->copy_distance = 0x0100 - value;
+            stream->copy_length = stream->value + 2;
+            stream->state = STATE_FLAG;
+            break;
+        }
+    }
+
+    return (out_ptr - (uint8_t *)out);
+}
+
+bool
+bcl_prs_stream_input_needed(const bcl_prs_stream_t *stream)
+{
+    assert(stream != NULL);
+
+    return ((stream->in_size == 0) && (stream->state != STATE_DONE));
+}
+
+bool
+bcl_prs_stream_done(const bcl_prs_stream_t *stream)
+{
+    assert(stream != NULL);
+
+    return ((stream->state == STATE_DONE) && (stream->copy_length == 0));
+}
+
+static bool
+_byte_get(bcl_prs_stream_t *stream, uint8_t *byte)
+{
+    if (stream->in_size == 0) {
+        return false;
+    }
+
+    *byte = *stream->in++;
+    stream->in_size--;
+
+    return true;
+}
+
+/* Control bits are read least significant bit first, with the next control
+ * byte read only once a bit is needed */
+static bool
+_bit_get(bcl_prs_stream_t *stream, uint8_t *bit)
+{
+    if (stream->control_bits == 0) {
+        if (!(_byte_get(stream, &stream->control))) {
+            return false;
+        }
+
+        stream->control_bits = 8;
+    }
+
+    *bit = stream->control & 1;
+
+    stream->control >>= 1;
+    stream->control_bits--;
+
+    return true;
+}
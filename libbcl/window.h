@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) Israel Jacquez
+ * See LICENSE for details.
+ *
+ * Israel Jacquez <mrkotfw@gmail.com>
+ */
+
+#ifndef _BCL_WINDOW_H_
+#define _BCL_WINDOW_H_
+
+#include <assert.h>
+
+#include "bcl.h"
+
+static inline void
+_window_init(bcl_window_t *window, void *buffer, uint32_t size)
+{
+    assert(buffer != NULL);
+    assert((size > 0) && ((size & (size - 1)) == 0));
+
+    window->buffer = buffer;
+    window->mask = size - 1;
+    window->position = 0;
+}
+
+static inline void
+_window_put(bcl_window_t *window, uint8_t byte)
+{
+    window->buffer[window->position] = byte;
+    window->position = (window->position + 1) & window->mask;
+}
+
+/* Copy from the window to both the window and the output, until either the
+ * copy is done or the output is full. Returns where the output stopped */
+static inline uint8_t *
+_window_copy(bcl_window_t *window, uint32_t distance, uint32_t *length,
+    uint8_t *out, const uint8_t *out_end)
+{
+    assert((distance > 0) && (distance <= (window->mask + 1)));
+
+    uint32_t from;
+    from = (window->position - distance) & window->mask;
+
+    while ((*length > 0) && (out < out_end)) {
+        const uint8_t byte = window->buffer[from];
+
+        from = (from + 1) & window->mask;
+
+        _window_put(window, byte);
+
+        *out++ = byte;
+        (*length)--;
+    }
+
+    return out;
+}
+
+#endif /* !_BCL_WINDOW_H_ */
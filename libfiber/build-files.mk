@@ -2,10 +2,14 @@
 
 LIB_SRCS:= \
 	fiber.c \
+	fiber_io.c \
+	fiber_sched.c \
+	fiber_stack_pool.c \
 	context_switch.sx
 
 INSTALL_HEADER_FILES:= \
-	./:fiber.h:./
+	./:fiber.h:./ \
+	./:fiber_io.h:./
 
 USER_FILES:= \
 	build/build.fiber.mk
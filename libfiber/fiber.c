@@ -50,6 +50,12 @@ fiber_fiber_init(fiber_t *fiber, ssize_t stack_size, fiber_entry_t entry)
         return -1;
     }
 
+    uint32_t * const stack_words = (uint32_t *)fiber->stack;
+
+    for (ssize_t i = 0; i < (fiber->size / 4); i++) {
+        stack_words[i] = FIBER_STACK_CANARY;
+    }
+
     /* Stack grows towards zero */
     fiber->reg_file.sp = (uintptr_t)&fiber->stack[fiber->size];
     /* When context switching function returns, PC is set to PR, which is
@@ -58,19 +64,69 @@ fiber_fiber_init(fiber_t *fiber, ssize_t stack_size, fiber_entry_t entry)
     fiber->reg_file.pr = (uintptr_t)entry;
     fiber->reg_file.vbr = cpu_reg_vbr_get();
 
+    fiber->next = NULL;
+    fiber->wake_frame = 0;
+    fiber->ticks = 0;
+    fiber->state = FIBER_STATE_IDLE;
+    fiber->wait_queue = NULL;
+
     return 0;
 }
 
 void
 fiber_fiber_deinit(fiber_t *fiber)
 {
-    uint32_t * const sp = &fiber->reg_file.sp;
+    if (fiber->stack != NULL) {
+        _stack_free(fiber->stack);
+
+        fiber->stack = NULL;
+        fiber->reg_file.sp = 0x00000000;
+    }
+}
+
+size_t
+fiber_stack_peak_get(const fiber_t *fiber)
+{
+    assert(fiber != NULL);
+
+    if (fiber->stack == NULL) {
+        return 0;
+    }
+
+    const uint32_t * const stack_words = (const uint32_t *)fiber->stack;
+    const ssize_t word_count = fiber->size / 4;
+
+    /* The stack grows towards zero, so the first word that isn't the canary
+     * marks the deepest point reached */
+    ssize_t i;
+
+    for (i = 0; i < word_count; i++) {
+        if (stack_words[i] != FIBER_STACK_CANARY) {
+            break;
+        }
+    }
+
+    return (word_count - i) * 4;
+}
+
+bool
+fiber_stack_overflowed(const fiber_t *fiber)
+{
+    assert(fiber != NULL);
+
+    if (fiber->stack == NULL) {
+        return false;
+    }
 
-    if (sp != NULL) {
-        _stack_free(sp);
+    const uint32_t * const stack_words = (const uint32_t *)fiber->stack;
 
-        *sp = 0x00000000;
+    for (uint32_t i = 0; i < (FIBER_STACK_GUARD_SIZE / 4); i++) {
+        if (stack_words[i] != FIBER_STACK_CANARY) {
+            return true;
+        }
     }
+
+    return false;
 }
 
 void
@@ -85,9 +141,20 @@ fiber_yield(fiber_t *to)
 
     fiber_t * const fiber_previous = _fiber_current;
 
+#if defined(DEBUG)
+    /* Catch the overflow as close as possible to where it happened */
+    assert(!fiber_stack_overflowed(fiber_previous));
+#endif /* DEBUG */
+
     _fiber_current = to;
 
     __context_switch(fiber_previous, _fiber_current);
 
     cpu_intc_mask_set(sr_mask);
 }
+
+fiber_t *
+fiber_current_get(void)
+{
+    return _fiber_current;
+}
@@ -4,25 +4,73 @@
 #include <sys/cdefs.h>
 
 #include <assert.h>
+#include <stdbool.h>
 #include <stdint.h>
 
+#include <sys/types.h>
+
 #include <cpu/registers.h>
 
 typedef struct fiber fiber_t;
 
 typedef void (*fiber_entry_t)(void);
 
+typedef enum fiber_state {
+    FIBER_STATE_IDLE,
+    FIBER_STATE_READY,
+    FIBER_STATE_SLEEPING,
+    FIBER_STATE_WAITING,
+    FIBER_STATE_DONE
+} fiber_state_t;
+
 struct fiber {
     cpu_registers_t reg_file;
     ssize_t size;
     uint8_t *stack;
+
+    /* Scheduler */
+    fiber_t *next;
+    uint32_t wake_frame;
+    uint32_t ticks;
+    fiber_state_t state;
+    /* Queue the fiber is parked on while waiting */
+    struct fiber_queue *wait_queue;
 } __aligned(16);
 
-static_assert(sizeof(fiber_t) == ((92 + 20)));
+static_assert(sizeof(fiber_t) == ((92 + 36)));
+
+/* Intrusive FIFO of fibers linked through fiber_t::next */
+typedef struct fiber_queue {
+    fiber_t *head;
+    fiber_t *tail;
+} fiber_queue_t;
+
+typedef struct fiber_event {
+    fiber_queue_t waiters;
+    bool signaled;
+} fiber_event_t;
+
+typedef struct fiber_sem {
+    fiber_queue_t waiters;
+    int32_t count;
+} fiber_sem_t;
 
 typedef void *(*fiber_stack_alloc_t)(size_t align, size_t amount);
 typedef void (*fiber_stack_free_t)(void *p);
 
+/* Stacks are filled with the canary when a fiber is initialized. The lowest
+ * FIBER_STACK_GUARD_SIZE bytes must never be touched */
+#define FIBER_STACK_CANARY     (0x5AA5C33CUL)
+#define FIBER_STACK_GUARD_SIZE (16)
+
+/* Pool of fixed-size stacks. At most 32 stacks */
+typedef struct fiber_stack_pool {
+    uint8_t *memory;
+    size_t stack_size;
+    uint32_t count;
+    uint32_t used;
+} fiber_stack_pool_t;
+
 static inline void __always_inline
 fiber_context_mac_save(fiber_t *fiber)
 {
@@ -40,9 +88,52 @@ fiber_context_mac_restore(fiber_t *fiber)
 extern void fiber_init(void);
 extern void fiber_stack_allocator_set(fiber_stack_alloc_t stack_alloc, fiber_stack_free_t stack_free);
 
+/* Initialize the pool over memory of stack_size * count bytes, and make it the
+ * stack allocator */
+extern void fiber_stack_pool_init(fiber_stack_pool_t *pool, void *memory,
+    size_t stack_size, uint32_t count);
+extern uint32_t fiber_stack_pool_free_count(const fiber_stack_pool_t *pool);
+
+/* Peak stack use in bytes, measured from the untouched canary */
+extern size_t fiber_stack_peak_get(const fiber_t *fiber);
+extern bool fiber_stack_overflowed(const fiber_t *fiber);
+
 extern int32_t fiber_fiber_init(fiber_t *fiber, ssize_t stack_size, fiber_entry_t entry);
 extern void fiber_fiber_deinit(fiber_t *fiber);
 
 extern void fiber_yield(fiber_t *to);
+extern fiber_t *fiber_current_get(void);
+
+/* Scheduler
+ *
+ * The scheduler runs on the parent fiber, and each scheduled fiber yields
+ * back to it. Call fiber_sched_run() once per frame from the main loop. It
+ * runs ready fibers until none are left, or until fiber_sched_vblank() is
+ * called, typically from the VBLANK-IN handler. None of the functions below
+ * allocate */
+extern void fiber_sched_init(void);
+extern void fiber_sched_add(fiber_t *fiber);
+extern void fiber_sched_remove(fiber_t *fiber);
+extern void fiber_sched_run(void);
+extern void fiber_sched_vblank(void *work);
+extern uint32_t fiber_sched_frame_get(void);
+
+/* Called from a scheduled fiber */
+extern void fiber_sched_yield(void);
+extern void fiber_sleep_frames(uint32_t frames);
+extern void fiber_sched_exit(void) __noreturn;
+
+/* CPU time in CPU-FRT ticks spent by the fiber since the last clear */
+extern uint32_t fiber_ticks_get(const fiber_t *fiber);
+extern void fiber_ticks_clear(fiber_t *fiber);
+
+extern void fiber_event_init(fiber_event_t *event);
+extern void fiber_event_wait(fiber_event_t *event);
+extern void fiber_event_signal(fiber_event_t *event);
+extern void fiber_event_clear(fiber_event_t *event);
+
+extern void fiber_sem_init(fiber_sem_t *sem, int32_t count);
+extern void fiber_sem_wait(fiber_sem_t *sem);
+extern void fiber_sem_post(fiber_sem_t *sem);
 
 #endif /* !_FIBER_H_ */
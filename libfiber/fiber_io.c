@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) Israel Jacquez
+ * See LICENSE for details.
+ *
+ * Israel Jacquez <mrkotfw@gmail.com>
+ */
+
+#include <cd-block.h>
+#include <cpu/cache.h>
+#include <scu/dma.h>
+#include <vdp.h>
+
+#include "fiber.h"
+#include "fiber_io.h"
+
+static fiber_event_t _cd_event;
+static fiber_event_t _dma_events[3];
+static fiber_event_t _vdp1_event;
+
+static void _event_signal(void *work);
+static int _cd_sectors_wait(void *work);
+
+void
+fiber_io_init(void)
+{
+    fiber_event_init(&_cd_event);
+    fiber_event_init(&_vdp1_event);
+
+    for (uint32_t level = 0; level < 3; level++) {
+        fiber_event_init(&_dma_events[level]);
+    }
+
+    cd_block_sector_ready_set(_event_signal, &_cd_event);
+}
+
+void
+fiber_io_vblank_wait(void)
+{
+    fiber_sleep_frames(1);
+}
+
+void
+fiber_io_scu_dma_level_start(scu_dma_level_t level)
+{
+    assert(level <= 2);
+
+    fiber_event_t * const event = &_dma_events[level];
+
+    fiber_event_clear(event);
+
+    scu_dma_level_end_set(level, _event_signal, event);
+    scu_dma_level_start(level);
+
+    fiber_event_wait(event);
+
+    scu_dma_level_end_set(level, NULL, NULL);
+}
+
+void
+fiber_io_scu_dma_transfer(scu_dma_level_t level, void *dst, const void *src,
+    size_t len)
+{
+    const scu_dma_handle_t dma_handle = {
+        .dnr = CPU_CACHE_THROUGH | (uintptr_t)src,
+        .dnw = (uintptr_t)dst,
+        .dnc = len,
+        .dnad = 0x00000101,
+        .dnmd = 0x00010100
+    };
+
+    assert(level <= 2);
+
+    scu_dma_config_set(level, SCU_DMA_START_FACTOR_ENABLE, &dma_handle, NULL);
+
+    fiber_io_scu_dma_level_start(level);
+}
+
+void
+fiber_io_vdp1_wait(void)
+{
+    fiber_event_clear(&_vdp1_event);
+
+    /* The notify callback is used, so the application's transfer over
+     * callback is left alone. Setting it before checking prevents missing a
+     * transfer over that happens in between */
+    vdp1_sync_transfer_over_notify_set(_event_signal, &_vdp1_event);
+
+    if (vdp1_sync_busy()) {
+        fiber_event_wait(&_vdp1_event);
+    }
+
+    vdp1_sync_transfer_over_notify_set(NULL, NULL);
+}
+
+int
+fiber_io_cd_sectors_read(fad_t fad, void *output_buffer, uint32_t length)
+{
+    return cd_block_sectors_read_custom(fad, output_buffer, length,
+        _cd_sectors_wait, NULL, &_cd_event);
+}
+
+static void
+_event_signal(void *work)
+{
+    fiber_event_signal(work);
+}
+
+static int
+_cd_sectors_wait(void *work)
+{
+    fiber_event_t * const event = work;
+
+    /* Park until the CD-block interrupt reports a sector, letting other
+     * fibers run in the meantime */
+    while (true) {
+        fiber_event_clear(event);
+
+        const int sectors_ready = cd_block_cmd_sector_number_get(0);
+
+        if (sectors_ready != 0) {
+            return sectors_ready;
+        }
+
+        fiber_event_wait(event);
+    }
+}
@@ -0,0 +1,28 @@
+#ifndef _FIBER_IO_H_
+#define _FIBER_IO_H_
+
+#include <sys/cdefs.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cd-block.h>
+#include <scu/dma.h>
+
+#include "fiber.h"
+
+/* Asynchronous I/O
+ *
+ * Each function parks the calling fiber until the I/O completes, and is resumed
+ * by the scheduler once the completion interrupt fires. Must be called from a
+ * scheduled fiber. Call fiber_io_init() once after cd_block_init() */
+extern void fiber_io_init(void);
+extern void fiber_io_vblank_wait(void);
+extern void fiber_io_scu_dma_level_start(scu_dma_level_t level);
+extern void fiber_io_scu_dma_transfer(scu_dma_level_t level, void *dst,
+    const void *src, size_t len);
+extern void fiber_io_vdp1_wait(void);
+extern int fiber_io_cd_sectors_read(fad_t fad, void *output_buffer,
+    uint32_t length);
+
+#endif /* !_FIBER_IO_H_ */
@@ -0,0 +1,407 @@
+/*
+ * Copyright (c) Israel Jacquez
+ * See LICENSE for details.
+ *
+ * Israel Jacquez <mrkotfw@gmail.com>
+ */
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include <cpu/intc.h>
+
+#include <vdp.h>
+
+#include "fiber.h"
+
+static fiber_queue_t _ready;
+static fiber_queue_t _sleeping;
+
+static volatile uint32_t _frame;
+static volatile bool _vblank;
+
+static void _sleepers_wake(void);
+static void _wait(fiber_queue_t *queue);
+
+static inline void __always_inline
+_queue_push(fiber_queue_t *queue, fiber_t *fiber)
+{
+    fiber->next = NULL;
+
+    if (queue->tail == NULL) {
+        queue->head = fiber;
+    } else {
+        queue->tail->next = fiber;
+    }
+
+    queue->tail = fiber;
+}
+
+static inline fiber_t * __always_inline
+_queue_pop(fiber_queue_t *queue)
+{
+    fiber_t * const fiber = queue->head;
+
+    if (fiber != NULL) {
+        queue->head = fiber->next;
+
+        if (queue->head == NULL) {
+            queue->tail = NULL;
+        }
+
+        fiber->next = NULL;
+    }
+
+    return fiber;
+}
+
+static bool
+_queue_remove(fiber_queue_t *queue, fiber_t *fiber)
+{
+    fiber_t *prev;
+    prev = NULL;
+
+    for (fiber_t *it = queue->head; it != NULL; prev = it, it = it->next) {
+        if (it != fiber) {
+            continue;
+        }
+
+        if (prev == NULL) {
+            queue->head = it->next;
+        } else {
+            prev->next = it->next;
+        }
+
+        if (queue->tail == it) {
+            queue->tail = prev;
+        }
+
+        it->next = NULL;
+
+        return true;
+    }
+
+    return false;
+}
+
+/* Wake every fiber in the queue. Interrupts must be masked */
+static inline void __always_inline
+_queue_wake_all(fiber_queue_t *queue)
+{
+    fiber_t *fiber;
+
+    while ((fiber = _queue_pop(queue)) != NULL) {
+        fiber->state = FIBER_STATE_READY;
+        fiber->wait_queue = NULL;
+
+        _queue_push(&_ready, fiber);
+    }
+}
+
+void
+fiber_sched_init(void)
+{
+    _ready.head = NULL;
+    _ready.tail = NULL;
+
+    _sleeping.head = NULL;
+    _sleeping.tail = NULL;
+
+    _frame = 0;
+    _vblank = false;
+}
+
+void
+fiber_sched_add(fiber_t *fiber)
+{
+    assert(fiber != NULL);
+
+    const uint8_t sr_mask = cpu_intc_mask_get();
+    cpu_intc_mask_set(15);
+
+    fiber->state = FIBER_STATE_READY;
+
+    _queue_push(&_ready, fiber);
+
+    cpu_intc_mask_set(sr_mask);
+}
+
+void
+fiber_sched_remove(fiber_t *fiber)
+{
+    assert(fiber != NULL);
+
+    const uint8_t sr_mask = cpu_intc_mask_get();
+    cpu_intc_mask_set(15);
+
+    if (fiber->state == FIBER_STATE_WAITING) {
+        /* Or else the next signal or post would make it ready again */
+        (void)_queue_remove(fiber->wait_queue, fiber);
+    } else if (!(_queue_remove(&_ready, fiber))) {
+        (void)_queue_remove(&_sleeping, fiber);
+    }
+
+    fiber->state = FIBER_STATE_IDLE;
+    fiber->wait_queue = NULL;
+
+    cpu_intc_mask_set(sr_mask);
+}
+
+void
+fiber_sched_run(void)
+{
+    _vblank = false;
+
+    _sleepers_wake();
+
+    while (!_vblank) {
+        const uint8_t sr_mask = cpu_intc_mask_get();
+        cpu_intc_mask_set(15);
+
+        fiber_t * const fiber = _queue_pop(&_ready);
+
+        cpu_intc_mask_set(sr_mask);
+
+        /* Nothing left to run this frame, so go idle by returning to the main
+         * loop */
+        if (fiber == NULL) {
+            break;
+        }
+
+        /* A fiber may well run past a CPU-FRT period, so use the extended
+         * count */
+        const uint32_t start_ticks = vdp_sync_ticks_get();
+
+        fiber_yield(fiber);
+
+        fiber->ticks += vdp_sync_ticks_get() - start_ticks;
+    }
+}
+
+void
+fiber_sched_vblank(void *work __unused)
+{
+    _frame++;
+    _vblank = true;
+}
+
+uint32_t
+fiber_sched_frame_get(void)
+{
+    return _frame;
+}
+
+void
+fiber_sched_yield(void)
+{
+    fiber_t * const fiber = fiber_current_get();
+
+    fiber_sched_add(fiber);
+
+    fiber_yield(NULL);
+}
+
+void
+fiber_sleep_frames(uint32_t frames)
+{
+    if (frames == 0) {
+        fiber_sched_yield();
+
+        return;
+    }
+
+    fiber_t * const fiber = fiber_current_get();
+
+    const uint8_t sr_mask = cpu_intc_mask_get();
+    cpu_intc_mask_set(15);
+
+    fiber->state = FIBER_STATE_SLEEPING;
+    fiber->wake_frame = _frame + frames;
+
+    _queue_push(&_sleeping, fiber);
+
+    cpu_intc_mask_set(sr_mask);
+
+    fiber_yield(NULL);
+}
+
+void
+fiber_sched_exit(void)
+{
+    fiber_current_get()->state = FIBER_STATE_DONE;
+
+    /* The fiber is in no queue, so it's never switched back to */
+    while (true) {
+        fiber_yield(NULL);
+    }
+}
+
+uint32_t
+fiber_ticks_get(const fiber_t *fiber)
+{
+    assert(fiber != NULL);
+
+    return fiber->ticks;
+}
+
+void
+fiber_ticks_clear(fiber_t *fiber)
+{
+    assert(fiber != NULL);
+
+    fiber->ticks = 0;
+}
+
+void
+fiber_event_init(fiber_event_t *event)
+{
+    assert(event != NULL);
+
+    event->waiters.head = NULL;
+    event->waiters.tail = NULL;
+    event->signaled = false;
+}
+
+void
+fiber_event_wait(fiber_event_t *event)
+{
+    assert(event != NULL);
+
+    const uint8_t sr_mask = cpu_intc_mask_get();
+    cpu_intc_mask_set(15);
+
+    if (event->signaled) {
+        cpu_intc_mask_set(sr_mask);
+
+        return;
+    }
+
+    _wait(&event->waiters);
+
+    cpu_intc_mask_set(sr_mask);
+
+    fiber_yield(NULL);
+}
+
+void
+fiber_event_signal(fiber_event_t *event)
+{
+    assert(event != NULL);
+
+    const uint8_t sr_mask = cpu_intc_mask_get();
+    cpu_intc_mask_set(15);
+
+    event->signaled = true;
+
+    _queue_wake_all(&event->waiters);
+
+    cpu_intc_mask_set(sr_mask);
+}
+
+void
+fiber_event_clear(fiber_event_t *event)
+{
+    assert(event != NULL);
+
+    event->signaled = false;
+}
+
+void
+fiber_sem_init(fiber_sem_t *sem, int32_t count)
+{
+    assert(sem != NULL);
+    assert(count >= 0);
+
+    sem->waiters.head = NULL;
+    sem->waiters.tail = NULL;
+    sem->count = count;
+}
+
+void
+fiber_sem_wait(fiber_sem_t *sem)
+{
+    assert(sem != NULL);
+
+    const uint8_t sr_mask = cpu_intc_mask_get();
+    cpu_intc_mask_set(15);
+
+    if (sem->count > 0) {
+        sem->count--;
+
+        cpu_intc_mask_set(sr_mask);
+
+        return;
+    }
+
+    _wait(&sem->waiters);
+
+    cpu_intc_mask_set(sr_mask);
+
+    fiber_yield(NULL);
+}
+
+void
+fiber_sem_post(fiber_sem_t *sem)
+{
+    assert(sem != NULL);
+
+    const uint8_t sr_mask = cpu_intc_mask_get();
+    cpu_intc_mask_set(15);
+
+    fiber_t * const fiber = _queue_pop(&sem->waiters);
+
+    /* Hand the count directly over to the first waiter */
+    if (fiber != NULL) {
+        fiber->state = FIBER_STATE_READY;
+        fiber->wait_queue = NULL;
+
+        _queue_push(&_ready, fiber);
+    } else {
+        sem->count++;
+    }
+
+    cpu_intc_mask_set(sr_mask);
+}
+
+static void
+_sleepers_wake(void)
+{
+    const uint8_t sr_mask = cpu_intc_mask_get();
+    cpu_intc_mask_set(15);
+
+    const uint32_t frame = _frame;
+
+    fiber_t *fiber;
+    fiber = _sleeping.head;
+
+    _sleeping.head = NULL;
+    _sleeping.tail = NULL;
+
+    while (fiber != NULL) {
+        fiber_t * const next = fiber->next;
+
+        if ((int32_t)(frame - fiber->wake_frame) >= 0) {
+            fiber->state = FIBER_STATE_READY;
+
+            _queue_push(&_ready, fiber);
+        } else {
+            _queue_push(&_sleeping, fiber);
+        }
+
+        fiber = next;
+    }
+
+    cpu_intc_mask_set(sr_mask);
+}
+
+/* Park the current fiber on the queue. Interrupts must be masked */
+static void
+_wait(fiber_queue_t *queue)
+{
+    fiber_t * const fiber = fiber_current_get();
+
+    fiber->state = FIBER_STATE_WAITING;
+    fiber->wait_queue = queue;
+
+    _queue_push(queue, fiber);
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) Israel Jacquez
+ * See LICENSE for details.
+ *
+ * Israel Jacquez <mrkotfw@gmail.com>
+ */
+
+#include <cpu/intc.h>
+
+#include "fiber.h"
+
+static fiber_stack_pool_t *_pool;
+
+static void *_pool_alloc(size_t align, size_t amount);
+static void _pool_free(void *p);
+
+void
+fiber_stack_pool_init(fiber_stack_pool_t *pool, void *memory, size_t stack_size,
+    uint32_t count)
+{
+    assert(pool != NULL);
+    assert(memory != NULL);
+    assert(((uintptr_t)memory & 0x0F) == 0);
+    assert((stack_size & 0x0F) == 0);
+    assert((count > 0) && (count <= 32));
+
+    pool->memory = memory;
+    pool->stack_size = stack_size;
+    pool->count = count;
+    pool->used = 0;
+
+    _pool = pool;
+
+    fiber_stack_allocator_set(_pool_alloc, _pool_free);
+}
+
+uint32_t
+fiber_stack_pool_free_count(const fiber_stack_pool_t *pool)
+{
+    assert(pool != NULL);
+
+    uint32_t free_count;
+    free_count = 0;
+
+    for (uint32_t i = 0; i < pool->count; i++) {
+        if ((pool->used & (1UL << i)) == 0) {
+            free_count++;
+        }
+    }
+
+    return free_count;
+}
+
+static void *
+_pool_alloc(size_t align __unused, size_t amount)
+{
+    fiber_stack_pool_t * const pool = _pool;
+
+    if (amount > pool->stack_size) {
+        return NULL;
+    }
+
+    void *stack;
+    stack = NULL;
+
+    const uint8_t sr_mask = cpu_intc_mask_get();
+    cpu_intc_mask_set(15);
+
+    for (uint32_t i = 0; i < pool->count; i++) {
+        if ((pool->used & (1UL << i)) == 0) {
+            pool->used |= 1UL << i;
+
+            stack = &pool->memory[i * pool->stack_size];
+
+            break;
+        }
+    }
+
+    cpu_intc_mask_set(sr_mask);
+
+    return stack;
+}
+
+static void
+_pool_free(void *p)
+{
+    fiber_stack_pool_t * const pool = _pool;
+
+    const uintptr_t offset = (uintptr_t)p - (uintptr_t)pool->memory;
+    const uint32_t i = offset / pool->stack_size;
+
+    assert((offset % pool->stack_size) == 0);
+    assert(i < pool->count);
+
+    const uint8_t sr_mask = cpu_intc_mask_get();
+    cpu_intc_mask_set(15);
+
+    pool->used &= ~(1UL << i);
+
+    cpu_intc_mask_set(sr_mask);
+}
@@ -194,7 +194,11 @@ LIB_SRCS+= \
 
 LIB_SRCS+= \
 	kernel/fs/cd/cdfs.c \
-	kernel/fs/cd/cdfs_sector_read.c
+	kernel/fs/cd/cdfs_index.c \
+	kernel/fs/cd/cdfs_sector_cache.c \
+	kernel/fs/cd/cdfs_sector_read.c \
+	kernel/fs/fmv/fmv.c \
+	kernel/fs/pack/pack.c
 
 LIB_SRCS+= \
 	scu/bus/a/cs0/arp/arp.c
@@ -230,6 +234,9 @@ LIB_SRCS+= \
 	scu/bus/a/cs2/cd-block/cd-block_cmds.c \
 	scu/bus/a/cs2/cd-block/cd-block_execute.c \
 	scu/bus/a/cs2/cd-block/cd-block_init.c \
+	scu/bus/a/cs2/cd-block/cd-block_irq.c \
+	scu/bus/a/cs2/cd-block/cd-block_queue.c \
+	scu/bus/a/cs2/cd-block/cd-block_stream.c \
 	\
 	scu/bus/b/scsp/scsp_init.c \
 	\
@@ -238,6 +245,7 @@ LIB_SRCS+= \
 	scu/bus/b/vdp/vdp1_env.c \
 	scu/bus/b/vdp/vdp1_vram.c \
 	scu/bus/b/vdp/vdp2_cram.c \
+	scu/bus/b/vdp/vdp2_cram_pal.c \
 	scu/bus/b/vdp/vdp2_regs.c \
 	scu/bus/b/vdp/vdp2_scrn_back.c \
 	scu/bus/b/vdp/vdp2_scrn_bitmap.c \
@@ -246,12 +254,15 @@ LIB_SRCS+= \
 	scu/bus/b/vdp/vdp2_scrn_display.c \
 	scu/bus/b/vdp/vdp2_scrn_lncl.c \
 	scu/bus/b/vdp/vdp2_scrn_ls.c \
+	scu/bus/b/vdp/vdp2_scrn_ls_table.c \
 	scu/bus/b/vdp/vdp2_scrn_mosaic.c \
 	scu/bus/b/vdp/vdp2_scrn_priority.c \
 	scu/bus/b/vdp/vdp2_scrn_reduction.c \
 	scu/bus/b/vdp/vdp2_scrn_rotation.c \
+	scu/bus/b/vdp/vdp2_scrn_rotation_gen.c \
 	scu/bus/b/vdp/vdp2_scrn_scroll.c \
 	scu/bus/b/vdp/vdp2_scrn_sf.c \
+	scu/bus/b/vdp/vdp2_scrn_stream.c \
 	scu/bus/b/vdp/vdp2_scrn_vcs.c \
 	scu/bus/b/vdp/vdp2_sprite.c \
 	scu/bus/b/vdp/vdp2_tvmd.c \
@@ -267,6 +278,8 @@ LIB_SRCS+= \
 	scu/bus/cpu/cpu_exceptions.sx \
 	scu/bus/cpu/cpu_frt.c \
 	scu/bus/cpu/cpu_init.c \
+	scu/bus/cpu/cpu_job.c \
+	scu/bus/cpu/cpu_ring.c \
 	scu/bus/cpu/cpu_sci.c \
 	scu/bus/cpu/cpu_ubc.c \
 	scu/bus/cpu/cpu_wdt.c \
@@ -379,7 +392,9 @@ INSTALL_HEADER_FILES+= \
 	./kernel/sys/:callback-list.h:yaul/sys/
 
 INSTALL_HEADER_FILES+= \
-	./kernel/fs/cd/:cdfs.h:yaul/fs/cd/
+	./kernel/fs/cd/:cdfs.h:yaul/fs/cd/ \
+	./kernel/fs/fmv/:fmv.h:yaul/fs/fmv/ \
+	./kernel/fs/pack/:pack.h:yaul/fs/pack/
 
 INSTALL_HEADER_FILES+= \
 	./scu/:scu.h:yaul/ \
@@ -429,6 +444,7 @@ INSTALL_HEADER_FILES+= \
 	./scu/bus/b/vdp/vdp2/:scrn_macros.h:yaul/vdp2/ \
 	./scu/bus/b/vdp/vdp2/:scrn_rotation.h:yaul/vdp2/ \
 	./scu/bus/b/vdp/vdp2/:scrn_shared.h:yaul/vdp2/ \
+	./scu/bus/b/vdp/vdp2/:scrn_stream.h:yaul/vdp2/ \
 	./scu/bus/b/vdp/vdp2/:sprite.h:yaul/vdp2/ \
 	./scu/bus/b/vdp/vdp2/:tvmd.h:yaul/vdp2/ \
 	./scu/bus/b/vdp/vdp2/:vram.h:yaul/vdp2/
@@ -443,8 +459,10 @@ INSTALL_HEADER_FILES+= \
 	./scu/bus/cpu/cpu/:frt.h:yaul/cpu/ \
 	./scu/bus/cpu/cpu/:instructions.h:yaul/cpu/ \
 	./scu/bus/cpu/cpu/:intc.h:yaul/cpu/ \
+	./scu/bus/cpu/cpu/:job.h:yaul/cpu/ \
 	./scu/bus/cpu/cpu/:map.h:yaul/cpu/ \
 	./scu/bus/cpu/cpu/:registers.h:yaul/cpu/ \
+	./scu/bus/cpu/cpu/:ring.h:yaul/cpu/ \
 	./scu/bus/cpu/cpu/:sci.h:yaul/cpu/ \
 	./scu/bus/cpu/cpu/:sync.h:yaul/cpu/ \
 	./scu/bus/cpu/cpu/:ubc.h:yaul/cpu/ \
@@ -11,13 +11,19 @@ include $(YAUL_INSTALL_ROOT)/share/ip.bin.mk
 IMAGE_DIRECTORY?= cd
 AUDIO_TRACKS_DIRECTORY?= audio-tracks
 IMAGE_1ST_READ_BIN?= A.BIN
+# When set, files are placed on the disc in the order listed in this file
+IMAGE_FILE_ORDER?=
+# When set along with IMAGE_FILE_ORDER, a directory index (see
+# cdfs_index_load) is written to the root directory under this name
+IMAGE_INDEX?=
 
 OUTPUT_FILES= $(SH_OUTPUT_PATH)/$(SH_PROGRAM).iso $(SH_OUTPUT_PATH)/$(SH_PROGRAM).cue
-CLEAN_OUTPUT_FILES= $(OUTPUT_FILES) $(SH_BUILD_PATH)/IP.BIN $(SH_BUILD_PATH)/IP.BIN.map
+CLEAN_OUTPUT_FILES= $(OUTPUT_FILES) $(SH_BUILD_PATH)/IP.BIN $(SH_BUILD_PATH)/IP.BIN.map \
+	$(SH_BUILD_PATH)/$(SH_PROGRAM).iso.map
 
 include $(YAUL_INSTALL_ROOT)/share/build.post.bin.mk
 
-$(SH_OUTPUT_PATH)/$(SH_PROGRAM).iso: $(SH_BUILD_PATH)/$(SH_PROGRAM).bin $(SH_BUILD_PATH)/IP.BIN
+$(SH_OUTPUT_PATH)/$(SH_PROGRAM).iso: $(SH_BUILD_PATH)/$(SH_PROGRAM).bin $(SH_BUILD_PATH)/IP.BIN $(IMAGE_FILE_ORDER)
 	@printf -- "$(V_BEGIN_YELLOW)$(@F)$(V_END)\n"
     # This is a rather nasty hack to suppress any output from running the
     # pre/post-build-iso targets
@@ -29,7 +35,11 @@ $(SH_OUTPUT_PATH)/$(SH_PROGRAM).iso: $(SH_BUILD_PATH)/$(SH_PROGRAM).bin $(SH_BUI
 		printf -- "empty\n" > $(IMAGE_DIRECTORY)/$$txt; \
 	    fi \
 	done
+ifeq ($(strip $(IMAGE_FILE_ORDER)),)
 	$(ECHO)$(YAUL_INSTALL_ROOT)/share/wrap-error $(YAUL_INSTALL_ROOT)/bin/make-iso $(IMAGE_DIRECTORY) $(SH_BUILD_PATH)/IP.BIN $(SH_OUTPUT_PATH) $(SH_PROGRAM)
+else
+	$(ECHO)$(YAUL_INSTALL_ROOT)/share/wrap-error $(YAUL_INSTALL_ROOT)/bin/make-iso-native $(if $(strip $(IMAGE_INDEX)),-x $(IMAGE_INDEX)) $(IMAGE_DIRECTORY) $(SH_BUILD_PATH)/IP.BIN $(SH_OUTPUT_PATH) $(SH_PROGRAM) $(IMAGE_FILE_ORDER) > $(SH_BUILD_PATH)/$(SH_PROGRAM).iso.map
+endif
 	$(ECHO)$(MAKE) --no-print-directory $$([ -z "$(SILENT)" ] || printf -- "-s") -f $(THIS_FILE) post-build-iso
 
 $(SH_OUTPUT_PATH)/$(SH_PROGRAM).cue: | $(SH_OUTPUT_PATH)/$(SH_PROGRAM).iso
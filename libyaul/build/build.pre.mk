@@ -92,6 +92,8 @@ SH_OUTPUT_DIR?= .
 #   IMAGE_DIRECTORY        ISO/CUE
 #   AUDIO_TRACKS_DIRECTORY ISO/CUE
 #   IMAGE_1ST_READ_BIN     ISO/CUE
+#   IMAGE_FILE_ORDER       ISO/CUE
+#   IMAGE_INDEX            ISO/CUE
 #   IP_VERSION             ISO/CUE, SS
 #   IP_RELEASE_DATE        ISO/CUE, SS
 #   IP_AREAS               ISO/CUE, SS
@@ -131,8 +131,13 @@ cdfs_filelist_walk(cdfs_filelist_t *filelist,
     assert((uint32_t)(_state.sector_buffer - _state.config.sectors) <= _state.config.sector_count);
 
     if (root_entry == NULL) {
-        /* Skip IP.BIN (16 sectors) */
-        sector_read(16, (sector_buffer_t *)&_state.pvd);
+        /* Skip IP.BIN (16 sectors). Nothing is walked if the PVD can't be
+         * read */
+        if ((sector_read(16, (sector_buffer_t *)&_state.pvd)) != 0) {
+            _state.sector_buffer--;
+
+            return;
+        }
 
         /* We are interested in the Primary Volume Descriptor, which
          * points us to the root directory and path tables, which both
@@ -233,7 +238,10 @@ _dirent_walk(cdfs_filelist_t *filelist, cdfs_filelist_walk_t walker,
 
             dirent_offset = 0;
 
-            sector_read(sector, sector_buffer);
+            /* A failed read ends the walk early */
+            if ((sector_read(sector, sector_buffer)) != 0) {
+                break;
+            }
 
             dirent = (const cdfs_dirent_t *)sector_buffer;
             dirent_length = isonum_711(dirent->length);
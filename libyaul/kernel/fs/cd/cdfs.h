@@ -25,6 +25,9 @@ __BEGIN_DECLS
 /* The maximum number of file list entries to read */
 #define CDFS_FILELIST_ENTRIES_COUNT (4096)
 
+/* The maximum number of lines in the sector cache */
+#define CDFS_SECTOR_CACHE_LINE_COUNT (16)
+
 /* CDFS limitations */
 #define ISO_DIR_LEVEL_MAX       8
 #define ISO_FILENAME_MAX_LENGTH 11
@@ -40,7 +43,10 @@ typedef union {
 
 static_assert(sizeof(sector_buffer_t) == CDFS_SECTOR_SIZE);
 
-typedef void (*cdfs_sector_read_t)(sector_t sector, sector_buffer_t *sector_buffer);
+/* Both return 0 on success, or the error from the CD-block */
+typedef int (*cdfs_sector_read_t)(sector_t sector, sector_buffer_t *sector_buffer);
+typedef int (*cdfs_sectors_read_t)(sector_t sector,
+  sector_buffer_t *sector_buffers, uint32_t count);
 
 typedef struct cdfs_config {
     cdfs_sector_read_t sector_read;
@@ -59,7 +65,7 @@ typedef struct {
     cdfs_entry_type_t type;
     char name[ISO_FILENAME_MAX_LENGTH + 1];
     fad_t starting_fad;
-    size_t size;
+    uint32_t size;
     uint16_t sector_count;
 } __aligned(4) cdfs_filelist_entry_t;
 
@@ -71,9 +77,83 @@ typedef struct {
     uint32_t entries_count;
 } cdfs_filelist_t;
 
+typedef struct {
+    uint32_t hits;
+    uint32_t misses;
+    /* Sectors read from the disc, including read-ahead */
+    uint32_t sectors_read;
+} cdfs_sector_cache_stats_t;
+
 typedef void (*cdfs_filelist_walk_t)(cdfs_filelist_t *filelist,
   const cdfs_filelist_entry_t *entry, void *args);
 
+/* Directory index
+ *
+ * Entries are keyed by the FNV-1a hash of their full upper case path, with '/'
+ * as the separator and without a leading '/', e.g. "DIR/FILE.BIN". Entries are
+ * sorted by hash.
+ *
+ * The serialized form is a cdfs_index_header_t followed by the entries, all
+ * big endian, so that host tools can write it to the disc image. The -x option
+ * of make-iso-native writes one */
+#define CDFS_INDEX_MAGIC     (0x43444958UL) /* "CDIX" */
+#define CDFS_INDEX_NO_PARENT (0xFFFFFFFFUL)
+
+#define CDFS_HASH_INIT       (0x811C9DC5UL)
+#define CDFS_HASH_PRIME      (0x01000193UL)
+
+typedef struct {
+    uint32_t hash;
+    fad_t starting_fad;
+    uint32_t size;
+    uint8_t type;
+    uint8_t level;
+    uint16_t reserved;
+} __aligned(4) cdfs_index_entry_t;
+
+static_assert(sizeof(cdfs_index_entry_t) == 16);
+
+typedef struct {
+    uint32_t magic;
+    uint32_t count;
+} __aligned(4) cdfs_index_header_t;
+
+typedef struct {
+    cdfs_index_entry_t *entries;
+    uint32_t pooled_count;
+    uint32_t count;
+} cdfs_index_t;
+
+static inline uint32_t __always_inline
+cdfs_hash_char(uint32_t hash, char c)
+{
+    if ((c >= 'a') && (c <= 'z')) {
+        c -= 'a' - 'A';
+    }
+
+    return ((hash ^ (uint8_t)c) * CDFS_HASH_PRIME);
+}
+
+static inline uint32_t __always_inline
+cdfs_hash_string(uint32_t hash, const char *s)
+{
+    for (; *s != '\0'; s++) {
+        hash = cdfs_hash_char(hash, *s);
+    }
+
+    return hash;
+}
+
+static inline uint32_t __always_inline
+cdfs_path_hash(const char *path)
+{
+    if (*path == '/') {
+        path++;
+    }
+
+    return cdfs_hash_string(CDFS_HASH_INIT, path);
+}
+
 static inline uint32_t __always_inline
 cdfs_sector_count_round(uint32_t length)
 {
@@ -100,7 +180,42 @@ extern void cdfs_filelist_walk(cdfs_filelist_t *filelist,
   cdfs_filelist_walk_t walker,
   void *args);
 
-void cdfs_sector_read(sector_t sector, sector_buffer_t *sector_buffer);
+/* Build the index by walking the disc once. Returns -1 if there are more than
+ * count entries, or -2 if two paths hash the same */
+extern int cdfs_index_build(cdfs_index_t *index, cdfs_index_entry_t *entries,
+  uint32_t count);
+/* Use a serialized index in place, without walking the disc. Returns -1 if the
+ * index is malformed or not sorted, or -2 if two entries hash the same. On a
+ * little endian host, data is byte swapped in place */
+extern int cdfs_index_load(cdfs_index_t *index, void *data, size_t size);
+/* Resolve a path through the last built or loaded index */
+extern int cdfs_open(const char *path, cdfs_filelist_entry_t *entry);
+
+int cdfs_sector_read(sector_t sector, sector_buffer_t *sector_buffer);
+int cdfs_sectors_read(sector_t sector, sector_buffer_t *sector_buffers,
+  uint32_t count);
+
+/* LRU sector cache. The sectors buffer is split into lines of line_sector_count
+ * contiguous sectors. A miss reads a whole line with a single seek, reading
+ * ahead the sectors that follow, up to the end of the volume. The size of the
+ * volume is read from the PVD on the first miss.
+ *
+ * A failed read leaves the line empty. cdfs_sector_cache_get() then returns
+ * NULL, and the others return the error from cdfs_sectors_read_t, or -1 for a
+ * sector past the end of the volume.
+ *
+ * To have directory walks go through the cache, set cdfs_config_t::sector_read
+ * to cdfs_sector_cache_read */
+extern void cdfs_sector_cache_init(sector_buffer_t *sectors,
+  uint32_t sector_count, uint32_t line_sector_count);
+extern void cdfs_sector_cache_sectors_read_set(cdfs_sectors_read_t sectors_read);
+extern void cdfs_sector_cache_invalidate(void);
+extern const sector_buffer_t *cdfs_sector_cache_get(sector_t sector);
+extern int cdfs_sector_cache_read(sector_t sector, sector_buffer_t *sector_buffer);
+extern int cdfs_sector_cache_file_read(const cdfs_filelist_entry_t *entry,
+  uint32_t offset, void *buffer, uint32_t length);
+extern const cdfs_sector_cache_stats_t *cdfs_sector_cache_stats_get(void);
+extern void cdfs_sector_cache_stats_clear(void);
 
 __END_DECLS
 
@@ -0,0 +1,301 @@
+/*
+ * Copyright (c) Israel Jacquez
+ * See LICENSE for details.
+ *
+ * Israel Jacquez <mrkotfw@gmail.com>
+ */
+
+#include <assert.h>
+#include <string.h>
+
+#include "cdfs.h"
+
+typedef struct {
+    cdfs_index_t *index;
+    uint32_t parent;
+    int ret;
+} build_args_t;
+
+static cdfs_index_t *_index;
+
+static void _build_walker(cdfs_filelist_t *filelist,
+    const cdfs_filelist_entry_t *entry, void *args);
+static void _entries_sort(cdfs_index_entry_t *entries, uint32_t count);
+static const cdfs_index_entry_t *_entry_find(const cdfs_index_t *index,
+    uint32_t hash);
+
+#if __BYTE_ORDER__ != __ORDER_BIG_ENDIAN__
+static void _header_swap(cdfs_index_header_t *header);
+static void _entries_swap(cdfs_index_entry_t *entries, uint32_t count);
+#endif /* __BYTE_ORDER__ != __ORDER_BIG_ENDIAN__ */
+
+int
+cdfs_index_build(cdfs_index_t *index, cdfs_index_entry_t *entries,
+    uint32_t count)
+{
+    assert(index != NULL);
+    assert(entries != NULL);
+    assert(count > 0);
+
+    index->entries = entries;
+    index->pooled_count = count;
+    index->count = 0;
+
+    /* The walker doesn't use the file list, but the walk requires one */
+    cdfs_filelist_t filelist = {
+        .entries              = NULL,
+        .entries_pooled_count = 0,
+        .entries_count        = 0
+    };
+
+    build_args_t build_args = {
+        .index  = index,
+        .parent = CDFS_INDEX_NO_PARENT,
+        .ret    = 0
+    };
+
+    cdfs_filelist_walk(&filelist, NULL, _build_walker, &build_args);
+
+    /* Walk breadth first. Entries appended by walking a directory are walked
+     * in turn, so no recursion is needed */
+    for (uint32_t i = 0; (i < index->count) && (build_args.ret == 0); i++) {
+        const cdfs_index_entry_t * const entry = &index->entries[i];
+
+        if ((entry->type != CDFS_ENTRY_TYPE_DIRECTORY) ||
+            ((entry->level + 1) >= ISO_DIR_LEVEL_MAX)) {
+            continue;
+        }
+
+        const cdfs_filelist_entry_t root_entry = {
+            .type         = CDFS_ENTRY_TYPE_DIRECTORY,
+            .starting_fad = entry->starting_fad,
+            .size         = entry->size
+        };
+
+        build_args.parent = i;
+
+        cdfs_filelist_walk(&filelist, &root_entry, _build_walker, &build_args);
+    }
+
+    if (build_args.ret != 0) {
+        return build_args.ret;
+    }
+
+    _entries_sort(index->entries, index->count);
+
+    /* Two paths with the same hash can't be told apart */
+    for (uint32_t i = 1; i < index->count; i++) {
+        if (index->entries[i - 1].hash == index->entries[i].hash) {
+            return -2;
+        }
+    }
+
+    _index = index;
+
+    return 0;
+}
+
+int
+cdfs_index_load(cdfs_index_t *index, void *data, size_t size)
+{
+    assert(index != NULL);
+    assert(data != NULL);
+    assert(((uintptr_t)data & 0x03) == 0);
+
+    cdfs_index_header_t * const header = data;
+
+    if (size < sizeof(cdfs_index_header_t)) {
+        return -1;
+    }
+
+#if __BYTE_ORDER__ != __ORDER_BIG_ENDIAN__
+    /* The index is big endian, so a little endian host has to swap it */
+    _header_swap(header);
+#endif /* __BYTE_ORDER__ != __ORDER_BIG_ENDIAN__ */
+
+    if (header->magic != CDFS_INDEX_MAGIC) {
+        return -1;
+    }
+
+    /* Compare the count against what fits, as multiplying it out could
+     * overflow */
+    const size_t entries_count_max =
+        (size - sizeof(cdfs_index_header_t)) / sizeof(cdfs_index_entry_t);
+
+    if (header->count > entries_count_max) {
+        return -1;
+    }
+
+    cdfs_index_entry_t * const entries = (cdfs_index_entry_t *)&header[1];
+
+#if __BYTE_ORDER__ != __ORDER_BIG_ENDIAN__
+    _entries_swap(entries, header->count);
+#endif /* __BYTE_ORDER__ != __ORDER_BIG_ENDIAN__ */
+
+    /* Entries are used in place, so they have to be sorted already. Two paths
+     * with the same hash can't be told apart */
+    for (uint32_t i = 1; i < header->count; i++) {
+        if (entries[i - 1].hash == entries[i].hash) {
+            return -2;
+        }
+
+        if (entries[i - 1].hash > entries[i].hash) {
+            return -1;
+        }
+    }
+
+    index->entries = entries;
+    index->count = header->count;
+    index->pooled_count = header->count;
+
+    _index = index;
+
+    return 0;
+}
+
+int
+cdfs_open(const char *path, cdfs_filelist_entry_t *entry)
+{
+    assert(path != NULL);
+    assert(entry != NULL);
+    assert(_index != NULL);
+
+    const cdfs_index_entry_t * const index_entry =
+        _entry_find(_index, cdfs_path_hash(path));
+
+    if (index_entry == NULL) {
+        return -1;
+    }
+
+    const char *name;
+    name = strrchr(path, '/');
+    name = (name != NULL) ? (name + 1) : path;
+
+    size_t name_len;
+    name_len = strlen(name);
+
+    if (name_len > ISO_FILENAME_MAX_LENGTH) {
+        name_len = ISO_FILENAME_MAX_LENGTH;
+    }
+
+    entry->type = index_entry->type;
+    entry->starting_fad = index_entry->starting_fad;
+    entry->size = index_entry->size;
+    entry->sector_count = cdfs_sector_count_round(index_entry->size);
+
+    (void)memcpy(entry->name, name, name_len);
+    entry->name[name_len] = '\0';
+
+    return 0;
+}
+
+static void
+_build_walker(cdfs_filelist_t *filelist __unused,
+    const cdfs_filelist_entry_t *entry, void *args)
+{
+    build_args_t * const build_args = args;
+    cdfs_index_t * const index = build_args->index;
+
+    if (build_args->ret != 0) {
+        return;
+    }
+
+    if (index->count >= index->pooled_count) {
+        build_args->ret = -1;
+
+        return;
+    }
+
+    uint32_t hash;
+    uint8_t level;
+
+    if (build_args->parent == CDFS_INDEX_NO_PARENT) {
+        hash = CDFS_HASH_INIT;
+        level = 0;
+    } else {
+        const cdfs_index_entry_t * const parent =
+            &index->entries[build_args->parent];
+
+        hash = cdfs_hash_char(parent->hash, '/');
+        level = parent->level + 1;
+    }
+
+    cdfs_index_entry_t * const index_entry = &index->entries[index->count];
+
+    index_entry->hash = cdfs_hash_string(hash, entry->name);
+    index_entry->starting_fad = entry->starting_fad;
+    index_entry->size = entry->size;
+    index_entry->type = entry->type;
+    index_entry->level = level;
+    index_entry->reserved = 0;
+
+    index->count++;
+}
+
+static void
+_entries_sort(cdfs_index_entry_t *entries, uint32_t count)
+{
+    /* Shell sort. Runs once at boot over at most a few thousand entries */
+    for (uint32_t gap = count / 2; gap > 0; gap /= 2) {
+        for (uint32_t i = gap; i < count; i++) {
+            const cdfs_index_entry_t tmp = entries[i];
+
+            uint32_t j;
+
+            for (j = i; (j >= gap) && (entries[j - gap].hash > tmp.hash); j -= gap) {
+                entries[j] = entries[j - gap];
+            }
+
+            entries[j] = tmp;
+        }
+    }
+}
+
+static const cdfs_index_entry_t *
+_entry_find(const cdfs_index_t *index, uint32_t hash)
+{
+    uint32_t low;
+    low = 0;
+
+    uint32_t high;
+    high = index->count;
+
+    while (low < high) {
+        const uint32_t mid = (low + high) / 2;
+        const uint32_t mid_hash = index->entries[mid].hash;
+
+        if (mid_hash == hash) {
+            return &index->entries[mid];
+        }
+
+        if (mid_hash < hash) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return NULL;
+}
+
+#if __BYTE_ORDER__ != __ORDER_BIG_ENDIAN__
+static void
+_header_swap(cdfs_index_header_t *header)
+{
+    header->magic = __builtin_bswap32(header->magic);
+    header->count = __builtin_bswap32(header->count);
+}
+
+static void
+_entries_swap(cdfs_index_entry_t *entries, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++) {
+        cdfs_index_entry_t * const entry = &entries[i];
+
+        entry->hash = __builtin_bswap32(entry->hash);
+        entry->starting_fad = __builtin_bswap32(entry->starting_fad);
+        entry->size = __builtin_bswap32(entry->size);
+        entry->reserved = __builtin_bswap16(entry->reserved);
+    }
+}
+#endif /* __BYTE_ORDER__ != __ORDER_BIG_ENDIAN__ */
@@ -0,0 +1,321 @@
+/*
+ * Copyright (c) Israel Jacquez
+ * See LICENSE for details.
+ *
+ * Israel Jacquez <mrkotfw@gmail.com>
+ */
+
+#include <assert.h>
+#include <string.h>
+
+#include <cd-block.h>
+
+#include "cdfs-internal.h"
+#include "cdfs.h"
+
+typedef struct {
+    /* First sector held by the line */
+    sector_t sector;
+    /* Number of valid sectors, or zero if the line is empty */
+    uint32_t count;
+    /* Last access, for LRU eviction */
+    uint32_t stamp;
+    sector_buffer_t *buffers;
+} line_t;
+
+static struct {
+    cdfs_sectors_read_t sectors_read;
+
+    line_t lines[CDFS_SECTOR_CACHE_LINE_COUNT];
+    uint32_t line_count;
+    uint32_t line_sector_count;
+
+    /* Read from the PVD on the first miss, or zero if not yet known */
+    uint32_t volume_sector_count;
+
+    uint32_t stamp;
+
+    cdfs_sector_cache_stats_t stats;
+} _state = {
+    .sectors_read = cdfs_sectors_read
+};
+
+static int _sector_get(sector_t sector, const sector_buffer_t **cached);
+static line_t *_line_find(sector_t sector);
+static int _line_fill(sector_t sector, line_t **filled);
+static int _volume_read(sector_buffer_t *sector_buffer);
+
+void
+cdfs_sector_cache_init(sector_buffer_t *sectors, uint32_t sector_count,
+    uint32_t line_sector_count)
+{
+    assert(sectors != NULL);
+    assert(line_sector_count > 0);
+    assert(sector_count >= line_sector_count);
+
+    uint32_t line_count;
+    line_count = sector_count / line_sector_count;
+
+    if (line_count > CDFS_SECTOR_CACHE_LINE_COUNT) {
+        line_count = CDFS_SECTOR_CACHE_LINE_COUNT;
+    }
+
+    _state.line_count = line_count;
+    _state.line_sector_count = line_sector_count;
+
+    for (uint32_t i = 0; i < line_count; i++) {
+        _state.lines[i].buffers = &sectors[i * line_sector_count];
+    }
+
+    cdfs_sector_cache_invalidate();
+    cdfs_sector_cache_stats_clear();
+}
+
+void
+cdfs_sector_cache_sectors_read_set(cdfs_sectors_read_t sectors_read)
+{
+    _state.sectors_read = (sectors_read != NULL) ? sectors_read : cdfs_sectors_read;
+}
+
+void
+cdfs_sector_cache_invalidate(void)
+{
+    for (uint32_t i = 0; i < _state.line_count; i++) {
+        _state.lines[i].count = 0;
+        _state.lines[i].stamp = 0;
+    }
+
+    /* The disc may have been swapped */
+    _state.volume_sector_count = 0;
+
+    _state.stamp = 0;
+}
+
+const sector_buffer_t *
+cdfs_sector_cache_get(sector_t sector)
+{
+    const sector_buffer_t *cached;
+
+    if ((_sector_get(sector, &cached)) != 0) {
+        return NULL;
+    }
+
+    return cached;
+}
+
+int
+cdfs_sector_cache_read(sector_t sector, sector_buffer_t *sector_buffer)
+{
+    assert(sector_buffer != NULL);
+
+    const sector_buffer_t *cached;
+
+    const int ret = _sector_get(sector, &cached);
+
+    if (ret != 0) {
+        return ret;
+    }
+
+    (void)memcpy(sector_buffer, cached, sizeof(sector_buffer_t));
+
+    return 0;
+}
+
+int
+cdfs_sector_cache_file_read(const cdfs_filelist_entry_t *entry, uint32_t offset,
+    void *buffer, uint32_t length)
+{
+    assert(entry != NULL);
+    assert(buffer != NULL);
+    assert((offset + length) <= entry->size);
+
+    uint8_t *dst;
+    dst = buffer;
+
+    sector_t sector;
+    sector = FAD2LBA(entry->starting_fad) + (offset / CDFS_SECTOR_SIZE);
+
+    uint32_t sector_offset;
+    sector_offset = offset % CDFS_SECTOR_SIZE;
+
+    while (length > 0) {
+        const sector_buffer_t *cached;
+
+        const int ret = _sector_get(sector, &cached);
+
+        if (ret != 0) {
+            return ret;
+        }
+
+        uint32_t copy_length;
+        copy_length = CDFS_SECTOR_SIZE - sector_offset;
+
+        if (copy_length > length) {
+            copy_length = length;
+        }
+
+        (void)memcpy(dst, &cached->buffer8[sector_offset], copy_length);
+
+        dst += copy_length;
+        length -= copy_length;
+
+        sector++;
+        sector_offset = 0;
+    }
+
+    return 0;
+}
+
+const cdfs_sector_cache_stats_t *
+cdfs_sector_cache_stats_get(void)
+{
+    return &_state.stats;
+}
+
+void
+cdfs_sector_cache_stats_clear(void)
+{
+    _state.stats.hits = 0;
+    _state.stats.misses = 0;
+    _state.stats.sectors_read = 0;
+}
+
+static int
+_sector_get(sector_t sector, const sector_buffer_t **cached)
+{
+    assert(_state.line_count > 0);
+
+    line_t *line;
+    line = _line_find(sector);
+
+    if (line != NULL) {
+        _state.stats.hits++;
+    } else {
+        _state.stats.misses++;
+
+        const int ret = _line_fill(sector, &line);
+
+        if (ret != 0) {
+            return ret;
+        }
+    }
+
+    _state.stamp++;
+    line->stamp = _state.stamp;
+
+    *cached = &line->buffers[sector - line->sector];
+
+    return 0;
+}
+
+static line_t *
+_line_find(sector_t sector)
+{
+    for (uint32_t i = 0; i < _state.line_count; i++) {
+        line_t * const line = &_state.lines[i];
+
+        if ((sector >= line->sector) && (sector < (line->sector + line->count))) {
+            return line;
+        }
+    }
+
+    return NULL;
+}
+
+static int
+_line_fill(sector_t sector, line_t **filled)
+{
+    line_t *victim;
+    victim = &_state.lines[0];
+
+    /* Prefer an empty line, otherwise evict the least recently used */
+    for (uint32_t i = 0; i < _state.line_count; i++) {
+        line_t * const line = &_state.lines[i];
+
+        if (line->count == 0) {
+            victim = line;
+
+            break;
+        }
+
+        if (line->stamp < victim->stamp) {
+            victim = line;
+        }
+    }
+
+    /* Once a line is picked, it's empty until the read succeeds */
+    victim->count = 0;
+
+    if (_state.volume_sector_count == 0) {
+        const int ret = _volume_read(victim->buffers);
+
+        if (ret != 0) {
+            return ret;
+        }
+    }
+
+    if (sector >= _state.volume_sector_count) {
+        return -1;
+    }
+
+    /* Read ahead the sectors that follow, as they're read for the price of a
+     * single seek. Don't read past the end of the volume, and avoid caching a
+     * sector twice by stopping short of the next line that's already cached */
+    uint32_t count;
+    count = _state.line_sector_count;
+
+    if ((_state.volume_sector_count - sector) < count) {
+        count = _state.volume_sector_count - sector;
+    }
+
+    for (uint32_t i = 0; i < _state.line_count; i++) {
+        const line_t * const line = &_state.lines[i];
+
+        if ((line == victim) || (line->count == 0)) {
+            continue;
+        }
+
+        if ((line->sector > sector) && ((line->sector - sector) < count)) {
+            count = line->sector - sector;
+        }
+    }
+
+    victim->sector = sector;
+
+    const int ret = _state.sectors_read(sector, victim->buffers, count);
+
+    if (ret != 0) {
+        return ret;
+    }
+
+    victim->count = count;
+
+    _state.stats.sectors_read += count;
+
+    *filled = victim;
+
+    return 0;
+}
+
+static int
+_volume_read(sector_buffer_t *sector_buffer)
+{
+    /* Skip IP.BIN (16 sectors) */
+    const int ret = _state.sectors_read(16, sector_buffer, 1);
+
+    if (ret != 0) {
+        return ret;
+    }
+
+    _state.stats.sectors_read++;
+
+    const cdfs_pvd_t * const pvd = (const cdfs_pvd_t *)sector_buffer;
+
+    if (isonum_711(pvd->type) != ISO_VD_PRIMARY) {
+        return -1;
+    }
+
+    _state.volume_sector_count = isonum_733(pvd->volume_space_size);
+
+    return 0;
+}
@@ -12,8 +12,18 @@
 
 #include "cdfs.h"
 
-void
+int
 cdfs_sector_read(sector_t sector, sector_buffer_t *sector_buffer)
 {
-    cd_block_sector_read(LBA2FAD(sector), sector_buffer);
+    return cd_block_sector_read(LBA2FAD(sector), sector_buffer);
+}
+
+int
+cdfs_sectors_read(sector_t sector, sector_buffer_t *sector_buffers,
+    uint32_t count)
+{
+    assert(sector_buffers != NULL);
+    assert(count > 0);
+
+    return cd_block_sectors_read(LBA2FAD(sector), sector_buffers, count * CDFS_SECTOR_SIZE);
 }
@@ -0,0 +1,434 @@
+/*
+ * Copyright (c) Israel Jacquez
+ * See LICENSE for details.
+ *
+ * Israel Jacquez <mrkotfw@gmail.com>
+ */
+
+#include <assert.h>
+
+#include "fmv.h"
+
+#define FILTER_MODE_CHANNEL_CHECK (0x02)
+
+#define FILTER_CONNECTION_TRUE    (0x01)
+#define FILTER_CONNECTION_FALSE   (0x02)
+
+#define FILTER_DISCONNECTED       (0xFF)
+
+/* Seeking to this position pauses the drive */
+#define SEEK_PAUSE                (0xFFFFFF)
+
+static struct {
+    fmv_config_t config;
+
+    volatile fmv_status_t status;
+    /* Vertical blanks since playback started */
+    volatile uint32_t vblanks;
+
+    /* Index into bitmap_bases of the bitmap being displayed */
+    uint8_t front;
+    bool back_ready;
+    bool video_late;
+    uint32_t frames_transferred;
+    uint32_t next_swap_vblank;
+
+    uint32_t chunks_transferred;
+    uint32_t next_chunk_vblank;
+
+    fmv_stats_t stats;
+} _state = {
+    .status = FMV_STATUS_IDLE
+};
+
+static int _filters_set(void);
+static int _video_transfer(void);
+static int _audio_transfer(void);
+static void _video_present(void);
+static void _audio_advance(void);
+static void _bitmaps_swap(void);
+static void _playback_end(fmv_status_t status);
+
+static inline uint32_t __always_inline
+_sectors_ready(uint8_t partition)
+{
+    return cd_block_cmd_sector_number_get(partition);
+}
+
+int
+fmv_start(const fmv_config_t *config)
+{
+    assert(config != NULL);
+    assert(config->fad >= 150);
+    assert((config->video_frame_count == 0) ||
+           (config->video_frame_sector_count > 0));
+    assert((config->video_frame_count == 0) ||
+           (config->video_frame_period > 0));
+    assert((config->video_decode == NULL) || (config->video_buffer != NULL));
+    assert((config->audio_chunk_count == 0) || (config->pcm_buffer != NULL));
+    assert((config->audio_chunk_count == 0) ||
+           (config->audio_chunk_sector_count > 0));
+    assert((config->audio_chunk_count == 0) ||
+           (config->audio_chunk_period > 0));
+
+    fmv_stop();
+
+    _state.config = *config;
+
+    _state.vblanks = 0;
+    _state.front = 0;
+    _state.back_ready = false;
+    _state.video_late = false;
+    _state.frames_transferred = 0;
+    _state.next_swap_vblank = 0;
+    _state.chunks_transferred = 0;
+    _state.next_chunk_vblank = 0;
+
+    _state.stats.frames_presented = 0;
+    _state.stats.chunks_played = 0;
+    _state.stats.video_underruns = 0;
+    _state.stats.audio_underruns = 0;
+
+    int ret;
+
+    if ((ret = _filters_set()) != 0) {
+        _playback_end(FMV_STATUS_ERROR);
+
+        return ret;
+    }
+
+    if ((ret = cd_block_cmd_disk_play(0, config->fad, config->sector_count)) != 0) {
+        _playback_end(FMV_STATUS_ERROR);
+
+        return ret;
+    }
+
+    _state.status = FMV_STATUS_PREBUFFERING;
+
+    return 0;
+}
+
+void
+fmv_stop(void)
+{
+    if ((_state.status != FMV_STATUS_PREBUFFERING) &&
+        (_state.status != FMV_STATUS_PLAYING)) {
+        return;
+    }
+
+    _playback_end(FMV_STATUS_IDLE);
+}
+
+fmv_status_t
+fmv_update(void)
+{
+    const fmv_config_t * const config = &_state.config;
+
+    if ((_state.status != FMV_STATUS_PREBUFFERING) &&
+        (_state.status != FMV_STATUS_PLAYING)) {
+        return _state.status;
+    }
+
+    if (_state.status == FMV_STATUS_PLAYING) {
+        _video_present();
+        _audio_advance();
+
+        if ((_state.stats.frames_presented >= config->video_frame_count) &&
+            (_state.stats.chunks_played >= config->audio_chunk_count)) {
+            _playback_end(FMV_STATUS_DONE);
+
+            return _state.status;
+        }
+    }
+
+    /* Fill the halves that have been played first, as audio gaps are more
+     * noticeable than dropped frames */
+    if (((_audio_transfer()) != 0) || ((_video_transfer()) != 0)) {
+        _playback_end(FMV_STATUS_ERROR);
+
+        return _state.status;
+    }
+
+    if (_state.status == FMV_STATUS_PREBUFFERING) {
+        const uint32_t prebuffer_chunk_count = (config->audio_chunk_count < 2)
+            ? config->audio_chunk_count
+            : 2;
+
+        const bool video_ready =
+            (config->video_frame_count == 0) || _state.back_ready;
+        const bool audio_ready =
+            (_state.chunks_transferred >= prebuffer_chunk_count);
+
+        if (video_ready && audio_ready) {
+            if (config->video_frame_count > 0) {
+                _bitmaps_swap();
+            }
+
+            _state.vblanks = 0;
+            _state.next_swap_vblank = config->video_frame_period;
+            _state.next_chunk_vblank = config->audio_chunk_period;
+
+            _state.status = FMV_STATUS_PLAYING;
+
+            if (config->start_handler != NULL) {
+                config->start_handler(config->start_work);
+            }
+        }
+    }
+
+    return _state.status;
+}
+
+void
+fmv_vblank(void *work __unused)
+{
+    if (_state.status == FMV_STATUS_PLAYING) {
+        _state.vblanks++;
+    }
+}
+
+fmv_status_t
+fmv_status_get(void)
+{
+    return _state.status;
+}
+
+const fmv_stats_t *
+fmv_stats_get(void)
+{
+    return &_state.stats;
+}
+
+static int
+_filters_set(void)
+{
+    const fmv_config_t * const config = &_state.config;
+
+    int ret;
+
+    if ((ret = cd_block_cmd_selector_reset(0, FMV_PARTITION_VIDEO)) != 0) {
+        return ret;
+    }
+
+    if ((ret = cd_block_cmd_selector_reset(0, FMV_PARTITION_AUDIO)) != 0) {
+        return ret;
+    }
+
+    /* Video sectors go to the video partition, and everything else on to the
+     * audio filter */
+    ret = cd_block_cmd_filter_subheader_conditions_set(config->video_channel,
+        0x00, 0x00, FMV_FILTER_VIDEO, 0x00, 0x00, 0x00);
+
+    if (ret != 0) {
+        return ret;
+    }
+
+    ret = cd_block_cmd_filter_mode_set(FILTER_MODE_CHANNEL_CHECK,
+        FMV_FILTER_VIDEO);
+
+    if (ret != 0) {
+        return ret;
+    }
+
+    ret = cd_block_cmd_filter_connection_set(
+        FILTER_CONNECTION_TRUE | FILTER_CONNECTION_FALSE,
+        FMV_PARTITION_VIDEO, FMV_FILTER_AUDIO, FMV_FILTER_VIDEO);
+
+    if (ret != 0) {
+        return ret;
+    }
+
+    /* Audio sectors go to the audio partition, and anything else is
+     * discarded */
+    ret = cd_block_cmd_filter_subheader_conditions_set(config->audio_channel,
+        0x00, 0x00, FMV_FILTER_AUDIO, 0x00, 0x00, 0x00);
+
+    if (ret != 0) {
+        return ret;
+    }
+
+    ret = cd_block_cmd_filter_mode_set(FILTER_MODE_CHANNEL_CHECK,
+        FMV_FILTER_AUDIO);
+
+    if (ret != 0) {
+        return ret;
+    }
+
+    ret = cd_block_cmd_filter_connection_set(
+        FILTER_CONNECTION_TRUE | FILTER_CONNECTION_FALSE,
+        FMV_PARTITION_AUDIO, FILTER_DISCONNECTED, FMV_FILTER_AUDIO);
+
+    if (ret != 0) {
+        return ret;
+    }
+
+    return cd_block_cmd_cd_dev_connection_set(FMV_FILTER_VIDEO);
+}
+
+static int
+_video_transfer(void)
+{
+    const fmv_config_t * const config = &_state.config;
+
+    if (_state.back_ready) {
+        return 0;
+    }
+
+    if (_state.frames_transferred >= config->video_frame_count) {
+        return 0;
+    }
+
+    if ((_sectors_ready(FMV_PARTITION_VIDEO)) < config->video_frame_sector_count) {
+        return 0;
+    }
+
+    const uint32_t length = config->video_frame_sector_count * CDFS_SECTOR_SIZE;
+
+    void * const back = (void *)config->bitmap_bases[_state.front ^ 1];
+
+    /* Without a decoder, the frame goes straight into VDP2 VRAM */
+    void * const dst = (config->video_decode != NULL)
+        ? config->video_buffer
+        : back;
+
+    int ret;
+
+    ret = cd_block_transfer_data_dmac(0, FMV_PARTITION_VIDEO, dst, length,
+        CD_BLOCK_STREAM_DMAC_CHANNEL);
+
+    if (ret != 0) {
+        return ret;
+    }
+
+    if (config->video_decode != NULL) {
+        config->video_decode(config->video_buffer, back, config->video_work);
+    }
+
+    _state.frames_transferred++;
+    _state.back_ready = true;
+
+    return 0;
+}
+
+static int
+_audio_transfer(void)
+{
+    const fmv_config_t * const config = &_state.config;
+
+    const uint32_t length =
+        config->audio_chunk_sector_count * CDFS_SECTOR_SIZE;
+
+    /* Never get further ahead than the half that isn't playing */
+    while ((_state.chunks_transferred < config->audio_chunk_count) &&
+           (_state.chunks_transferred < (_state.stats.chunks_played + 2))) {
+        if ((_sectors_ready(FMV_PARTITION_AUDIO)) < config->audio_chunk_sector_count) {
+            break;
+        }
+
+        uint8_t * const half =
+            (uint8_t *)config->pcm_buffer + ((_state.chunks_transferred & 1) * length);
+
+        int ret;
+
+        ret = cd_block_transfer_data_dmac(0, FMV_PARTITION_AUDIO, half, length,
+            CD_BLOCK_STREAM_DMAC_CHANNEL);
+
+        if (ret != 0) {
+            return ret;
+        }
+
+        _state.chunks_transferred++;
+    }
+
+    return 0;
+}
+
+static void
+_video_present(void)
+{
+    const fmv_config_t * const config = &_state.config;
+
+    /* The first frame was presented when playback started */
+    if (_state.stats.frames_presented >= config->video_frame_count) {
+        return;
+    }
+
+    const uint32_t vblanks = _state.vblanks;
+
+    if (vblanks < _state.next_swap_vblank) {
+        return;
+    }
+
+    if (!_state.back_ready) {
+        /* Count each missed swap once, then present as soon as the frame is
+         * ready */
+        if (!_state.video_late) {
+            _state.stats.video_underruns++;
+            _state.video_late = true;
+        }
+
+        return;
+    }
+
+    _bitmaps_swap();
+
+    _state.next_swap_vblank += config->video_frame_period;
+
+    /* After an underrun, keep the pace from now on rather than rushing
+     * through the frames that were late */
+    if (_state.next_swap_vblank <= vblanks) {
+        _state.next_swap_vblank = vblanks + config->video_frame_period;
+    }
+
+    _state.video_late = false;
+}
+
+static void
+_audio_advance(void)
+{
+    const fmv_config_t * const config = &_state.config;
+
+    const uint32_t vblanks = _state.vblanks;
+
+    while ((_state.stats.chunks_played < config->audio_chunk_count) &&
+           (vblanks >= _state.next_chunk_vblank)) {
+        _state.stats.chunks_played++;
+        _state.next_chunk_vblank += config->audio_chunk_period;
+
+        /* The half that just started playing should hold the next chunk */
+        if ((_state.stats.chunks_played < config->audio_chunk_count) &&
+            (_state.chunks_transferred <= _state.stats.chunks_played)) {
+            _state.stats.audio_underruns++;
+        }
+    }
+}
+
+static void
+_bitmaps_swap(void)
+{
+    fmv_config_t * const config = &_state.config;
+
+    _state.front ^= 1;
+    _state.back_ready = false;
+
+    config->bitmap_format.bitmap_base = config->bitmap_bases[_state.front];
+
+    vdp2_scrn_bitmap_base_set(&config->bitmap_format);
+
+    _state.stats.frames_presented++;
+}
+
+static void
+_playback_end(fmv_status_t status)
+{
+    _state.status = status;
+
+    /* Pause the drive and disconnect it from the video filter, or else sectors
+     * keep arriving until sector_count runs out */
+    (void)cd_block_cmd_disk_seek(SEEK_PAUSE);
+    (void)cd_block_cmd_cd_dev_connection_set(FILTER_DISCONNECTED);
+
+    /* Drop whatever is left in the partitions */
+    (void)cd_block_cmd_selector_reset(0, FMV_PARTITION_VIDEO);
+    (void)cd_block_cmd_selector_reset(0, FMV_PARTITION_AUDIO);
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) Israel Jacquez
+ * See LICENSE for details.
+ *
+ * Israel Jacquez <mrkotfw@gmail.com>
+ */
+
+#ifndef _YAUL_KERNEL_FS_FMV_H_
+#define _YAUL_KERNEL_FS_FMV_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <sys/cdefs.h>
+#include <sys/callback-list.h>
+
+#include <cd-block.h>
+
+#include <vdp2/scrn_bitmap.h>
+#include <vdp2/vram.h>
+
+__BEGIN_DECLS
+
+/* Streaming playback
+ *
+ * A stream is a run of interleaved Mode 2 Form 1 sectors. Video sectors and
+ * audio sectors are told apart by the channel number in their subheader. The
+ * CD-block filters route video sectors to FMV_PARTITION_VIDEO and audio
+ * sectors to FMV_PARTITION_AUDIO, so neither has to be sorted out on the CPU.
+ *
+ * Each video frame takes video_frame_sector_count sectors, and is either
+ * transferred as is into the back bitmap, or decoded into it by video_decode.
+ * The front and back bitmaps are swapped every video_frame_period vertical
+ * blanks.
+ *
+ * Audio is PCM in a sound RAM buffer of two halves, each holding one chunk of
+ * audio_chunk_sector_count sectors. The sound RAM buffer is expected to be
+ * played by an SCSP slot looping over both halves, taking
+ * audio_chunk_period vertical blanks per half. While one half plays, the
+ * other is refilled.
+ *
+ * Sectors are moved out of the CD-block by CPU-DMAC using
+ * CD_BLOCK_STREAM_DMAC_CHANNEL, so no other CD-block transfers or streams may
+ * be in use at the same time */
+#define FMV_PARTITION_VIDEO (0)
+#define FMV_PARTITION_AUDIO (1)
+
+#define FMV_FILTER_VIDEO    (0)
+#define FMV_FILTER_AUDIO    (1)
+
+typedef enum {
+    FMV_STATUS_IDLE,
+    /* Filling the CD-block partitions before playback starts */
+    FMV_STATUS_PREBUFFERING,
+    FMV_STATUS_PLAYING,
+    FMV_STATUS_DONE,
+    FMV_STATUS_ERROR
+} fmv_status_t;
+
+/* Decode a video frame from sectors into the bitmap */
+typedef void (*fmv_video_decode_t)(const void *sectors, void *bitmap,
+  void *work);
+
+typedef struct {
+    fad_t fad;
+    uint32_t sector_count;
+
+    uint8_t video_channel;
+    uint8_t audio_channel;
+
+    /* The bitmap_base field is ignored, and bitmap_bases is used instead */
+    vdp2_scrn_bitmap_format_t bitmap_format;
+    vdp2_vram_t bitmap_bases[2];
+
+    uint32_t video_frame_count;
+    uint32_t video_frame_sector_count;
+    uint32_t video_frame_period;
+    /* If NULL, the sectors are transferred as is into the back bitmap */
+    fmv_video_decode_t video_decode;
+    /* Buffer of video_frame_sector_count sectors the decoder reads from. Not
+     * needed if video_decode is NULL */
+    void *video_buffer;
+    void *video_work;
+
+    /* Sound RAM buffer of 2 * audio_chunk_sector_count sectors */
+    void *pcm_buffer;
+    uint32_t audio_chunk_count;
+    uint32_t audio_chunk_sector_count;
+    uint32_t audio_chunk_period;
+
+    /* Called once both halves of the sound RAM buffer and the first video
+     * frame are ready. This is where the SCSP slot is to be started. Can be
+     * NULL */
+    callback_handler_t start_handler;
+    void *start_work;
+} fmv_config_t;
+
+typedef struct {
+    uint32_t frames_presented;
+    uint32_t chunks_played;
+    /* Swaps where the next video frame wasn't ready in time */
+    uint32_t video_underruns;
+    /* Halves that started playing before they were refilled */
+    uint32_t audio_underruns;
+} fmv_stats_t;
+
+/* Set up the CD-block filters and partitions, and start reading. Returns the
+ * error from the CD-block, if any */
+extern int fmv_start(const fmv_config_t *config);
+extern void fmv_stop(void);
+
+/* Move sectors out of the CD-block, decode, and present. Call once per frame
+ * from the main loop, before vdp2_sync() */
+extern fmv_status_t fmv_update(void);
+
+/* Advance the playback clock. Call from the VBLANK-OUT handler, e.g. through
+ * vdp_sync_vblank_out_set() */
+extern void fmv_vblank(void *work);
+
+extern fmv_status_t fmv_status_get(void);
+extern const fmv_stats_t *fmv_stats_get(void);
+
+__END_DECLS
+
+#endif /* _YAUL_KERNEL_FS_FMV_H_ */
@@ -0,0 +1,262 @@
+/*
+ * Copyright (c) Israel Jacquez
+ * See LICENSE for details.
+ *
+ * Israel Jacquez <mrkotfw@gmail.com>
+ */
+
+#include <assert.h>
+
+#include "pack.h"
+
+static int _sectors_read(pack_t *pack, uint32_t sector, void *buffer,
+    uint32_t length);
+
+#if __BYTE_ORDER__ != __ORDER_BIG_ENDIAN__
+static void _words_swap(uint32_t *words, uint32_t count);
+#endif /* __BYTE_ORDER__ != __ORDER_BIG_ENDIAN__ */
+
+int
+pack_open(pack_t *pack, fad_t fad, void *buffer, size_t size)
+{
+    assert(pack != NULL);
+    assert(buffer != NULL);
+    assert(((uintptr_t)buffer & 3) == 0);
+
+    pack->fad = fad;
+    pack->entries = NULL;
+    pack->count = 0;
+    pack->sector_count = 0;
+
+    pack_stats_clear(pack);
+
+    /* The header is read along with the rest of the first sector */
+    if (size < CDFS_SECTOR_SIZE) {
+        return -2;
+    }
+
+    int ret;
+
+    if ((ret = _sectors_read(pack, 0, buffer, CDFS_SECTOR_SIZE)) != 0) {
+        return ret;
+    }
+
+    pack_header_t * const header = buffer;
+
+#if __BYTE_ORDER__ != __ORDER_BIG_ENDIAN__
+    /* The pack is big endian, so a little endian host has to swap it */
+    _words_swap((uint32_t *)header, sizeof(pack_header_t) / sizeof(uint32_t));
+#endif /* __BYTE_ORDER__ != __ORDER_BIG_ENDIAN__ */
+
+    if (header->magic != PACK_MAGIC) {
+        return -1;
+    }
+
+    /* Bound both counts before multiplying them out, as a malformed header
+     * could overflow */
+    if ((header->toc_sector_count == 0) ||
+        (header->toc_sector_count > (UINT32_MAX / CDFS_SECTOR_SIZE))) {
+        return -1;
+    }
+
+    const uint32_t toc_size = header->toc_sector_count * CDFS_SECTOR_SIZE;
+    const uint32_t entries_count_max =
+        (toc_size - sizeof(pack_header_t)) / sizeof(pack_entry_t);
+
+    if (header->count > entries_count_max) {
+        return -1;
+    }
+
+    if (toc_size > size) {
+        return -2;
+    }
+
+    /* Read the rest of the table of contents, if any */
+    if (header->toc_sector_count > 1) {
+        uint8_t * const toc_rest = (uint8_t *)buffer + CDFS_SECTOR_SIZE;
+
+        ret = _sectors_read(pack, 1, toc_rest,
+            (header->toc_sector_count - 1) * CDFS_SECTOR_SIZE);
+
+        if (ret != 0) {
+            return ret;
+        }
+    }
+
+    pack_entry_t * const entries = (pack_entry_t *)(header + 1);
+
+#if __BYTE_ORDER__ != __ORDER_BIG_ENDIAN__
+    for (uint32_t i = 0; i < header->count; i++) {
+        /* Every field but the codec is a 32-bit word */
+        _words_swap((uint32_t *)&entries[i], 4);
+    }
+#endif /* __BYTE_ORDER__ != __ORDER_BIG_ENDIAN__ */
+
+    pack->entries = entries;
+    pack->count = header->count;
+    pack->sector_count = header->sector_count;
+
+    return 0;
+}
+
+const pack_entry_t *
+pack_entry_find(const pack_t *pack, uint32_t hash)
+{
+    assert(pack != NULL);
+
+    uint32_t low;
+    low = 0;
+
+    uint32_t high;
+    high = pack->count;
+
+    while (low < high) {
+        const uint32_t mid = (low + high) / 2;
+        const uint32_t mid_hash = pack->entries[mid].hash;
+
+        if (mid_hash == hash) {
+            return &pack->entries[mid];
+        }
+
+        if (mid_hash < hash) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return NULL;
+}
+
+const pack_entry_t *
+pack_entry_path_find(const pack_t *pack, const char *path)
+{
+    assert(path != NULL);
+
+    return pack_entry_find(pack, cdfs_path_hash(path));
+}
+
+int
+pack_entry_read(pack_t *pack, const pack_entry_t *entry, void *buffer)
+{
+    assert(pack != NULL);
+    assert(entry != NULL);
+    assert(buffer != NULL);
+
+    if (entry->size == 0) {
+        return 0;
+    }
+
+    pack->stats.entries_read++;
+
+    return _sectors_read(pack, entry->sector, buffer, entry->size);
+}
+
+size_t
+pack_entries_size_get(const pack_t *pack, const pack_entry_t * const *entries,
+    uint32_t count)
+{
+    assert(pack != NULL);
+    assert(entries != NULL);
+    assert(count > 0);
+
+    uint32_t first_sector;
+    first_sector = entries[0]->sector;
+
+    uint32_t last_sector;
+    last_sector = first_sector;
+
+    for (uint32_t i = 0; i < count; i++) {
+        const pack_entry_t * const entry = entries[i];
+
+        const uint32_t end_sector =
+            entry->sector + pack_entry_sector_count_get(entry);
+
+        if (entry->sector < first_sector) {
+            first_sector = entry->sector;
+        }
+
+        if (end_sector > last_sector) {
+            last_sector = end_sector;
+        }
+    }
+
+    return ((last_sector - first_sector) * CDFS_SECTOR_SIZE);
+}
+
+int
+pack_entries_read(pack_t *pack, const pack_entry_t * const *entries,
+    uint32_t count, void *buffer, void **pointers)
+{
+    assert(pack != NULL);
+    assert(entries != NULL);
+    assert(buffer != NULL);
+    assert(pointers != NULL);
+    assert(count > 0);
+
+    uint32_t first_sector;
+    first_sector = entries[0]->sector;
+
+    for (uint32_t i = 1; i < count; i++) {
+        if (entries[i]->sector < first_sector) {
+            first_sector = entries[i]->sector;
+        }
+    }
+
+    const size_t size = pack_entries_size_get(pack, entries, count);
+
+    for (uint32_t i = 0; i < count; i++) {
+        const uint32_t offset =
+            (entries[i]->sector - first_sector) * CDFS_SECTOR_SIZE;
+
+        pointers[i] = (uint8_t *)buffer + offset;
+    }
+
+    if (size == 0) {
+        return 0;
+    }
+
+    pack->stats.entries_read += count;
+
+    return _sectors_read(pack, first_sector, buffer, size);
+}
+
+const pack_stats_t *
+pack_stats_get(const pack_t *pack)
+{
+    assert(pack != NULL);
+
+    return &pack->stats;
+}
+
+void
+pack_stats_clear(pack_t *pack)
+{
+    assert(pack != NULL);
+
+    pack->stats.reads = 0;
+    pack->stats.sectors_read = 0;
+    pack->stats.entries_read = 0;
+}
+
+static int
+_sectors_read(pack_t *pack, uint32_t sector, void *buffer, uint32_t length)
+{
+    assert((pack->sector_count == 0) ||
+           ((sector + cdfs_sector_count_round(length)) <= pack->sector_count));
+
+    pack->stats.reads++;
+    pack->stats.sectors_read += cdfs_sector_count_round(length);
+
+    return cd_block_sectors_read(pack->fad + sector, buffer, length);
+}
+
+#if __BYTE_ORDER__ != __ORDER_BIG_ENDIAN__
+static void
+_words_swap(uint32_t *words, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++) {
+        words[i] = __builtin_bswap32(words[i]);
+    }
+}
+#endif /* __BYTE_ORDER__ != __ORDER_BIG_ENDIAN__ */
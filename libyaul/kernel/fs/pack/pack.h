@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) Israel Jacquez
+ * See LICENSE for details.
+ *
+ * Israel Jacquez <mrkotfw@gmail.com>
+ */
+
+#ifndef _YAUL_KERNEL_FS_PACK_H_
+#define _YAUL_KERNEL_FS_PACK_H_
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <sys/cdefs.h>
+
+#include <cd-block.h>
+
+#include <fs/cd/cdfs.h>
+
+__BEGIN_DECLS
+
+/* Pack file
+ *
+ * A pack is a single file on disc holding many entries. It starts with a
+ * pack_header_t, followed by a table of contents of pack_entry_t sorted by
+ * hash, padded out to a sector boundary. Each entry then starts on a sector
+ * boundary, in the order given to the packer, so that entries that are loaded
+ * together can be read with a single seek.
+ *
+ * Entries are keyed by the same hash as the cdfs directory index, see
+ * cdfs_path_hash.
+ *
+ * Everything is big endian, and is written by tools/make-pack */
+#define PACK_MAGIC (0x5041434BUL) /* "PACK" */
+
+/* How an entry is stored. Compressed entries are read as is, and are to be
+ * decompressed with the matching libbcl function */
+#define PACK_CODEC_NONE              (0)
+#define PACK_CODEC_LZ                (1)
+#define PACK_CODEC_PRS               (2)
+#define PACK_CODEC_RLE               (3)
+#define PACK_CODEC_HUFFMAN           (4)
+#define PACK_CODEC_LZ4               (5)
+#define PACK_CODEC_HUFFMAN_CANONICAL (6)
+
+typedef struct {
+    uint32_t magic;
+    uint32_t count;
+    /* Sectors taken by the header and the table of contents */
+    uint32_t toc_sector_count;
+    /* Sectors taken by the whole pack */
+    uint32_t sector_count;
+} __aligned(4) pack_header_t;
+
+static_assert(sizeof(pack_header_t) == 16);
+
+typedef struct {
+    uint32_t hash;
+    /* Sector relative to the start of the pack */
+    uint32_t sector;
+    /* Size as stored in the pack */
+    uint32_t size;
+    /* Size once decompressed */
+    uint32_t unpacked_size;
+    uint8_t codec;
+    uint8_t reserved[3];
+} __aligned(4) pack_entry_t;
+
+static_assert(sizeof(pack_entry_t) == 20);
+
+typedef struct {
+    /* Number of CD reads, each costing a seek */
+    uint32_t reads;
+    uint32_t sectors_read;
+    uint32_t entries_read;
+} pack_stats_t;
+
+typedef struct {
+    fad_t fad;
+    const pack_entry_t *entries;
+    uint32_t count;
+    uint32_t sector_count;
+    pack_stats_t stats;
+} pack_t;
+
+static inline uint32_t __always_inline
+pack_entry_sector_count_get(const pack_entry_t *entry)
+{
+    return cdfs_sector_count_round(entry->size);
+}
+
+/* Open the pack starting at the given FAD. The table of contents is read into
+ * buffer, which must stay around for as long as the pack is in use.
+ *
+ * Returns -1 if the pack is invalid, -2 if buffer is smaller than a sector or
+ * can't hold the table of contents, or the error from the CD block */
+extern int pack_open(pack_t *pack, fad_t fad, void *buffer, size_t size);
+
+extern const pack_entry_t *pack_entry_find(const pack_t *pack, uint32_t hash);
+extern const pack_entry_t *pack_entry_path_find(const pack_t *pack,
+  const char *path);
+
+/* Read an entry as stored. Buffer must be able to hold
+ * pack_entry_sector_count_get() sectors */
+extern int pack_entry_read(pack_t *pack, const pack_entry_t *entry,
+  void *buffer);
+
+/* Size of the buffer needed to read a group of entries with
+ * pack_entries_read. This spans from the first to the last sector of the
+ * entries, including any entries in between */
+extern size_t pack_entries_size_get(const pack_t *pack,
+  const pack_entry_t * const *entries, uint32_t count);
+
+/* Read a group of entries with a single CD read. On return, pointers[i] points
+ * to the data of entries[i] within buffer.
+ *
+ * Entries that are loaded together should be placed next to one another by the
+ * packer, or else the sectors in between are also read */
+extern int pack_entries_read(pack_t *pack, const pack_entry_t * const *entries,
+  uint32_t count, void *buffer, void **pointers);
+
+extern const pack_stats_t *pack_stats_get(const pack_t *pack);
+extern void pack_stats_clear(pack_t *pack);
+
+__END_DECLS
+
+#endif /* _YAUL_KERNEL_FS_PACK_H_ */
@@ -48,4 +48,7 @@ typedef struct cd_block_regs {
 
 extern int cd_block_cmd_execute(struct cd_block_regs *, struct cd_block_regs *);
 
+extern void __cd_block_irq_update(void);
+extern void __cd_block_stream_sector_ready(void);
+
 #endif /* !_CD_BLOCK_INTERNAL_H_ */
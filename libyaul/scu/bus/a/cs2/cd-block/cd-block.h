@@ -14,10 +14,15 @@
 
 #include <cpu/dmac.h>
 
+#include <sys/callback-list.h>
+
 #include <cd-block/cmd.h>
 
 #define CDFS_SECTOR_SIZE (2048U)
 
+/* Default CPU-DMAC channel used to stream sectors */
+#define CD_BLOCK_STREAM_DMAC_CHANNEL (1)
+
 __BEGIN_DECLS
 
 /**
@@ -78,6 +83,206 @@ extern int cd_block_sector_read(fad_t fad, void *output_buffer);
  */
 extern int cd_block_sectors_read(fad_t fad, void *output_buffer, uint32_t length);
 
+/**
+ * Read multiple sectors directly into VDP1 VRAM, VDP2 VRAM, sound RAM, or
+ * work RAM using the CPU-DMAC, without a bounce buffer. The data port is read,
+ * and the destination written, 16-bits at a time.
+ *
+ * @param fad    FAD to start reading from.
+ * @param dst    Destination. Must be 2-byte aligned.
+ * @param length Length in bytes.
+ * @param ch     CPU-DMAC channel to use.
+ */
+extern int cd_block_sectors_read_dmac(fad_t fad, void *dst, uint32_t length, cpu_dmac_channel_t ch);
+
+/**
+ * Wait for sectors to be read into the CD-block buffer.
+ *
+ * @param work Pointer passed to cd_block_sectors_read_custom().
+ *
+ * @return The number of sectors ready, which must be more than zero, or a
+ *         negative error.
+ */
+typedef int (*cd_block_sectors_wait_t)(void *work);
+
+/**
+ * Move bytes of the sectors ready from the CD-block buffer to dst, then delete
+ * them from the CD-block buffer.
+ *
+ * @param dst    Destination.
+ * @param length Length in bytes.
+ * @param work   Pointer passed to cd_block_sectors_read_custom().
+ *
+ * @return 0 on success, or the error from the CD-block.
+ */
+typedef int (*cd_block_sectors_transfer_t)(void *dst, uint32_t length, void *work);
+
+/**
+ * Read multiple sectors, with the wait and the transfer of each batch of
+ * sectors left to the caller. cd_block_sectors_read() and
+ * cd_block_sectors_read_dmac() are built on this.
+ *
+ * @param fad      FAD to start reading from.
+ * @param dst      Destination.
+ * @param length   Length in bytes.
+ * @param wait     Wait for sectors. If NULL, the CD-block is polled.
+ * @param transfer Transfer the sectors ready. If NULL, the CPU copies them,
+ *                 as with cd_block_transfer_data().
+ * @param work     Pointer passed to wait and transfer.
+ */
+extern int cd_block_sectors_read_custom(fad_t fad, void *dst, uint32_t length,
+    cd_block_sectors_wait_t wait, cd_block_sectors_transfer_t transfer,
+    void *work);
+
+/**
+ * Set the callback invoked from the CD-block (A-Bus) interrupt each time a
+ * sector has been read into the CD-block buffer.
+ *
+ * @param callback_handler Callback. Passing NULL disables the interrupt.
+ * @param work             Pointer passed to the callback.
+ */
+extern void cd_block_sector_ready_set(callback_handler_t callback_handler, void *work);
+
+/**
+ * Start streaming sectors into memory without blocking.
+ *
+ * Each time the CD-block reports that sectors have been read, they're moved to
+ * the buffer by CPU-DMAC. The interrupt handlers only take note of it, so
+ * cd_block_stream_service() has to be called regularly to issue the CD-block
+ * commands and start the transfers. The buffer can be in VDP1 VRAM, VDP2 VRAM,
+ * or sound RAM, as long as it's 2-byte aligned. The drive connection is only
+ * set up once and kept across streams.
+ *
+ * No other CD-block commands may be issued while a stream is busy.
+ *
+ * @param fad              FAD to start reading from.
+ * @param sector_count     Number of sectors to read.
+ * @param buffer           Buffer of sector_count * CDFS_SECTOR_SIZE bytes.
+ * @param callback_handler Called from cd_block_stream_service() once the
+ *                         stream ends. Can be NULL.
+ * @param work             Pointer passed to the callback.
+ *
+ * @return 0 on success, or -1 if a stream is already busy.
+ */
+extern int cd_block_stream_start(fad_t fad, uint32_t sector_count, void *buffer,
+    callback_handler_t callback_handler, void *work);
+
+/**
+ * Stop the stream. Sectors already transferred remain in the buffer.
+ */
+extern void cd_block_stream_stop(void);
+
+/**
+ * Move the sectors that have been read to the buffer, and end the stream once
+ * all of them are in. Call at least once per frame while the stream is busy,
+ * e.g. from the main loop. Not to be called from an interrupt handler.
+ *
+ * @return true if the stream is still busy.
+ */
+extern bool cd_block_stream_service(void);
+
+/**
+ * Return if the stream is busy.
+ */
+extern bool cd_block_stream_busy(void);
+
+/**
+ * Return the number of sectors of the stream that are in the buffer.
+ */
+extern uint32_t cd_block_stream_sectors_available(void);
+
+/**
+ * Return the error the last stream ended with, or 0.
+ */
+extern int cd_block_stream_error_get(void);
+
+/**
+ * Set the CPU-DMAC channel used to stream sectors.
+ */
+extern void cd_block_stream_dmac_channel_set(cpu_dmac_channel_t channel);
+
+/* Requests are dispatched highest priority first, unless a deadline is due */
+#define CD_BLOCK_REQUEST_PRIORITY_LOW    (0)
+#define CD_BLOCK_REQUEST_PRIORITY_NORMAL (1)
+#define CD_BLOCK_REQUEST_PRIORITY_HIGH   (2)
+
+/* No deadline */
+#define CD_BLOCK_REQUEST_DEADLINE_NONE   (0)
+
+typedef struct cd_block_request cd_block_request_t;
+
+/**
+ * A read request for the CD-block request queue. Fill in the public fields,
+ * then submit with cd_block_queue_submit(). The request must stay around until
+ * its callback is called.
+ */
+struct cd_block_request {
+    /* FAD to start reading from */
+    fad_t fad;
+    /* Length in bytes */
+    uint32_t length;
+    void *buffer;
+    uint8_t priority;
+    /* Time by which the request should be dispatched, in the same unit as the
+     * time passed to cd_block_queue_service(), or
+     * CD_BLOCK_REQUEST_DEADLINE_NONE */
+    uint32_t deadline;
+    /* Called once the request is complete. Can be NULL */
+    callback_handler_t callback_handler;
+    void *work;
+
+    /* 0 on success, or the error from the CD-block */
+    int status;
+
+    /* Private */
+    cd_block_request_t *next;
+};
+
+typedef struct {
+    uint32_t requests;
+    /* Reads issued, each costing a seek */
+    uint32_t reads;
+    /* Requests that were merged into the read of another request */
+    uint32_t seeks_avoided;
+    /* Bytes of requests that were merged into the read of another request */
+    uint32_t bytes_merged;
+} cd_block_queue_stats_t;
+
+/**
+ * Initialize the CD-block request queue. Any pending requests are dropped.
+ */
+extern void cd_block_queue_init(void);
+
+/**
+ * Add a read request to the queue. Can be called from an interrupt handler.
+ *
+ * @param request The request.
+ */
+extern void cd_block_queue_submit(cd_block_request_t *request);
+
+/**
+ * Dispatch the next read from the queue, and wait for it to complete.
+ *
+ * The next read is the request whose deadline is the most overdue, if any.
+ * Otherwise, it's the request of the highest priority that's next in the
+ * sweep across the disc by ascending FAD. Any other pending requests that are
+ * contiguous with or overlap the read are merged into it, so that a single
+ * cd_block_cmd_disk_play() is issued.
+ *
+ * @param now The current time, e.g. the frame count.
+ *
+ * @return The number of requests completed.
+ */
+extern uint32_t cd_block_queue_service(uint32_t now);
+
+/**
+ * Return the number of pending requests.
+ */
+extern uint32_t cd_block_queue_pending_count(void);
+
+extern const cd_block_queue_stats_t *cd_block_queue_stats_get(void);
+extern void cd_block_queue_stats_clear(void);
+
 __END_DECLS
 
 #endif /* !_YAUL_CD_BLOCK_H_ */
@@ -8,6 +8,7 @@
 
 #include <cd-block.h>
 
+#include <cpu/cache.h>
 #include <cpu/instructions.h>
 
 #include <smpc/smc.h>
@@ -19,6 +20,10 @@
 #define FAKE_SECTOR_SIZE        2352
 #define FAKE_NUM_SECTORS        150
 
+static int _sectors_wait(void);
+static int _sectors_transfer(void *dst, uint32_t length, void *work);
+static int _sectors_transfer_dmac(void *dst, uint32_t length, void *work);
+
 static int _status_flags_get(uint8_t *flags);
 static int _hirq_flag_wait(uint16_t flag);
 static int _cd_block_auth(void);
@@ -214,6 +219,7 @@ cd_block_transfer_data_dmac(uint16_t offset, uint16_t buffer_number,
   uint8_t *output_buffer, uint32_t buffer_length, cpu_dmac_channel_t ch)
 {
     assert(output_buffer != NULL);
+    assert(((uintptr_t)output_buffer & 0x01) == 0x00000000);
     assert(buffer_length > 0);
 
     const uint32_t sectors_to_read = (buffer_length + (CDFS_SECTOR_SIZE - 1)) / CDFS_SECTOR_SIZE;
@@ -255,11 +261,22 @@ cd_block_transfer_data_dmac(uint16_t offset, uint16_t buffer_number,
     cpu_dmac_channel_start(ch);
     cpu_dmac_channel_wait(ch);
 
-    /* If odd number of bytes, read the last one separated */
+    /* If odd number of bytes, read the last one separated. VDP1 VRAM, VDP2
+     * VRAM, and sound RAM are written to 16-bits at a time, so merge the byte
+     * into the existing word */
     if (to_read < buffer_length) {
         const uint16_t tmp = MEMORY_READ(16, CD_BLOCK(DTR));
 
-        output_buffer[buffer_length - 1] = (tmp >> 8) & 0xFF;
+        volatile uint16_t * const last_word =
+            (volatile uint16_t *)&output_buffer[buffer_length - 1];
+
+        *last_word = (tmp & 0xFF00) | (*last_word & 0x00FF);
+    }
+
+    /* The CPU-DMAC bypasses the cache, so drop any stale lines when the
+     * destination is cached */
+    if (((uintptr_t)output_buffer & CPU_CACHE_THROUGH) == 0x00000000) {
+        cpu_cache_area_purge(output_buffer, buffer_length);
     }
 
     if ((ret = cd_block_cmd_data_transfer_end()) != 0) {
@@ -307,12 +324,32 @@ cd_block_sector_read(fad_t fad, void *output_buffer)
 
 int
 cd_block_sectors_read(fad_t fad, void *output_buffer, uint32_t length)
+{
+    return cd_block_sectors_read_custom(fad, output_buffer, length, NULL, NULL,
+        NULL);
+}
+
+int
+cd_block_sectors_read_dmac(fad_t fad, void *dst, uint32_t length,
+  cpu_dmac_channel_t ch)
+{
+    assert(((uintptr_t)dst & 0x01) == 0x00000000);
+
+    return cd_block_sectors_read_custom(fad, dst, length, NULL,
+        _sectors_transfer_dmac, &ch);
+}
+
+int
+cd_block_sectors_read_custom(fad_t fad, void *dst, uint32_t length,
+    cd_block_sectors_wait_t wait, cd_block_sectors_transfer_t transfer,
+    void *work)
 {
     assert(fad >= 150);
-    assert(output_buffer != NULL);
+    assert(dst != NULL);
     assert(length > 0);
 
-    uint8_t *buffer_ptr = (uint8_t *)output_buffer;
+    uint8_t *dst_ptr;
+    dst_ptr = dst;
 
     /* Get the sector count from length */
     const uint32_t sector_count = (length + (CDFS_SECTOR_SIZE - 1)) / CDFS_SECTOR_SIZE;
@@ -331,37 +368,69 @@ cd_block_sectors_read(fad_t fad, void *output_buffer, uint32_t length)
         return ret;
     }
 
-    uint32_t bytes_missing = length;
+    uint32_t bytes_missing;
+    bytes_missing = length;
 
     while (bytes_missing > 0) {
         /* Wait until there's data ready */
-        uint32_t sectors_ready;
+        const int sectors_ready = (wait != NULL) ? wait(work) : _sectors_wait();
 
-        do {
-            sectors_ready = cd_block_cmd_sector_number_get(0);
-        } while (sectors_ready == 0);
+        if (sectors_ready < 0) {
+            return sectors_ready;
+        }
 
         uint32_t bytes_to_read;
+        bytes_to_read = sectors_ready * CDFS_SECTOR_SIZE;
 
-        if ((sectors_ready * CDFS_SECTOR_SIZE) > bytes_missing) {
+        if (bytes_to_read > bytes_missing) {
             bytes_to_read = bytes_missing;
-        } else {
-            bytes_to_read = sectors_ready * CDFS_SECTOR_SIZE;
         }
 
         /* Setup a transfer from CD buffer to buffer, then delete data
          * from CD buffer */
-        if ((ret = cd_block_transfer_data(0, 0, buffer_ptr, bytes_to_read)) != 0) {
+        ret = (transfer != NULL)
+            ? transfer(dst_ptr, bytes_to_read, work)
+            : _sectors_transfer(dst_ptr, bytes_to_read, work);
+
+        if (ret != 0) {
             return ret;
         }
 
-        buffer_ptr += bytes_to_read;
+        dst_ptr += bytes_to_read;
         bytes_missing -= bytes_to_read;
     }
 
     return 0;
 }
 
+static int
+_sectors_wait(void)
+{
+    int sectors_ready;
+
+    do {
+        sectors_ready = cd_block_cmd_sector_number_get(0);
+    } while (sectors_ready == 0);
+
+    return sectors_ready;
+}
+
+static int
+_sectors_transfer(void *dst, uint32_t length, void *work __unused)
+{
+    return cd_block_transfer_data(0, 0, dst, length);
+}
+
+static int
+_sectors_transfer_dmac(void *dst, uint32_t length, void *work)
+{
+    const cpu_dmac_channel_t * const ch = work;
+
+    /* Move directly from the CD-block data port to the destination, without a
+     * bounce buffer */
+    return cd_block_transfer_data_dmac(0, 0, dst, length, *ch);
+}
+
 static int
 _status_flags_get(uint8_t *flags)
 {
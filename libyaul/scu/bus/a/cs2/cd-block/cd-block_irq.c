@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) Israel Jacquez
+ * See LICENSE for details.
+ *
+ * Israel Jacquez <mrkotfw@gmail.com>
+ */
+
+#include <cd-block.h>
+
+#include <cpu/intc.h>
+
+#include <scu/ic.h>
+
+#include <sys/callback-list.h>
+
+#include "cd-block-internal.h"
+
+static void _abus_handler(void);
+
+static callback_t _sector_ready_callback;
+static bool _sector_ready_set;
+static bool _irq_enabled;
+
+void
+cd_block_sector_ready_set(callback_handler_t callback_handler, void *work)
+{
+    const uint8_t sr_mask = cpu_intc_mask_get();
+    cpu_intc_mask_set(15);
+
+    if (callback_handler == NULL) {
+        callback_init(&_sector_ready_callback);
+    } else {
+        callback_set(&_sector_ready_callback, callback_handler, work);
+    }
+
+    _sector_ready_set = (callback_handler != NULL);
+
+    __cd_block_irq_update();
+
+    cpu_intc_mask_set(sr_mask);
+}
+
+void
+__cd_block_irq_update(void)
+{
+    const uint8_t sr_mask = cpu_intc_mask_get();
+    cpu_intc_mask_set(15);
+
+    const bool enable = _sector_ready_set || cd_block_stream_busy();
+
+    if (enable && !_irq_enabled) {
+        scu_ic_ihr_set(SCU_IC_INTERRUPT_EXTERNAL_00, _abus_handler);
+
+        /* Only raise the CD-block interrupt when a sector has been read */
+        MEMORY_WRITE(16, CD_BLOCK(HIRQ_MASK), CSCT);
+        MEMORY_WRITE(32, SCU(AIACK), 0x00000001);
+
+        scu_ic_mask_chg(SCU_IC_MASK_ALL & ~SCU_IC_MASK_A_BUS, SCU_IC_MASK_NONE);
+    } else if (!enable && _irq_enabled) {
+        MEMORY_WRITE(16, CD_BLOCK(HIRQ_MASK), 0x0000);
+
+        scu_ic_mask_chg(SCU_IC_MASK_ALL, SCU_IC_MASK_A_BUS);
+        scu_ic_ihr_clear(SCU_IC_INTERRUPT_EXTERNAL_00);
+    }
+
+    _irq_enabled = enable;
+
+    cpu_intc_mask_set(sr_mask);
+}
+
+static void
+_abus_handler(void)
+{
+    const uint16_t hirq = MEMORY_READ(16, CD_BLOCK(HIRQ));
+
+    if ((hirq & CSCT) != 0) {
+        /* Writing zero to a bit clears it, writing one leaves it unchanged */
+        MEMORY_WRITE(16, CD_BLOCK(HIRQ), ~CSCT);
+
+        __cd_block_stream_sector_ready();
+
+        if (_sector_ready_set) {
+            callback_call(&_sector_ready_callback);
+        }
+    }
+
+    /* Acknowledge the A-Bus interrupt so that the next one can be raised */
+    MEMORY_WRITE(32, SCU(AIACK), 0x00000001);
+}
@@ -0,0 +1,360 @@
+/*
+ * Copyright (c) Israel Jacquez
+ * See LICENSE for details.
+ *
+ * Israel Jacquez <mrkotfw@gmail.com>
+ */
+
+#include <assert.h>
+#include <string.h>
+
+#include <cd-block.h>
+
+#include <cpu/intc.h>
+
+static struct {
+    /* Pending requests, sorted by FAD */
+    cd_block_request_t *pending;
+    uint32_t pending_count;
+    /* Where the previous read ended, which is where the sweep continues */
+    fad_t head_fad;
+
+    cd_block_queue_stats_t stats;
+} _state;
+
+static uint8_t _sector[CDFS_SECTOR_SIZE] __aligned(4);
+
+static cd_block_request_t *_lead_select(uint32_t now);
+static cd_block_request_t *_run_extract(cd_block_request_t *lead,
+    fad_t *start_fad, fad_t *end_fad);
+static int _run_read(cd_block_request_t *run, fad_t start_fad, fad_t end_fad);
+static int _sector_transfer(cd_block_request_t *run, fad_t fad);
+
+static inline fad_t __always_inline
+_request_end_fad(const cd_block_request_t *request)
+{
+    return (request->fad +
+        ((request->length + (CDFS_SECTOR_SIZE - 1)) / CDFS_SECTOR_SIZE));
+}
+
+void
+cd_block_queue_init(void)
+{
+    _state.pending = NULL;
+    _state.pending_count = 0;
+    _state.head_fad = 0;
+
+    cd_block_queue_stats_clear();
+}
+
+void
+cd_block_queue_submit(cd_block_request_t *request)
+{
+    assert(request != NULL);
+    assert(request->fad >= 150);
+    assert(request->length > 0);
+    assert(request->buffer != NULL);
+
+    request->status = 0;
+
+    const uint8_t sr_mask = cpu_intc_mask_get();
+    cpu_intc_mask_set(15);
+
+    cd_block_request_t **link;
+    link = &_state.pending;
+
+    while ((*link != NULL) && ((*link)->fad <= request->fad)) {
+        link = &(*link)->next;
+    }
+
+    request->next = *link;
+    *link = request;
+
+    _state.pending_count++;
+    _state.stats.requests++;
+
+    cpu_intc_mask_set(sr_mask);
+}
+
+uint32_t
+cd_block_queue_service(uint32_t now)
+{
+    const uint8_t sr_mask = cpu_intc_mask_get();
+    cpu_intc_mask_set(15);
+
+    cd_block_request_t * const lead = _lead_select(now);
+
+    if (lead == NULL) {
+        cpu_intc_mask_set(sr_mask);
+
+        return 0;
+    }
+
+    fad_t start_fad;
+    fad_t end_fad;
+
+    cd_block_request_t * const run = _run_extract(lead, &start_fad, &end_fad);
+
+    cpu_intc_mask_set(sr_mask);
+
+    const int ret = _run_read(run, start_fad, end_fad);
+
+    _state.head_fad = end_fad;
+
+    uint32_t completed;
+    completed = 0;
+
+    cd_block_request_t *request;
+    request = run;
+
+    while (request != NULL) {
+        /* The callback is free to resubmit the request */
+        cd_block_request_t * const next = request->next;
+
+        request->status = ret;
+        request->next = NULL;
+
+        if (request != lead) {
+            _state.stats.seeks_avoided++;
+            _state.stats.bytes_merged += request->length;
+        }
+
+        if (request->callback_handler != NULL) {
+            request->callback_handler(request->work);
+        }
+
+        completed++;
+
+        request = next;
+    }
+
+    _state.stats.reads++;
+
+    return completed;
+}
+
+uint32_t
+cd_block_queue_pending_count(void)
+{
+    return _state.pending_count;
+}
+
+const cd_block_queue_stats_t *
+cd_block_queue_stats_get(void)
+{
+    return &_state.stats;
+}
+
+void
+cd_block_queue_stats_clear(void)
+{
+    _state.stats.requests = 0;
+    _state.stats.reads = 0;
+    _state.stats.seeks_avoided = 0;
+    _state.stats.bytes_merged = 0;
+}
+
+/* Interrupts must be masked */
+static cd_block_request_t *
+_lead_select(uint32_t now)
+{
+    cd_block_request_t *overdue;
+    overdue = NULL;
+
+    uint8_t priority;
+    priority = 0;
+
+    for (cd_block_request_t *request = _state.pending; request != NULL;
+         request = request->next) {
+        if (request->deadline != CD_BLOCK_REQUEST_DEADLINE_NONE) {
+            const int32_t slack = (int32_t)(request->deadline - now);
+
+            if ((slack <= 0) &&
+                ((overdue == NULL) ||
+                 ((int32_t)(request->deadline - overdue->deadline) < 0))) {
+                overdue = request;
+            }
+        }
+
+        if (request->priority > priority) {
+            priority = request->priority;
+        }
+    }
+
+    if (overdue != NULL) {
+        return overdue;
+    }
+
+    /* Sweep by ascending FAD from where the previous read ended, and wrap
+     * around to the lowest FAD once the end has been reached */
+    cd_block_request_t *lowest;
+    lowest = NULL;
+
+    for (cd_block_request_t *request = _state.pending; request != NULL;
+         request = request->next) {
+        if (request->priority != priority) {
+            continue;
+        }
+
+        if (request->fad >= _state.head_fad) {
+            return request;
+        }
+
+        if (lowest == NULL) {
+            lowest = request;
+        }
+    }
+
+    return lowest;
+}
+
+/* Move the lead request, and every pending request that is contiguous with or
+ * overlaps the range being read, from the pending list to the run list.
+ * Interrupts must be masked */
+static cd_block_request_t *
+_run_extract(cd_block_request_t *lead, fad_t *start_fad, fad_t *end_fad)
+{
+    cd_block_request_t *run;
+    run = NULL;
+
+    cd_block_request_t **run_link;
+    run_link = &run;
+
+    *start_fad = lead->fad;
+    *end_fad = _request_end_fad(lead);
+
+    /* As the pending list is sorted by FAD, any request that precedes the
+     * lead and extends the range backwards also makes its predecessors
+     * eligible, so walk until the range stops changing */
+    bool extended;
+
+    do {
+        extended = false;
+
+        cd_block_request_t **link;
+        link = &_state.pending;
+
+        while (*link != NULL) {
+            cd_block_request_t * const request = *link;
+
+            const fad_t request_end_fad = _request_end_fad(request);
+
+            if ((request != lead) &&
+                ((request->fad > *end_fad) || (request_end_fad < *start_fad))) {
+                link = &request->next;
+
+                continue;
+            }
+
+            if (request->fad < *start_fad) {
+                *start_fad = request->fad;
+                extended = true;
+            }
+
+            if (request_end_fad > *end_fad) {
+                *end_fad = request_end_fad;
+                extended = true;
+            }
+
+            *link = request->next;
+
+            request->next = NULL;
+            *run_link = request;
+            run_link = &request->next;
+
+            _state.pending_count--;
+        }
+    } while (extended);
+
+    return run;
+}
+
+static int
+_run_read(cd_block_request_t *run, fad_t start_fad, fad_t end_fad)
+{
+    int ret;
+
+    if ((ret = cd_block_cmd_selector_reset(0, 0)) != 0) {
+        return ret;
+    }
+
+    if ((ret = cd_block_cmd_cd_dev_connection_set(0)) != 0) {
+        return ret;
+    }
+
+    if ((ret = cd_block_cmd_disk_play(0, start_fad, end_fad - start_fad)) != 0) {
+        return ret;
+    }
+
+    for (fad_t fad = start_fad; fad < end_fad; fad++) {
+        /* Wait until there's data ready */
+        while ((cd_block_cmd_sector_number_get(0)) == 0) {
+        }
+
+        if ((ret = _sector_transfer(run, fad)) != 0) {
+            return ret;
+        }
+    }
+
+    return 0;
+}
+
+/* Transfer a sector to each request of the run that covers it */
+static int
+_sector_transfer(cd_block_request_t *run, fad_t fad)
+{
+    cd_block_request_t *only;
+    only = NULL;
+
+    uint32_t covering_count;
+    covering_count = 0;
+
+    for (cd_block_request_t *request = run; request != NULL;
+         request = request->next) {
+        if ((fad >= request->fad) && (fad < _request_end_fad(request))) {
+            only = request;
+            covering_count++;
+        }
+    }
+
+    /* The run is contiguous, so every sector is covered at least once */
+    assert(covering_count > 0);
+
+    if (covering_count == 1) {
+        const uint32_t offset = (fad - only->fad) * CDFS_SECTOR_SIZE;
+        uint8_t * const dst = (uint8_t *)only->buffer + offset;
+
+        /* Transfer straight into the request buffer when a whole sector fits
+         * and the buffer can be written 16-bits at a time */
+        if (((offset + CDFS_SECTOR_SIZE) <= only->length) &&
+            (((uintptr_t)dst & 0x01) == 0x00000000)) {
+            return cd_block_transfer_data(0, 0, dst, CDFS_SECTOR_SIZE);
+        }
+    }
+
+    int ret;
+
+    if ((ret = cd_block_transfer_data(0, 0, _sector, CDFS_SECTOR_SIZE)) != 0) {
+        return ret;
+    }
+
+    for (cd_block_request_t *request = run; request != NULL;
+         request = request->next) {
+        if ((fad < request->fad) || (fad >= _request_end_fad(request))) {
+            continue;
+        }
+
+        const uint32_t offset = (fad - request->fad) * CDFS_SECTOR_SIZE;
+
+        uint32_t length;
+        length = request->length - offset;
+
+        if (length > CDFS_SECTOR_SIZE) {
+            length = CDFS_SECTOR_SIZE;
+        }
+
+        (void)memcpy((uint8_t *)request->buffer + offset, _sector, length);
+    }
+
+    return 0;
+}
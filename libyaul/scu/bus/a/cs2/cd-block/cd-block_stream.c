@@ -0,0 +1,320 @@
+/*
+ * Copyright (c) Israel Jacquez
+ * See LICENSE for details.
+ *
+ * Israel Jacquez <mrkotfw@gmail.com>
+ */
+
+#include <cd-block.h>
+
+#include <cpu/cache.h>
+#include <cpu/dmac.h>
+#include <cpu/intc.h>
+
+#include <sys/callback-list.h>
+
+#include "cd-block-internal.h"
+
+#define STREAM_FLAG_BUSY         0x01
+#define STREAM_FLAG_TRANSFERRING 0x02
+#define STREAM_FLAG_CONFIGURED   0x04
+/* Sectors may have been left in the CD-block buffer partition */
+#define STREAM_FLAG_DIRTY        0x08
+
+#define DRDY_WAIT_COUNT          0x00240000
+
+static struct {
+    volatile uint8_t flags;
+    volatile int error;
+
+    uint8_t *buffer;
+    uint32_t sector_count;
+    /* Sectors that have been transferred to the buffer */
+    volatile uint32_t sectors_transferred;
+    /* Sectors in the transfer currently in flight */
+    uint32_t sectors_in_flight;
+
+    /* Set by the interrupt handlers, and handled by
+     * cd_block_stream_service() */
+    volatile bool sector_ready;
+    volatile bool transferred;
+
+    cpu_dmac_channel_t channel;
+
+    callback_t callback;
+} _stream = {
+    .channel = CD_BLOCK_STREAM_DMAC_CHANNEL
+};
+
+static void _pump(void);
+static void _transfer_end(void);
+static void _dmac_handler(void *work);
+static void _stream_end(int error);
+
+int
+cd_block_stream_start(fad_t fad, uint32_t sector_count, void *buffer,
+    callback_handler_t callback_handler, void *work)
+{
+    assert(fad >= 150);
+    assert(sector_count > 0);
+    assert(buffer != NULL);
+    assert(((uintptr_t)buffer & 0x01) == 0x00000000);
+
+    if ((_stream.flags & STREAM_FLAG_BUSY) != 0) {
+        return -1;
+    }
+
+    int ret;
+
+    /* Only set up the drive connection once, instead of for every read */
+    if ((_stream.flags & STREAM_FLAG_CONFIGURED) == 0) {
+        if ((ret = cd_block_cmd_sector_length_set(SECTOR_LENGTH_2048)) != 0) {
+            return ret;
+        }
+
+        if ((ret = cd_block_cmd_cd_dev_connection_set(0)) != 0) {
+            return ret;
+        }
+
+        _stream.flags |= STREAM_FLAG_CONFIGURED | STREAM_FLAG_DIRTY;
+    }
+
+    if ((_stream.flags & STREAM_FLAG_DIRTY) != 0) {
+        if ((ret = cd_block_cmd_selector_reset(0, 0)) != 0) {
+            return ret;
+        }
+
+        _stream.flags &= ~STREAM_FLAG_DIRTY;
+    }
+
+    _stream.error = 0;
+    _stream.buffer = buffer;
+    _stream.sector_count = sector_count;
+    _stream.sectors_transferred = 0;
+    _stream.sectors_in_flight = 0;
+    _stream.sector_ready = false;
+    _stream.transferred = false;
+
+    if (callback_handler == NULL) {
+        callback_init(&_stream.callback);
+    } else {
+        callback_set(&_stream.callback, callback_handler, work);
+    }
+
+    _stream.flags |= STREAM_FLAG_BUSY;
+
+    __cd_block_irq_update();
+
+    if ((ret = cd_block_cmd_disk_play(0, fad, sector_count)) != 0) {
+        _stream.flags &= ~STREAM_FLAG_BUSY;
+        _stream.flags |= STREAM_FLAG_DIRTY;
+
+        __cd_block_irq_update();
+
+        return ret;
+    }
+
+    return 0;
+}
+
+void
+cd_block_stream_stop(void)
+{
+    const uint8_t sr_mask = cpu_intc_mask_get();
+    cpu_intc_mask_set(15);
+
+    if ((_stream.flags & STREAM_FLAG_TRANSFERRING) != 0) {
+        cpu_dmac_channel_stop(_stream.channel);
+
+        (void)cd_block_cmd_data_transfer_end();
+    }
+
+    _stream.flags &= ~(STREAM_FLAG_BUSY | STREAM_FLAG_TRANSFERRING);
+    _stream.flags |= STREAM_FLAG_DIRTY;
+    _stream.sector_ready = false;
+    _stream.transferred = false;
+
+    __cd_block_irq_update();
+
+    cpu_intc_mask_set(sr_mask);
+}
+
+bool
+cd_block_stream_service(void)
+{
+    const uint8_t sr_mask = cpu_intc_mask_get();
+    cpu_intc_mask_set(15);
+
+    const bool sector_ready = _stream.sector_ready;
+    const bool transferred = _stream.transferred;
+
+    _stream.sector_ready = false;
+    _stream.transferred = false;
+
+    cpu_intc_mask_set(sr_mask);
+
+    if (transferred) {
+        _transfer_end();
+    }
+
+    /* Sectors that were read during the transfer didn't get pumped */
+    if (sector_ready || transferred) {
+        _pump();
+    }
+
+    return cd_block_stream_busy();
+}
+
+bool
+cd_block_stream_busy(void)
+{
+    return ((_stream.flags & STREAM_FLAG_BUSY) != 0);
+}
+
+uint32_t
+cd_block_stream_sectors_available(void)
+{
+    return _stream.sectors_transferred;
+}
+
+int
+cd_block_stream_error_get(void)
+{
+    return _stream.error;
+}
+
+void
+cd_block_stream_dmac_channel_set(cpu_dmac_channel_t channel)
+{
+    assert(channel <= 1);
+    assert((_stream.flags & STREAM_FLAG_BUSY) == 0);
+
+    _stream.channel = channel;
+}
+
+void
+__cd_block_stream_sector_ready(void)
+{
+    /* Called from the A-Bus interrupt handler, where there's no time to issue
+     * commands and wait on the CD-block */
+    _stream.sector_ready = true;
+}
+
+static void
+_pump(void)
+{
+    if ((_stream.flags & (STREAM_FLAG_BUSY | STREAM_FLAG_TRANSFERRING)) != STREAM_FLAG_BUSY) {
+        return;
+    }
+
+    const int sectors_ready = cd_block_cmd_sector_number_get(0);
+
+    if (sectors_ready <= 0) {
+        return;
+    }
+
+    uint32_t sector_count;
+    sector_count = _stream.sector_count - _stream.sectors_transferred;
+
+    if ((uint32_t)sectors_ready < sector_count) {
+        sector_count = sectors_ready;
+    }
+
+    int ret;
+
+    if ((ret = cd_block_cmd_sector_data_get_delete(0, 0, sector_count)) != 0) {
+        _stream_end(ret);
+
+        return;
+    }
+
+    /* Data preparation is short compared to a sector read, so poll */
+    uint32_t i;
+
+    for (i = 0; i < DRDY_WAIT_COUNT; i++) {
+        if ((MEMORY_READ(16, CD_BLOCK(HIRQ)) & DRDY) != 0) {
+            break;
+        }
+    }
+
+    if (i == DRDY_WAIT_COUNT) {
+        _stream_end(-1);
+
+        return;
+    }
+
+    _stream.sectors_in_flight = sector_count;
+    _stream.flags |= STREAM_FLAG_TRANSFERRING;
+
+    const cpu_dmac_cfg_t dmac_cfg = {
+        .channel  = _stream.channel,
+        .src_mode = CPU_DMAC_SOURCE_FIXED,
+        .dst_mode = CPU_DMAC_DESTINATION_INCREMENT,
+        .stride   = CPU_DMAC_STRIDE_2_BYTES,
+        .bus_mode = CPU_DMAC_BUS_MODE_BURST,
+        .src      = CD_BLOCK(DTR),
+        .dst      = (uint32_t)&_stream.buffer[_stream.sectors_transferred * CDFS_SECTOR_SIZE],
+        .len      = sector_count * CDFS_SECTOR_SIZE,
+        .ihr      = _dmac_handler,
+        .ihr_work = NULL
+    };
+
+    cpu_dmac_channel_wait(_stream.channel);
+    cpu_dmac_channel_config_set(&dmac_cfg);
+    cpu_dmac_channel_start(_stream.channel);
+}
+
+static void
+_transfer_end(void)
+{
+    /* The stream may have been stopped since the transfer ended */
+    if ((_stream.flags & STREAM_FLAG_TRANSFERRING) == 0) {
+        return;
+    }
+
+    int ret;
+
+    if ((ret = cd_block_cmd_data_transfer_end()) != 0) {
+        _stream_end(ret);
+
+        return;
+    }
+
+    uint8_t * const dst = &_stream.buffer[_stream.sectors_transferred * CDFS_SECTOR_SIZE];
+
+    /* The DMAC bypasses the cache. Destinations such as VRAM and sound RAM
+     * are never cached */
+    if (((uintptr_t)dst & CPU_CACHE_THROUGH) == 0x00000000) {
+        cpu_cache_area_purge(dst, _stream.sectors_in_flight * CDFS_SECTOR_SIZE);
+    }
+
+    _stream.sectors_transferred += _stream.sectors_in_flight;
+    _stream.sectors_in_flight = 0;
+    _stream.flags &= ~STREAM_FLAG_TRANSFERRING;
+
+    if (_stream.sectors_transferred == _stream.sector_count) {
+        _stream_end(0);
+    }
+}
+
+static void
+_dmac_handler(void *work __unused)
+{
+    _stream.transferred = true;
+}
+
+static void
+_stream_end(int error)
+{
+    _stream.error = error;
+
+    _stream.flags &= ~(STREAM_FLAG_BUSY | STREAM_FLAG_TRANSFERRING);
+
+    if (error != 0) {
+        _stream.flags |= STREAM_FLAG_DIRTY;
+    }
+
+    __cd_block_irq_update();
+
+    callback_call(&_stream.callback);
+}
@@ -15,6 +15,47 @@
 
 __BEGIN_DECLS
 
+#define vdp_sync_overrun_clear() do {                                          \
+    vdp_sync_overrun_set(NULL, NULL);                                          \
+} while (false)
+
+/* Number of frames the VBLANK-IN histogram is computed over */
+#define VDP_SYNC_STATS_SAMPLE_COUNT     64
+#define VDP_SYNC_STATS_BUCKET_COUNT     16
+
+/* Stages of the VBLANK-IN and VBLANK-OUT handlers. Each stage is timed in FRT
+ * ticks */
+typedef enum vdp_sync_stage {
+    VDP_SYNC_STAGE_VDP1_VBLANK_IN,
+    VDP_SYNC_STAGE_VBLANK_IN_CALLBACK,
+    VDP_SYNC_STAGE_VDP2_COMMIT,
+    VDP_SYNC_STAGE_DMA_QUEUE,
+    VDP_SYNC_STAGE_VDP2_COMMIT_WAIT,
+    VDP_SYNC_STAGE_VDP1_VBLANK_OUT,
+    VDP_SYNC_STAGE_VBLANK_OUT_CALLBACK,
+    VDP_SYNC_STAGE_COUNT
+} vdp_sync_stage_t;
+
+typedef struct vdp_sync_stats {
+    /* FRT ticks spent in each stage during the last frame */
+    uint16_t stage_ticks[VDP_SYNC_STAGE_COUNT];
+    /* Maximum FRT ticks spent in each stage since the last clear */
+    uint16_t stage_ticks_max[VDP_SYNC_STAGE_COUNT];
+    /* FRT ticks spent in the last VBLANK-IN and VBLANK-OUT handlers */
+    uint16_t vblank_in_ticks;
+    uint16_t vblank_out_ticks;
+    /* Width of each histogram bucket in FRT ticks */
+    uint16_t bucket_ticks;
+    /* Histogram of the VBLANK-IN handler FRT ticks over the last
+     * VDP_SYNC_STATS_SAMPLE_COUNT frames. The last bucket also counts
+     * anything past it */
+    uint16_t histogram[VDP_SYNC_STATS_BUCKET_COUNT];
+    uint32_t frame_count;
+    /* Number of times the VBLANK-IN handler ran past VBLANK, or past the
+     * budget */
+    uint32_t overrun_count;
+} vdp_sync_stats_t;
+
 #define vdp_sync_vblank_in_clear() do {                                        \
     vdp_sync_vblank_in_set(NULL, NULL);                                        \
 } while (false)
@@ -28,7 +69,24 @@ extern void vdp_sync_vblank_in_set(callback_handler_t callback_handler,
 extern void vdp_sync_vblank_out_set(callback_handler_t callback_handler,
   void *work);
 
-extern void vdp_dma_enqueue(void *dst, const void *src, size_t len);
+extern const vdp_sync_stats_t *vdp_sync_stats_get(void);
+extern void vdp_sync_stats_clear(void);
+extern void vdp_sync_stats_bucket_set(uint16_t bucket_ticks);
+
+/* Set the VBLANK-IN handler budget in FRT ticks. Zero means that only running
+ * past VBLANK counts as an overrun */
+extern void vdp_sync_budget_set(uint16_t ticks);
+
+/* CPU-FRT count extended to 32 bits. The VBLANK handlers catch every wrap of
+ * the 16-bit count, so the difference of two calls stays exact no matter how
+ * far apart they are */
+extern uint32_t vdp_sync_ticks_get(void);
+/* The callback is called from the VBLANK-IN interrupt handler */
+extern void vdp_sync_overrun_set(callback_handler_t callback_handler,
+  void *work);
+
+/* Returns -1 if the queue is full, in which case the transfer is dropped */
+extern int32_t vdp_dma_enqueue(void *dst, const void *src, size_t len);
 extern uint32_t vdp_dma_count_get(void);
 
 extern callback_id_t vdp_dma_callback_add(callback_handler_t callback_handler,
@@ -84,6 +84,31 @@ vdp1_transfer_status_get(void)
     return status;
 }
 
+/* Number of frames kept in the frame pacing ring buffer */
+#define VDP1_SYNC_FRAME_STATS_COUNT     16
+
+/* The frame missed its interval */
+#define VDP1_SYNC_FRAME_LATE            (1 << 0)
+/* Plotting was forcibly stopped before the frame was completely drawn */
+#define VDP1_SYNC_FRAME_DROPPED         (1 << 1)
+
+/* Times are in FRT ticks */
+typedef struct vdp1_sync_frame_stats {
+    /* Time from the start of the frame until vdp1_sync() is called */
+    uint32_t submit_ticks;
+    /* Time from the start of plotting until the sprite end */
+    uint32_t draw_ticks;
+    /* Number of fields between this and the previous frame */
+    uint8_t interval;
+    uint8_t flags;
+} vdp1_sync_frame_stats_t;
+
+typedef struct vdp1_sync_pacing {
+    uint32_t frame_count;
+    uint32_t late_count;
+    uint32_t dropped_count;
+} vdp1_sync_pacing_t;
+
 extern void vdp1_sync(void);
 extern bool vdp1_sync_busy(void);
 extern void vdp1_sync_wait(void);
@@ -102,6 +127,13 @@ extern void vdp1_sync_cmdt_orderlist_put(const vdp1_cmdt_orderlist_t *cmdt_order
 extern void vdp1_sync_cmdt_stride_put(const void *buffer, uint16_t count,
   uint16_t cmdt_index, uint16_t index);
 
+/* Copy up to count of the most recent frames, most recent first. Returns the
+ * number of frames copied */
+extern uint32_t vdp1_sync_frame_stats_get(vdp1_sync_frame_stats_t *frame_stats,
+  uint32_t count);
+extern const vdp1_sync_pacing_t *vdp1_sync_pacing_get(void);
+extern void vdp1_sync_pacing_clear(void);
+
 extern void vdp1_sync_put_wait(void);
 extern void vdp1_sync_render(void);
 
@@ -111,6 +143,10 @@ extern void vdp1_sync_render_set(callback_handler_t callback_handler,
   void *work);
 extern void vdp1_sync_transfer_over_set(callback_handler_t callback_handler,
   void *work);
+/* Called after the callback set by vdp1_sync_transfer_over_set, so that
+ * libraries waiting on a transfer don't take over the application's callback */
+extern void vdp1_sync_transfer_over_notify_set(
+  callback_handler_t callback_handler, void *work);
 
 __END_DECLS
 
@@ -10,8 +10,11 @@
 
 #include <sys/cdefs.h>
 
+#include <stdbool.h>
 #include <stdint.h>
 
+#include <gamemath/color/rgb1555.h>
+
 #include <vdp2/map.h>
 #include <vdp2/scrn.h>
 
@@ -60,6 +63,62 @@ extern vdp2_cram_mode_t vdp2_cram_mode_get(void);
 extern void vdp2_cram_mode_set(vdp2_cram_mode_t mode);
 extern void vdp2_cram_offset_set(vdp2_scrn_t scroll_screen, vdp2_cram_t cram);
 
+/*-
+ * CRAM palette manager
+ *
+ * CRAM is divided into banks of 16 colors (32 bytes in modes 0 and 1, 64 bytes
+ * in mode 2). Palettes are allocated in whole banks, and are naturally aligned
+ * up to 256 colors so that they can be used with vdp2_cram_offset_set().
+ *
+ * All writes go to a shadow copy of CRAM in HWRAM. Each modified bank is marked
+ * dirty, and vdp2_cram_pal_sync() steps any running effects, then enqueues the
+ * dirty ranges to the VDP DMA queue. The queue is transferred as a single
+ * SCU-DMA indirect transfer during VBLANK-IN.
+ *
+ * Call vdp2_cram_pal_sync() once per frame before vdp2_sync(). After changing
+ * the CRAM mode, call vdp2_cram_pal_reset() as the bank size may change.
+ *
+ * Effects only operate on RGB 555 colors (modes 0 and 1) */
+
+#define VDP2_CRAM_PAL_BANK_COLOR_COUNT  16
+#define VDP2_CRAM_PAL_BANK_MAX_COUNT    128
+#define VDP2_CRAM_PAL_FX_MAX_COUNT      8
+
+typedef struct vdp2_cram_pal {
+    /* CRAM address of the first color */
+    vdp2_cram_t cram;
+    /* Pointer to the first color in the HWRAM shadow */
+    void *shadow;
+    uint16_t bank;
+    uint16_t bank_count;
+    uint16_t count;
+} vdp2_cram_pal_t;
+
+extern void vdp2_cram_pal_reset(void);
+extern int vdp2_cram_pal_alloc(uint16_t count, vdp2_cram_pal_t *pal);
+extern void vdp2_cram_pal_free(vdp2_cram_pal_t *pal);
+extern void vdp2_cram_pal_set(const vdp2_cram_pal_t *pal, const void *colors,
+    uint16_t index, uint16_t count);
+extern void vdp2_cram_pal_dirty(const vdp2_cram_pal_t *pal, uint16_t index,
+    uint16_t count);
+
+/* Rotate count colors starting at index by one color every frame_count
+ * frames. The cycle runs until stopped */
+extern int vdp2_cram_pal_cycle_set(const vdp2_cram_pal_t *pal, uint16_t index,
+    uint16_t count, uint16_t frame_count);
+/* Fade from the colors in from_colors to color over frame_count frames */
+extern int vdp2_cram_pal_fade_set(const vdp2_cram_pal_t *pal,
+    const rgb1555_t *from_colors, rgb1555_t color, uint16_t frame_count);
+/* Interpolate from the colors in from_colors to to_colors over frame_count
+ * frames */
+extern int vdp2_cram_pal_lerp_set(const vdp2_cram_pal_t *pal,
+    const rgb1555_t *from_colors, const rgb1555_t *to_colors,
+    uint16_t frame_count);
+extern void vdp2_cram_pal_fx_stop(const vdp2_cram_pal_t *pal);
+extern bool vdp2_cram_pal_fx_busy(const vdp2_cram_pal_t *pal);
+
+extern void vdp2_cram_pal_sync(void);
+
 __END_DECLS
 
 #endif /* !_YAUL_VDP2_CRAM_H_ */
@@ -14,5 +14,6 @@
 #include <vdp2/scrn_macros.h>
 #include <vdp2/scrn_rotation.h>
 #include <vdp2/scrn_shared.h>
+#include <vdp2/scrn_stream.h>
 
 #endif /* !_YAUL_VDP2_SCRN_H_ */
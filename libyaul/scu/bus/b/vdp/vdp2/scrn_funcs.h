@@ -11,6 +11,7 @@
 #include <assert.h>
 #include <stdint.h>
 
+#include <gamemath/angle.h>
 #include <gamemath/fix16/fix16_vec2.h>
 
 #include <vdp2/scrn_shared.h>
@@ -176,6 +177,77 @@ typedef struct vdp2_scrn_vcs_format {
     vdp2_vram_t table_base;
 } vdp2_scrn_vcs_format_t;
 
+/*-
+ * Double buffered line scroll and vertical cell scroll tables
+ *
+ * The table buffer in HWRAM is split into a front and back half. The back half
+ * is written to (directly, or through one of the generators), and when synced,
+ * it is added to the VDP DMA queue to be transferred to the table base address
+ * in VRAM during VBLANK-IN. The halves are then swapped, so the half that is
+ * still to be transferred is never written to.
+ *
+ * For vertical line scroll, the value is the vertical coordinate of the scroll
+ * screen that is displayed on that line */
+
+/* Size of the buffer to pass to vdp2_scrn_ls_table_init() */
+#define VDP2_SCRN_LS_TABLE_SIZE(type, count)                                   \
+    (2 * (count) * (((((type) & VDP2_SCRN_LS_TYPE_HORZ) != 0) +                \
+                     (((type) & VDP2_SCRN_LS_TYPE_VERT) != 0) +                \
+                     (((type) & VDP2_SCRN_LS_TYPE_ZOOM_HORZ) != 0)) *          \
+                    sizeof(fix16_t)))
+
+/* Size of the buffer to pass to vdp2_scrn_vcs_table_init() */
+#define VDP2_SCRN_VCS_TABLE_SIZE(count) (2 * (count) * sizeof(fix16_t))
+
+typedef struct vdp2_scrn_ls_table {
+    vdp2_scrn_ls_format_t format;
+    /// Number of entries in the table.
+    uint16_t count;
+    /// Size of an entry in bytes.
+    uint16_t entry_size;
+    /// Offset in bytes within an entry of each value. Set to -1 if unused.
+    int8_t horz_offset;
+    int8_t vert_offset;
+    int8_t horz_incr_offset;
+    /// Index of the back half.
+    uint8_t back;
+    void *buffer;
+} vdp2_scrn_ls_table_t;
+
+typedef struct vdp2_scrn_vcs_table {
+    vdp2_scrn_vcs_format_t format;
+    /// Number of entries (cell columns) in the table.
+    uint16_t count;
+    /// Index of the back half.
+    uint8_t back;
+    fix16_t *buffer;
+} vdp2_scrn_vcs_table_t;
+
+/* Scroll value of entry i is:
+ *   scroll + amplitude * sin(phase + (i * frequency)) */
+typedef struct vdp2_scrn_wobble {
+    fix16_vec2_t scroll;
+    fix16_t amplitude;
+    angle_t frequency;
+    angle_t phase;
+} vdp2_scrn_wobble_t;
+
+/* Perspective floor below the horizon line. For each line y past horizon,
+ *   z = (height * distance) / (y - horizon)
+ * and the line is scaled by z / distance, centered on the screen */
+typedef struct vdp2_scrn_floor {
+    /// Camera position on the floor plane.
+    fix16_vec2_t position;
+    /// Camera height above the floor plane.
+    fix16_t height;
+    /// Distance from the eye to the projection plane.
+    fix16_t distance;
+    /// Screen line of the horizon.
+    uint16_t horizon;
+    /// Screen width.
+    uint16_t width;
+} vdp2_scrn_floor_t;
+
 typedef struct vdp2_scrn_coff_rgb {
     int16_t r;
     int16_t g;
@@ -198,10 +270,26 @@ extern void vdp2_scrn_coff_unset(vdp2_scrn_t scroll_screen);
 
 extern void vdp2_scrn_ls_set(const vdp2_scrn_ls_format_t *ls_format);
 
+extern void vdp2_scrn_ls_table_init(vdp2_scrn_ls_table_t *table,
+  const vdp2_scrn_ls_format_t *ls_format, uint16_t count, void *buffer);
+extern void *vdp2_scrn_ls_table_back_get(const vdp2_scrn_ls_table_t *table);
+extern void vdp2_scrn_ls_table_wobble_build(vdp2_scrn_ls_table_t *table,
+  const vdp2_scrn_wobble_t *wobble);
+extern void vdp2_scrn_ls_table_floor_build(vdp2_scrn_ls_table_t *table,
+  const vdp2_scrn_floor_t *floor);
+extern void vdp2_scrn_ls_table_sync(vdp2_scrn_ls_table_t *table);
+
 extern void vdp2_scrn_vcs_set(const vdp2_scrn_vcs_format_t *vcs_format);
 extern void vdp2_scrn_vcs_unset(vdp2_scrn_t scroll_screen);
 extern void vdp2_scrn_vcs_clear(void);
 
+extern void vdp2_scrn_vcs_table_init(vdp2_scrn_vcs_table_t *table,
+  const vdp2_scrn_vcs_format_t *vcs_format, uint16_t count, fix16_t *buffer);
+extern fix16_t *vdp2_scrn_vcs_table_back_get(const vdp2_scrn_vcs_table_t *table);
+extern void vdp2_scrn_vcs_table_wobble_build(vdp2_scrn_vcs_table_t *table,
+  const vdp2_scrn_wobble_t *wobble);
+extern void vdp2_scrn_vcs_table_sync(vdp2_scrn_vcs_table_t *table);
+
 extern void vdp2_scrn_mosaic_set(vdp2_scrn_t scrn_mask);
 extern void vdp2_scrn_mosaic_horizontal_set(uint8_t horizontal);
 extern void vdp2_scrn_mosaic_vertical_set(uint8_t vertical);
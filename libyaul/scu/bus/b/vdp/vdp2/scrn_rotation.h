@@ -13,6 +13,9 @@
 #include <assert.h>
 #include <stdint.h>
 
+#include <gamemath/angle.h>
+#include <gamemath/fix16/fix16_vec3.h>
+
 #include <vdp2/scrn_shared.h>
 #include <vdp2/scrn_bitmap.h>
 #include <vdp2/scrn_cell.h>
@@ -156,6 +159,48 @@ typedef struct vdp2_scrn_rotation_params {
     vdp2_vram_t rp_table_base;
 } __aligned(4) vdp2_scrn_rotation_params_t;
 
+/// Camera looking over a floor plane ("mode 7").
+typedef struct vdp2_scrn_camera {
+    /// Position. The Z component is the height above the floor plane.
+    fix16_vec3_t position;
+    /// Angle below the horizon.
+    angle_t pitch;
+    /// Angle around the floor plane normal.
+    angle_t yaw;
+    /// Horizontal field of view.
+    angle_t fov;
+} vdp2_scrn_camera_t;
+
+/// Rotation parameter A and per-line coefficient table generator.
+///
+/// The rotation parameter table and coefficient table (2-word, @ref
+/// VDP2_SCRN_COEFF_USAGE_KX_KY) are double buffered in HWRAM. The back buffer
+/// is built either on the calling CPU via @ref vdp2_scrn_rotation_gen_build,
+/// or as a job via @ref vdp2_scrn_rotation_gen_start. Calling @ref
+/// vdp2_scrn_rotation_gen_sync waits for the build to complete, enqueues the
+/// tables to be transferred to VRAM during VBLANK-IN, and swaps buffers.
+///
+/// Lines above the horizon are marked transparent.
+typedef struct vdp2_scrn_rotation_gen {
+    /// Rotation parameter table base address.
+    vdp2_vram_t rp_table_base;
+    /// Coefficient table base address.
+    vdp2_vram_t coeff_table_base;
+    /// Screen width.
+    uint16_t width;
+    /// Screen height, and the number of coefficients per table.
+    uint16_t height;
+    /// Index of the back buffer.
+    uint8_t back;
+    /// Rotation parameter tables.
+    vdp2_scrn_rp_table_t rp_tables[2];
+    /// Coefficient tables, each of @p height entries.
+    uint32_t *coeff_tables;
+} vdp2_scrn_rotation_gen_t;
+
+/// Size in bytes of the buffer to pass to @ref vdp2_scrn_rotation_gen_init.
+#define VDP2_SCRN_ROTATION_GEN_COEFF_SIZE(height) (2 * (height) * sizeof(uint32_t))
+
 /// Not yet documented.
 extern void vdp2_scrn_rotation_cell_format_set(const vdp2_scrn_cell_format_t *cell_format,
   const vdp2_scrn_rotation_map_t *rotation_map);
@@ -173,6 +218,28 @@ extern void vdp2_scrn_rotation_coeff_params_set(const vdp2_scrn_rotation_params_
 /// Not yet documented.
 extern void vdp2_scrn_rotation_coeff_table_set(const vdp2_scrn_rotation_params_t *rotation_params);
 
+/// Initialize the generator. This also sets the coefficient table address
+/// offset, so @ref vdp2_scrn_rotation_coeff_table_set must not be called
+/// afterwards.
+extern void vdp2_scrn_rotation_gen_init(vdp2_scrn_rotation_gen_t *gen,
+  vdp2_vram_t rp_table_base, vdp2_vram_t coeff_table_base, uint16_t width,
+  uint16_t height, uint32_t *coeff_tables);
+/// Build the back buffer on the calling CPU. This is also the reference the
+/// slave CPU path is checked against.
+extern void vdp2_scrn_rotation_gen_build(vdp2_scrn_rotation_gen_t *gen,
+  const vdp2_scrn_camera_t *camera);
+/// Submit the build of the back buffer as a job (see @ref CPU_JOB), so that
+/// the slave CPU can pick it up. The job scheduler must have been initialized
+/// via @ref cpu_job_init. If the deque is full, the back buffer is built on
+/// the calling CPU before returning.
+extern void vdp2_scrn_rotation_gen_start(vdp2_scrn_rotation_gen_t *gen,
+  const vdp2_scrn_camera_t *camera);
+/// Wait until the back buffer has been built. While waiting, the calling CPU
+/// executes jobs, possibly including the build itself.
+extern void vdp2_scrn_rotation_gen_wait(void);
+/// Not yet documented.
+extern void vdp2_scrn_rotation_gen_sync(vdp2_scrn_rotation_gen_t *gen);
+
 __END_DECLS
 
 #endif /* !_YAUL_VDP2_SCRN_ROTATION_H_ */
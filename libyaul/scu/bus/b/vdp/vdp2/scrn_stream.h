@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) Israel Jacquez
+ * See LICENSE for details.
+ *
+ * Israel Jacquez <mrkotfw@gmail.com>
+ */
+
+#ifndef _YAUL_VDP2_SCRN_STREAM_H_
+#define _YAUL_VDP2_SCRN_STREAM_H_
+
+#include <sys/cdefs.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <gamemath/fix16/fix16_vec2.h>
+
+#include <vdp2/scrn_cell.h>
+#include <vdp2/scrn_shared.h>
+
+#include <vdp2/vram.h>
+
+__BEGIN_DECLS
+
+/*-
+ * Tilemap streamer
+ *
+ * Streams a map of pattern name data (PND) of any size through a single plane
+ * that is used as a wrap-around buffer. All four planes (A to D) of the scroll
+ * screen must be set to the same plane base address.
+ *
+ * The map itself can be in HWRAM, LWRAM, or cartridge RAM as it's only read by
+ * the CPU. PNDs are copied into a shadow of the plane in HWRAM, and as the
+ * scroll position advances, only the newly exposed rows and columns are
+ * written. Each page of the plane keeps a dirty range of rows that is
+ * enqueued to the VDP DMA queue on sync, up to the per-frame budget. Anything
+ * past the budget, or that doesn't fit in the VDP DMA queue, is deferred to
+ * the next frame. Each sync starts from the page after the one the previous
+ * sync started from, so that no page is starved by a tight budget.
+ *
+ * Only rows are tracked. A newly exposed column marks every row it crosses as
+ * dirty, so scrolling horizontally uploads whole rows of a page, even though
+ * only one or two characters of each row changed */
+
+/// Not yet documented.
+typedef struct vdp2_scrn_stream_config {
+    /// Cell format of the scroll screen.
+    const vdp2_scrn_cell_format_t *cell_format;
+    /// Base address of the plane used as the wrap-around buffer.
+    vdp2_vram_t plane_base;
+    /// Row major map of 1-word or 2-word PNDs, matching the cell format.
+    const void *map;
+    /// Map width in characters.
+    uint16_t map_width;
+    /// Map height in characters.
+    uint16_t map_height;
+    /// PND written outside of the map.
+    uint32_t fill_pnd;
+    /// Screen width in pixels.
+    uint16_t screen_width;
+    /// Screen height in pixels.
+    uint16_t screen_height;
+    /// Maximum number of bytes to upload per frame. Zero means no limit.
+    /// Otherwise, it must be at least the size of one row of a page.
+    uint32_t budget;
+    /// HWRAM buffer of @ref VDP2_SCRN_PLANE_SIZE_CALCULATE bytes.
+    void *shadow;
+} vdp2_scrn_stream_config_t;
+
+/// Not yet documented.
+typedef struct vdp2_scrn_stream_stats {
+    /// Number of bytes enqueued by the last sync.
+    uint32_t uploaded;
+    /// Number of dirty bytes deferred by the last sync.
+    uint32_t deferred;
+    /// Number of characters written since the last sync.
+    uint32_t written;
+} vdp2_scrn_stream_stats_t;
+
+/// Not yet documented.
+typedef struct vdp2_scrn_stream {
+    vdp2_scrn_stream_config_t config;
+
+    uint8_t pnd_size;
+    uint8_t char_shift;
+    uint8_t page_shift;
+    uint8_t page_columns;
+    uint8_t page_rows;
+    uint16_t plane_width;
+    uint16_t plane_height;
+    uint16_t view_width;
+    uint16_t view_height;
+    uint32_t page_size;
+
+    int32_t origin_x;
+    int32_t origin_y;
+    bool loaded;
+    uint32_t written;
+
+    /* Page the next sync starts from */
+    uint8_t page_next;
+
+    /* Dirty range of rows [first, last) per page */
+    struct {
+        int16_t first;
+        int16_t last;
+    } dirty[4];
+
+    vdp2_scrn_stream_stats_t stats;
+} vdp2_scrn_stream_t;
+
+/// Not yet documented.
+extern void vdp2_scrn_stream_init(vdp2_scrn_stream_t *stream,
+  const vdp2_scrn_stream_config_t *config);
+/// Set the scroll position in map pixels. Newly exposed rows and columns are
+/// written to the shadow.
+extern void vdp2_scrn_stream_scroll_set(vdp2_scrn_stream_t *stream,
+  const fix16_vec2_t *scroll);
+/// Not yet documented.
+extern void vdp2_scrn_stream_invalidate(vdp2_scrn_stream_t *stream);
+/// Enqueue dirty rows to the VDP DMA queue, up to the budget.
+extern void vdp2_scrn_stream_sync(vdp2_scrn_stream_t *stream);
+/// Not yet documented.
+extern const vdp2_scrn_stream_stats_t *vdp2_scrn_stream_stats_get(
+  const vdp2_scrn_stream_t *stream);
+
+__END_DECLS
+
+#endif /* !_YAUL_VDP2_SCRN_STREAM_H_ */
@@ -17,6 +17,8 @@ __vdp2_cram_init(void)
     vdp2_cram_mode_set(1);
 
     cpu_dmac_memset(0, (void *)VDP2_CRAM(0x0000), 0x00000000, VDP2_CRAM_SIZE);
+
+    vdp2_cram_pal_reset();
 }
 
 vdp2_cram_mode_t
@@ -0,0 +1,461 @@
+/*
+ * Copyright (c) Israel Jacquez
+ * See LICENSE for details.
+ *
+ * Israel Jacquez <mrkotfw@gmail.com>
+ */
+
+#include <assert.h>
+#include <string.h>
+
+#include <vdp.h>
+
+#include "vdp-internal.h"
+
+#define FX_TYPE_NONE            (0)
+#define FX_TYPE_CYCLE           (1)
+#define FX_TYPE_FADE            (2)
+#define FX_TYPE_LERP            (3)
+
+/* Limit the number of transfers added to the VDP DMA queue. Dirty runs past
+ * this limit are merged into the last transfer */
+#define DIRTY_RUNS_MAX_COUNT    (4)
+
+#define BITMAP_WORD_COUNT       (VDP2_CRAM_PAL_BANK_MAX_COUNT / 32)
+
+struct fx {
+    uint8_t type;
+    uint16_t bank;
+    uint16_t count;
+    uint16_t index;
+    uint16_t cycle_count;
+    uint16_t frame_count;
+    uint16_t frame;
+    rgb1555_t color;
+    rgb1555_t *shadow;
+    const rgb1555_t *from_colors;
+    const rgb1555_t *to_colors;
+};
+
+static struct {
+    uint32_t alloc_bitmap[BITMAP_WORD_COUNT];
+    uint32_t dirty_bitmap[BITMAP_WORD_COUNT];
+    uint16_t bank_count;
+    uint16_t bank_size;
+    struct fx fxs[VDP2_CRAM_PAL_FX_MAX_COUNT];
+} _state;
+
+static uint8_t _shadow[VDP2_CRAM_SIZE] __aligned(16);
+
+static struct fx *_fx_get(const vdp2_cram_pal_t *pal, bool alloc);
+static void _fx_step(struct fx *fx);
+
+static void _banks_dirty(uint16_t bank, uint16_t count);
+static void _dirty_sync(void);
+
+static inline bool __always_inline
+_bank_test(const uint32_t *bitmap, uint16_t bank)
+{
+    return ((bitmap[bank >> 5] & (1UL << (bank & 31))) != 0);
+}
+
+static inline void __always_inline
+_bank_set(uint32_t *bitmap, uint16_t bank)
+{
+    bitmap[bank >> 5] |= 1UL << (bank & 31);
+}
+
+static inline void __always_inline
+_bank_clear(uint32_t *bitmap, uint16_t bank)
+{
+    bitmap[bank >> 5] &= ~(1UL << (bank & 31));
+}
+
+static inline rgb1555_t __always_inline
+_color_lerp(rgb1555_t from, rgb1555_t to, int32_t weight)
+{
+    rgb1555_t color;
+
+    color.msb = from.msb;
+    color.r = from.r + ((((int32_t)to.r - (int32_t)from.r) * weight) >> 8);
+    color.g = from.g + ((((int32_t)to.g - (int32_t)from.g) * weight) >> 8);
+    color.b = from.b + ((((int32_t)to.b - (int32_t)from.b) * weight) >> 8);
+
+    return color;
+}
+
+void
+vdp2_cram_pal_reset(void)
+{
+    const vdp2_cram_mode_t mode = vdp2_cram_mode_get();
+
+    switch (mode) {
+    case 0:
+        _state.bank_size = 32;
+        _state.bank_count = VDP2_CRAM_MODE_0_SIZE / 32;
+        break;
+    case 1:
+        _state.bank_size = 32;
+        _state.bank_count = VDP2_CRAM_MODE_1_SIZE / 32;
+        break;
+    default:
+        _state.bank_size = 64;
+        _state.bank_count = VDP2_CRAM_MODE_2_SIZE / 64;
+        break;
+    }
+
+    (void)memset(_state.alloc_bitmap, 0, sizeof(_state.alloc_bitmap));
+    (void)memset(_state.dirty_bitmap, 0, sizeof(_state.dirty_bitmap));
+    (void)memset(_state.fxs, 0, sizeof(_state.fxs));
+
+    (void)memset(_shadow, 0, sizeof(_shadow));
+}
+
+int
+vdp2_cram_pal_alloc(uint16_t count, vdp2_cram_pal_t *pal)
+{
+    assert(pal != NULL);
+    assert(count > 0);
+
+    const uint16_t bank_count =
+      (count + VDP2_CRAM_PAL_BANK_COLOR_COUNT - 1) / VDP2_CRAM_PAL_BANK_COLOR_COUNT;
+
+    if (bank_count > _state.bank_count) {
+        return -1;
+    }
+
+    /* Naturally align the palette, up to 256 colors */
+    uint16_t align;
+    for (align = 1; (align < bank_count) && (align < 16); align <<= 1) {
+    }
+
+    for (uint16_t bank = 0; (bank + bank_count) <= _state.bank_count; bank += align) {
+        uint16_t i;
+
+        for (i = 0; i < bank_count; i++) {
+            if (_bank_test(_state.alloc_bitmap, bank + i)) {
+                break;
+            }
+        }
+
+        if (i != bank_count) {
+            continue;
+        }
+
+        for (i = 0; i < bank_count; i++) {
+            _bank_set(_state.alloc_bitmap, bank + i);
+        }
+
+        const uint32_t offset = bank * _state.bank_size;
+
+        pal->cram = VDP2_CRAM(offset);
+        pal->shadow = &_shadow[offset];
+        pal->bank = bank;
+        pal->bank_count = bank_count;
+        pal->count = count;
+
+        return 0;
+    }
+
+    return -1;
+}
+
+void
+vdp2_cram_pal_free(vdp2_cram_pal_t *pal)
+{
+    assert(pal != NULL);
+
+    vdp2_cram_pal_fx_stop(pal);
+
+    for (uint16_t i = 0; i < pal->bank_count; i++) {
+        _bank_clear(_state.alloc_bitmap, pal->bank + i);
+    }
+
+    pal->shadow = NULL;
+    pal->bank_count = 0;
+    pal->count = 0;
+}
+
+void
+vdp2_cram_pal_set(const vdp2_cram_pal_t *pal, const void *colors,
+  uint16_t index, uint16_t count)
+{
+    assert(pal != NULL);
+    assert(pal->shadow != NULL);
+    assert(colors != NULL);
+    assert((index + count) <= pal->count);
+
+    const uint32_t color_size = _state.bank_size / VDP2_CRAM_PAL_BANK_COLOR_COUNT;
+
+    (void)memcpy((uint8_t *)pal->shadow + (index * color_size), colors,
+      count * color_size);
+
+    vdp2_cram_pal_dirty(pal, index, count);
+}
+
+void
+vdp2_cram_pal_dirty(const vdp2_cram_pal_t *pal, uint16_t index, uint16_t count)
+{
+    assert(pal != NULL);
+    assert((index + count) <= pal->count);
+
+    if (count == 0) {
+        return;
+    }
+
+    const uint16_t first_bank = index / VDP2_CRAM_PAL_BANK_COLOR_COUNT;
+    const uint16_t last_bank = (index + count - 1) / VDP2_CRAM_PAL_BANK_COLOR_COUNT;
+
+    _banks_dirty(pal->bank + first_bank, (last_bank - first_bank) + 1);
+}
+
+int
+vdp2_cram_pal_cycle_set(const vdp2_cram_pal_t *pal, uint16_t index,
+  uint16_t count, uint16_t frame_count)
+{
+    assert(pal != NULL);
+    assert(_state.bank_size == 32);
+    assert(count > 0);
+    assert((index + count) <= pal->count);
+    assert(frame_count > 0);
+
+    struct fx * const fx = _fx_get(pal, true);
+
+    if (fx == NULL) {
+        return -1;
+    }
+
+    fx->type = FX_TYPE_CYCLE;
+    fx->index = index;
+    fx->cycle_count = count;
+    fx->frame_count = frame_count;
+    fx->frame = 0;
+
+    return 0;
+}
+
+int
+vdp2_cram_pal_fade_set(const vdp2_cram_pal_t *pal,
+  const rgb1555_t *from_colors, rgb1555_t color, uint16_t frame_count)
+{
+    assert(pal != NULL);
+    assert(_state.bank_size == 32);
+    assert(from_colors != NULL);
+    assert(frame_count > 0);
+
+    struct fx * const fx = _fx_get(pal, true);
+
+    if (fx == NULL) {
+        return -1;
+    }
+
+    fx->type = FX_TYPE_FADE;
+    fx->frame_count = frame_count;
+    fx->frame = 0;
+    fx->color = color;
+    fx->from_colors = from_colors;
+    fx->to_colors = NULL;
+
+    return 0;
+}
+
+int
+vdp2_cram_pal_lerp_set(const vdp2_cram_pal_t *pal,
+  const rgb1555_t *from_colors, const rgb1555_t *to_colors,
+  uint16_t frame_count)
+{
+    assert(pal != NULL);
+    assert(_state.bank_size == 32);
+    assert(from_colors != NULL);
+    assert(to_colors != NULL);
+    assert(frame_count > 0);
+
+    struct fx * const fx = _fx_get(pal, true);
+
+    if (fx == NULL) {
+        return -1;
+    }
+
+    fx->type = FX_TYPE_LERP;
+    fx->frame_count = frame_count;
+    fx->frame = 0;
+    fx->from_colors = from_colors;
+    fx->to_colors = to_colors;
+
+    return 0;
+}
+
+void
+vdp2_cram_pal_fx_stop(const vdp2_cram_pal_t *pal)
+{
+    struct fx * const fx = _fx_get(pal, false);
+
+    if (fx != NULL) {
+        fx->type = FX_TYPE_NONE;
+    }
+}
+
+bool
+vdp2_cram_pal_fx_busy(const vdp2_cram_pal_t *pal)
+{
+    return (_fx_get(pal, false) != NULL);
+}
+
+void
+vdp2_cram_pal_sync(void)
+{
+    for (uint32_t i = 0; i < VDP2_CRAM_PAL_FX_MAX_COUNT; i++) {
+        struct fx * const fx = &_state.fxs[i];
+
+        if (fx->type != FX_TYPE_NONE) {
+            _fx_step(fx);
+        }
+    }
+
+    _dirty_sync();
+}
+
+static struct fx *
+_fx_get(const vdp2_cram_pal_t *pal, bool alloc)
+{
+    assert(pal != NULL);
+
+    struct fx *free_fx;
+    free_fx = NULL;
+
+    for (uint32_t i = 0; i < VDP2_CRAM_PAL_FX_MAX_COUNT; i++) {
+        struct fx * const fx = &_state.fxs[i];
+
+        if (fx->type == FX_TYPE_NONE) {
+            if (free_fx == NULL) {
+                free_fx = fx;
+            }
+
+            continue;
+        }
+
+        if (fx->bank == pal->bank) {
+            return fx;
+        }
+    }
+
+    if (!alloc || (free_fx == NULL)) {
+        return NULL;
+    }
+
+    free_fx->bank = pal->bank;
+    free_fx->count = pal->count;
+    free_fx->shadow = pal->shadow;
+
+    return free_fx;
+}
+
+static void
+_fx_step(struct fx *fx)
+{
+    rgb1555_t * const shadow = fx->shadow;
+
+    fx->frame++;
+
+    switch (fx->type) {
+    case FX_TYPE_CYCLE: {
+        if (fx->frame < fx->frame_count) {
+            return;
+        }
+
+        fx->frame = 0;
+
+        rgb1555_t * const colors = &shadow[fx->index];
+        const rgb1555_t last_color = colors[fx->cycle_count - 1];
+
+        for (uint32_t i = fx->cycle_count - 1; i > 0; i--) {
+            colors[i] = colors[i - 1];
+        }
+
+        colors[0] = last_color;
+
+        const uint16_t first_bank = fx->index / VDP2_CRAM_PAL_BANK_COLOR_COUNT;
+        const uint16_t last_bank =
+          (fx->index + fx->cycle_count - 1) / VDP2_CRAM_PAL_BANK_COLOR_COUNT;
+
+        _banks_dirty(fx->bank + first_bank, (last_bank - first_bank) + 1);
+    } break;
+    case FX_TYPE_FADE:
+    case FX_TYPE_LERP: {
+        /* Avoid a division per color channel by computing a 8.8 weight once */
+        const int32_t weight = ((uint32_t)fx->frame << 8) / fx->frame_count;
+
+        for (uint32_t i = 0; i < fx->count; i++) {
+            const rgb1555_t to_color =
+              (fx->type == FX_TYPE_FADE) ? fx->color : fx->to_colors[i];
+
+            shadow[i] = _color_lerp(fx->from_colors[i], to_color, weight);
+        }
+
+        _banks_dirty(fx->bank,
+          (fx->count + VDP2_CRAM_PAL_BANK_COLOR_COUNT - 1) / VDP2_CRAM_PAL_BANK_COLOR_COUNT);
+
+        if (fx->frame >= fx->frame_count) {
+            fx->type = FX_TYPE_NONE;
+        }
+    } break;
+    }
+}
+
+static void
+_banks_dirty(uint16_t bank, uint16_t count)
+{
+    assert((bank + count) <= _state.bank_count);
+
+    for (uint16_t i = 0; i < count; i++) {
+        _bank_set(_state.dirty_bitmap, bank + i);
+    }
+}
+
+static void
+_dirty_sync(void)
+{
+    uint16_t run_starts[DIRTY_RUNS_MAX_COUNT];
+    uint16_t run_ends[DIRTY_RUNS_MAX_COUNT];
+    uint32_t run_count;
+
+    run_count = 0;
+
+    for (uint16_t bank = 0; bank < _state.bank_count; bank++) {
+        if ((_state.dirty_bitmap[bank >> 5]) == 0) {
+            /* Skip over 32 clean banks at a time */
+            bank |= 31;
+
+            continue;
+        }
+
+        if (!(_bank_test(_state.dirty_bitmap, bank))) {
+            continue;
+        }
+
+        if ((run_count > 0) &&
+            ((run_ends[run_count - 1] == bank) || (run_count == DIRTY_RUNS_MAX_COUNT))) {
+            run_ends[run_count - 1] = bank + 1;
+        } else {
+            run_starts[run_count] = bank;
+            run_ends[run_count] = bank + 1;
+
+            run_count++;
+        }
+    }
+
+    for (uint32_t i = 0; i < run_count; i++) {
+        const uint32_t offset = run_starts[i] * _state.bank_size;
+        const uint32_t len = (run_ends[i] - run_starts[i]) * _state.bank_size;
+
+        /* Banks of a dropped transfer stay dirty, and are retried on the
+         * next sync */
+        if ((vdp_dma_enqueue((void *)VDP2_CRAM(offset), &_shadow[offset], len)) < 0) {
+            break;
+        }
+
+        for (uint16_t bank = run_starts[i]; bank < run_ends[i]; bank++) {
+            _bank_clear(_state.dirty_bitmap, bank);
+        }
+    }
+}
@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) Israel Jacquez
+ * See LICENSE for details.
+ *
+ * Israel Jacquez <mrkotfw@gmail.com>
+ */
+
+#include <assert.h>
+
+#include <gamemath/fix16/fix16_trig.h>
+
+#include <vdp.h>
+
+#include "vdp-internal.h"
+
+static inline fix16_t * __always_inline
+_entry_value(uint8_t *entry, int8_t offset)
+{
+    return (fix16_t *)(entry + offset);
+}
+
+void
+vdp2_scrn_ls_table_init(vdp2_scrn_ls_table_t *table,
+  const vdp2_scrn_ls_format_t *ls_format, uint16_t count, void *buffer)
+{
+    assert(table != NULL);
+    assert(ls_format != NULL);
+    assert(buffer != NULL);
+    assert(count > 0);
+
+    table->format = *ls_format;
+    table->count = count;
+    table->back = 0;
+    table->buffer = buffer;
+
+    /* The values are laid out in the order horizontal, vertical, then
+     * horizontal coordinate increment */
+    int8_t offset;
+    offset = 0;
+
+    table->horz_offset = -1;
+    table->vert_offset = -1;
+    table->horz_incr_offset = -1;
+
+    if ((ls_format->type & VDP2_SCRN_LS_TYPE_HORZ) != 0) {
+        table->horz_offset = offset;
+        offset += sizeof(fix16_t);
+    }
+
+    if ((ls_format->type & VDP2_SCRN_LS_TYPE_VERT) != 0) {
+        table->vert_offset = offset;
+        offset += sizeof(fix16_t);
+    }
+
+    if ((ls_format->type & VDP2_SCRN_LS_TYPE_ZOOM_HORZ) != 0) {
+        table->horz_incr_offset = offset;
+        offset += sizeof(fix16_t);
+    }
+
+    assert(offset > 0);
+
+    table->entry_size = offset;
+
+    vdp2_scrn_ls_set(ls_format);
+}
+
+void *
+vdp2_scrn_ls_table_back_get(const vdp2_scrn_ls_table_t *table)
+{
+    assert(table != NULL);
+
+    const uint32_t size = table->count * table->entry_size;
+
+    return ((uint8_t *)table->buffer + (table->back * size));
+}
+
+void
+vdp2_scrn_ls_table_wobble_build(vdp2_scrn_ls_table_t *table,
+  const vdp2_scrn_wobble_t *wobble)
+{
+    assert(table != NULL);
+    assert(wobble != NULL);
+    assert(table->horz_offset >= 0);
+
+    const uint32_t interval = (table->format.interval == 0) ? 1 : table->format.interval;
+
+    uint8_t *entry;
+    entry = vdp2_scrn_ls_table_back_get(table);
+
+    angle_t angle;
+    angle = wobble->phase;
+
+    for (uint32_t i = 0; i < table->count; i++) {
+        *_entry_value(entry, table->horz_offset) =
+          wobble->scroll.x + fix16_mul(wobble->amplitude, fix16_sin(angle));
+
+        if (table->vert_offset >= 0) {
+            *_entry_value(entry, table->vert_offset) =
+              wobble->scroll.y + fix16_int32_from(i * interval);
+        }
+
+        if (table->horz_incr_offset >= 0) {
+            *_entry_value(entry, table->horz_incr_offset) = FIX16(1.0);
+        }
+
+        angle += wobble->frequency;
+        entry += table->entry_size;
+    }
+}
+
+void
+vdp2_scrn_ls_table_floor_build(vdp2_scrn_ls_table_t *table,
+  const vdp2_scrn_floor_t *floor)
+{
+    assert(table != NULL);
+    assert(floor != NULL);
+    assert(table->vert_offset >= 0);
+    assert(table->horz_incr_offset >= 0);
+
+    const uint32_t interval = (table->format.interval == 0) ? 1 : table->format.interval;
+    const int32_t half_width = floor->width / 2;
+
+    uint8_t *entry;
+    entry = vdp2_scrn_ls_table_back_get(table);
+
+    for (uint32_t i = 0; i < table->count; i++) {
+        const int32_t y = i * interval;
+
+        fix16_t scale;
+        fix16_t z;
+
+        if (y <= floor->horizon) {
+            scale = FIX16(1.0);
+            z = 0;
+        } else {
+            /* As z = (height * distance) / dy, the scale z / distance reduces
+             * to height / dy, which avoids a fix16 division per line */
+            scale = floor->height / (y - floor->horizon);
+
+            if (scale < VDP2_SCRN_REDUCTION_MIN) {
+                scale = VDP2_SCRN_REDUCTION_MIN;
+            } else if (scale > VDP2_SCRN_REDUCTION_MAX) {
+                scale = VDP2_SCRN_REDUCTION_MAX;
+            }
+
+            z = fix16_mul(scale, floor->distance);
+        }
+
+        if (table->horz_offset >= 0) {
+            *_entry_value(entry, table->horz_offset) =
+              floor->position.x - (scale * half_width);
+        }
+
+        *_entry_value(entry, table->vert_offset) = floor->position.y + z;
+        *_entry_value(entry, table->horz_incr_offset) = scale;
+
+        entry += table->entry_size;
+    }
+}
+
+void
+vdp2_scrn_ls_table_sync(vdp2_scrn_ls_table_t *table)
+{
+    assert(table != NULL);
+
+    vdp_dma_enqueue((void *)table->format.table_base,
+      vdp2_scrn_ls_table_back_get(table),
+      table->count * table->entry_size);
+
+    /* The half that was just enqueued is transferred at VBLANK-IN, so start
+     * writing to the other half */
+    table->back ^= 1;
+}
@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) Israel Jacquez
+ * See LICENSE for details.
+ *
+ * Israel Jacquez <mrkotfw@gmail.com>
+ */
+
+#include <assert.h>
+
+#include <cpu/cache.h>
+#include <cpu/dual.h>
+#include <cpu/job.h>
+
+#include <gamemath/fix16/fix16_trig.h>
+
+#include <vdp.h>
+
+#include "vdp-internal.h"
+
+/* Fixed point formats of the rotation parameter table. All share the binary
+ * point of fix16_t, so only the unused bits need to be masked off */
+#define RP_FORMAT_13_10(x)      ((uint32_t)(x) & 0x1FFFFFC0UL)
+#define RP_FORMAT_3_10(x)       ((uint32_t)(x) & 0x0007FFC0UL)
+#define RP_FORMAT_4_10(x)       ((uint32_t)(x) & 0x000FFFC0UL)
+#define RP_FORMAT_14_10(x)      ((uint32_t)(x) & 0x3FFFFFC0UL)
+#define RP_FORMAT_8_16(x)       ((uint32_t)(x) & 0x00FFFFFFUL)
+#define RP_FORMAT_16_10(x)      ((uint32_t)(x) & 0xFFFFFFC0UL)
+
+#define COEFF_TRANSPARENT       (0x80000000UL)
+#define COEFF_MAX               (FIX16(127.0))
+
+typedef struct {
+    vdp2_scrn_rotation_gen_t *gen;
+    vdp2_scrn_camera_t camera;
+} build_work_t;
+
+static cpu_job_t _build_job;
+static build_work_t _build_work;
+
+static void _build_job_func(cpu_job_t *job, void *work);
+
+void
+vdp2_scrn_rotation_gen_init(vdp2_scrn_rotation_gen_t *gen,
+  vdp2_vram_t rp_table_base, vdp2_vram_t coeff_table_base, uint16_t width,
+  uint16_t height, uint32_t *coeff_tables)
+{
+    assert(gen != NULL);
+    assert(coeff_tables != NULL);
+    assert(width > 0);
+    assert(height > 0);
+
+    gen->rp_table_base = rp_table_base;
+    gen->coeff_table_base = coeff_table_base;
+    gen->width = width;
+    gen->height = height;
+    gen->back = 0;
+    gen->coeff_tables = coeff_tables;
+
+    /* The integer part of KAst addresses 2-word coefficients within a 256KiB
+     * window. The window is selected by the coefficient table address
+     * offset */
+    _state_vdp2()->shadow_regs.ktaof &= 0xFFF8;
+    _state_vdp2()->shadow_regs.ktaof |= (coeff_table_base >> 18) & 0x07;
+}
+
+void
+vdp2_scrn_rotation_gen_build(vdp2_scrn_rotation_gen_t *gen,
+  const vdp2_scrn_camera_t *camera)
+{
+    assert(gen != NULL);
+    assert(camera != NULL);
+
+    vdp2_scrn_rp_table_t * const rp_table = &gen->rp_tables[gen->back];
+    uint32_t * const coeff_table = &gen->coeff_tables[gen->back * gen->height];
+
+    fix16_t sin_pitch;
+    fix16_t cos_pitch;
+    fix16_t sin_yaw;
+    fix16_t cos_yaw;
+
+    fix16_sincos(camera->pitch, &sin_pitch, &cos_pitch);
+    fix16_sincos(camera->yaw, &sin_yaw, &cos_yaw);
+
+    const int32_t cx = gen->width / 2;
+    const int32_t cy = gen->height / 2;
+
+    const fix16_t focal =
+      fix16_div(fix16_int32_from(cx), fix16_tan(camera->fov / 2));
+
+    /* For screen line v, the ray through the pitched camera hits the floor
+     * plane at t = height / d(v), where
+     *
+     *   d(v) = (v - cy) * cos(pitch) + focal * sin(pitch)
+     *
+     * t is written to the coefficient table, and scales both the horizontal
+     * offset (h - cx), and the forward distance
+     *
+     *   f(v) = focal * cos(pitch) - (v - cy) * sin(pitch)
+     *
+     * As f(v) is linear in v, it's computed by the VDP2 via Yst and ΔYst */
+    rp_table->xst = RP_FORMAT_13_10(0);
+    rp_table->yst = RP_FORMAT_13_10(fix16_int32_from(cy) +
+      fix16_mul(focal, cos_pitch) + (cy * sin_pitch));
+    rp_table->zst = RP_FORMAT_13_10(0);
+
+    rp_table->delta_xst = RP_FORMAT_3_10(0);
+    rp_table->delta_yst = RP_FORMAT_3_10(-sin_pitch);
+
+    rp_table->delta_x = RP_FORMAT_3_10(FIX16(1.0));
+    rp_table->delta_y = RP_FORMAT_3_10(0);
+
+    /* Map the camera's right and forward vectors onto the floor plane */
+    rp_table->matrix.param.a = RP_FORMAT_4_10(cos_yaw);
+    rp_table->matrix.param.b = RP_FORMAT_4_10(sin_yaw);
+    rp_table->matrix.param.c = RP_FORMAT_4_10(0);
+    rp_table->matrix.param.d = RP_FORMAT_4_10(sin_yaw);
+    rp_table->matrix.param.e = RP_FORMAT_4_10(-cos_yaw);
+    rp_table->matrix.param.f = RP_FORMAT_4_10(0);
+
+    rp_table->px = cx;
+    rp_table->py = cy;
+    rp_table->pz = 0;
+
+    rp_table->cx = cx;
+    rp_table->cy = cy;
+    rp_table->cz = 0;
+
+    rp_table->mx = RP_FORMAT_14_10(camera->position.x - fix16_int32_from(cx));
+    rp_table->my = RP_FORMAT_14_10(camera->position.y - fix16_int32_from(cy));
+
+    rp_table->kx = RP_FORMAT_8_16(FIX16(1.0));
+    rp_table->ky = RP_FORMAT_8_16(FIX16(1.0));
+
+    const uint32_t coeff_offset = (gen->coeff_table_base & 0x3FFFF) >> 2;
+
+    rp_table->kast = RP_FORMAT_16_10(fix16_int32_from(coeff_offset));
+    rp_table->delta_kast = RP_FORMAT_16_10(FIX16(1.0));
+    rp_table->delta_kax = RP_FORMAT_16_10(0);
+
+    const fix16_t focal_sin_pitch = fix16_mul(focal, sin_pitch);
+
+    for (int32_t v = 0; v < gen->height; v++) {
+        const fix16_t d = ((v - cy) * cos_pitch) + focal_sin_pitch;
+
+        if (d <= 0) {
+            coeff_table[v] = COEFF_TRANSPARENT;
+
+            continue;
+        }
+
+        fix16_t coeff;
+        coeff = fix16_div(camera->position.z, d);
+
+        if (coeff > COEFF_MAX) {
+            coeff = COEFF_MAX;
+        }
+
+        coeff_table[v] = RP_FORMAT_8_16(coeff);
+    }
+}
+
+void
+vdp2_scrn_rotation_gen_start(vdp2_scrn_rotation_gen_t *gen,
+  const vdp2_scrn_camera_t *camera)
+{
+    assert(gen != NULL);
+    assert(camera != NULL);
+
+    vdp2_scrn_rotation_gen_wait();
+
+    _build_work.gen = gen;
+    _build_work.camera = *camera;
+
+    cpu_job_create(&_build_job, _build_job_func, &_build_work,
+      sizeof(_build_work), NULL);
+
+    /* With the deque full, there's nobody to hand the build to */
+    if ((cpu_job_submit(&_build_job)) < 0) {
+        vdp2_scrn_rotation_gen_build(gen, camera);
+    }
+}
+
+void
+vdp2_scrn_rotation_gen_wait(void)
+{
+    /* Before the first start, the job is zeroed, and so already done */
+    cpu_job_wait(&_build_job);
+}
+
+void
+vdp2_scrn_rotation_gen_sync(vdp2_scrn_rotation_gen_t *gen)
+{
+    assert(gen != NULL);
+
+    vdp2_scrn_rotation_gen_wait();
+
+    vdp_dma_enqueue((void *)gen->rp_table_base, &gen->rp_tables[gen->back],
+      sizeof(vdp2_scrn_rp_table_t));
+
+    vdp_dma_enqueue((void *)gen->coeff_table_base,
+      &gen->coeff_tables[gen->back * gen->height],
+      gen->height * sizeof(uint32_t));
+
+    /* The back buffer is transferred at VBLANK-IN, so build into the other
+     * buffer next */
+    gen->back ^= 1;
+}
+
+static void
+_build_job_func(cpu_job_t *job __unused, void *work)
+{
+    build_work_t * const build_work = work;
+
+    /* The work area is purged by the job scheduler, but the generator itself
+     * (the back buffer index in particular) is written by the submitting CPU.
+     * The cache is write-through, so the built tables are visible to SCU-DMA
+     * without a purge afterwards */
+    if ((cpu_dual_executor_get()) == CPU_SLAVE) {
+        cpu_cache_area_purge(build_work->gen, sizeof(vdp2_scrn_rotation_gen_t));
+    }
+
+    vdp2_scrn_rotation_gen_build(build_work->gen, &build_work->camera);
+}
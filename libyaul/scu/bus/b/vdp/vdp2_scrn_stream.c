@@ -0,0 +1,307 @@
+/*
+ * Copyright (c) Israel Jacquez
+ * See LICENSE for details.
+ *
+ * Israel Jacquez <mrkotfw@gmail.com>
+ */
+
+#include <assert.h>
+
+#include <vdp.h>
+
+#include "vdp-internal.h"
+
+static void _rect_load(vdp2_scrn_stream_t *stream, int32_t x0, int32_t y0,
+  int32_t x1, int32_t y1);
+
+static inline uint32_t __always_inline
+_map_pnd_get(const vdp2_scrn_stream_t *stream, int32_t x, int32_t y)
+{
+    const vdp2_scrn_stream_config_t * const config = &stream->config;
+
+    if ((x < 0) || (y < 0) ||
+        (x >= config->map_width) || (y >= config->map_height)) {
+        return config->fill_pnd;
+    }
+
+    const uint32_t index = (y * config->map_width) + x;
+
+    if (stream->pnd_size == 1) {
+        return ((const uint16_t *)config->map)[index];
+    }
+
+    return ((const uint32_t *)config->map)[index];
+}
+
+static inline void __always_inline
+_dirty_mark(vdp2_scrn_stream_t *stream, uint32_t page, int16_t row)
+{
+    if (stream->dirty[page].first >= stream->dirty[page].last) {
+        stream->dirty[page].first = row;
+        stream->dirty[page].last = row + 1;
+    } else if (row < stream->dirty[page].first) {
+        stream->dirty[page].first = row;
+    } else if (row >= stream->dirty[page].last) {
+        stream->dirty[page].last = row + 1;
+    }
+}
+
+void
+vdp2_scrn_stream_init(vdp2_scrn_stream_t *stream,
+  const vdp2_scrn_stream_config_t *config)
+{
+    assert(stream != NULL);
+    assert(config != NULL);
+    assert(config->cell_format != NULL);
+    assert(config->map != NULL);
+    assert(config->shadow != NULL);
+
+    const vdp2_scrn_cell_format_t * const cell_format = config->cell_format;
+
+    assert((cell_format->pnd_size == 1) || (cell_format->pnd_size == 2));
+
+    stream->config = *config;
+
+    stream->pnd_size = cell_format->pnd_size;
+    stream->char_shift = (cell_format->char_size == VDP2_SCRN_CHAR_SIZE_1X1) ? 3 : 4;
+    stream->page_shift = (cell_format->char_size == VDP2_SCRN_CHAR_SIZE_1X1) ? 6 : 5;
+
+    switch (cell_format->plane_size) {
+    case VDP2_SCRN_PLANE_SIZE_2X1:
+        stream->page_columns = 2;
+        stream->page_rows = 1;
+        break;
+    case VDP2_SCRN_PLANE_SIZE_2X2:
+        stream->page_columns = 2;
+        stream->page_rows = 2;
+        break;
+    default:
+        stream->page_columns = 1;
+        stream->page_rows = 1;
+        break;
+    }
+
+    /* A budget smaller than a row would never upload anything */
+    const uint32_t row_size __unused =
+      (stream->pnd_size * 2) << stream->page_shift;
+
+    assert((config->budget == 0) || (config->budget >= row_size));
+
+    stream->plane_width = stream->page_columns << stream->page_shift;
+    stream->plane_height = stream->page_rows << stream->page_shift;
+
+    const uint32_t char_mask = (1 << stream->char_shift) - 1;
+
+    /* Account for the partially visible character on either side */
+    stream->view_width = ((config->screen_width + char_mask) >> stream->char_shift) + 1;
+    stream->view_height = ((config->screen_height + char_mask) >> stream->char_shift) + 1;
+
+    assert(stream->view_width <= stream->plane_width);
+    assert(stream->view_height <= stream->plane_height);
+
+    stream->page_size = VDP2_SCRN_PAGE_SIZE_CALCULATE(cell_format);
+
+    stream->origin_x = 0;
+    stream->origin_y = 0;
+    stream->written = 0;
+    stream->page_next = 0;
+
+    stream->stats.uploaded = 0;
+    stream->stats.deferred = 0;
+    stream->stats.written = 0;
+
+    vdp2_scrn_stream_invalidate(stream);
+}
+
+void
+vdp2_scrn_stream_invalidate(vdp2_scrn_stream_t *stream)
+{
+    assert(stream != NULL);
+
+    stream->loaded = false;
+
+    for (uint32_t page = 0; page < 4; page++) {
+        stream->dirty[page].first = 0;
+        stream->dirty[page].last = 0;
+    }
+}
+
+void
+vdp2_scrn_stream_scroll_set(vdp2_scrn_stream_t *stream,
+  const fix16_vec2_t *scroll)
+{
+    assert(stream != NULL);
+    assert(scroll != NULL);
+
+    const vdp2_scrn_t scroll_screen = stream->config.cell_format->scroll_screen;
+
+    /* As all four planes share the same plane, the scroll screen repeats every
+     * plane */
+    const uint32_t plane_mask_x =
+      ((uint32_t)stream->plane_width << (stream->char_shift + 16)) - 1;
+    const uint32_t plane_mask_y =
+      ((uint32_t)stream->plane_height << (stream->char_shift + 16)) - 1;
+
+    vdp2_scrn_scroll_x_set(scroll_screen, scroll->x & plane_mask_x);
+    vdp2_scrn_scroll_y_set(scroll_screen, scroll->y & plane_mask_y);
+
+    const int32_t x = fix16_int32_to(scroll->x) >> stream->char_shift;
+    const int32_t y = fix16_int32_to(scroll->y) >> stream->char_shift;
+
+    const int32_t view_width = stream->view_width;
+    const int32_t view_height = stream->view_height;
+
+    const int32_t dx = x - stream->origin_x;
+    const int32_t dy = y - stream->origin_y;
+
+    if (!stream->loaded ||
+        (dx >= view_width) || (dx <= -view_width) ||
+        (dy >= view_height) || (dy <= -view_height)) {
+        _rect_load(stream, x, y, x + view_width, y + view_height);
+    } else {
+        /* Newly exposed columns */
+        if (dx > 0) {
+            _rect_load(stream, stream->origin_x + view_width, y,
+              x + view_width, y + view_height);
+        } else if (dx < 0) {
+            _rect_load(stream, x, y, stream->origin_x, y + view_height);
+        }
+
+        /* Newly exposed rows */
+        if (dy > 0) {
+            _rect_load(stream, x, stream->origin_y + view_height,
+              x + view_width, y + view_height);
+        } else if (dy < 0) {
+            _rect_load(stream, x, y, x + view_width, stream->origin_y);
+        }
+    }
+
+    stream->origin_x = x;
+    stream->origin_y = y;
+    stream->loaded = true;
+}
+
+void
+vdp2_scrn_stream_sync(vdp2_scrn_stream_t *stream)
+{
+    assert(stream != NULL);
+
+    const uint32_t row_size = (stream->pnd_size * 2) << stream->page_shift;
+    const uint32_t page_count = stream->page_columns * stream->page_rows;
+
+    uint32_t remaining;
+    remaining = (stream->config.budget == 0) ? UINT32_MAX : stream->config.budget;
+
+    stream->stats.uploaded = 0;
+    stream->stats.deferred = 0;
+    stream->stats.written = stream->written;
+
+    stream->written = 0;
+
+    for (uint32_t i = 0; i < page_count; i++) {
+        const uint32_t page = (stream->page_next + i) % page_count;
+
+        const int16_t first = stream->dirty[page].first;
+        const int16_t last = stream->dirty[page].last;
+
+        if (first >= last) {
+            continue;
+        }
+
+        uint32_t row_count;
+        row_count = last - first;
+
+        if ((row_count * row_size) > remaining) {
+            row_count = remaining / row_size;
+        }
+
+        if (row_count > 0) {
+            const uint32_t offset = (page * stream->page_size) + (first * row_size);
+            const uint32_t len = row_count * row_size;
+
+            const int32_t ret =
+              vdp_dma_enqueue((void *)(stream->config.plane_base + offset),
+                (const uint8_t *)stream->config.shadow + offset,
+                len);
+
+            /* Once the VDP DMA queue is full, nothing more can be uploaded
+             * this frame */
+            if (ret < 0) {
+                remaining = 0;
+            } else {
+                remaining -= len;
+
+                stream->stats.uploaded += len;
+                stream->dirty[page].first += row_count;
+            }
+        }
+
+        /* Rows past the budget, or dropped by a full queue, are kept dirty for
+         * the next frame */
+        stream->stats.deferred +=
+          (stream->dirty[page].last - stream->dirty[page].first) * row_size;
+    }
+
+    /* Otherwise, with a tight budget, the first pages would take all of it
+     * every frame */
+    stream->page_next = (stream->page_next + 1) % page_count;
+}
+
+const vdp2_scrn_stream_stats_t *
+vdp2_scrn_stream_stats_get(const vdp2_scrn_stream_t *stream)
+{
+    assert(stream != NULL);
+
+    return &stream->stats;
+}
+
+static void
+_rect_load(vdp2_scrn_stream_t *stream, int32_t x0, int32_t y0, int32_t x1,
+  int32_t y1)
+{
+    const uint32_t plane_width_mask = stream->plane_width - 1;
+    const uint32_t plane_height_mask = stream->plane_height - 1;
+    const uint32_t page_mask = (1 << stream->page_shift) - 1;
+    const uint32_t page_dimension = 1 << (stream->page_shift * 2);
+
+    uint16_t * const shadow_16 = stream->config.shadow;
+    uint32_t * const shadow_32 = stream->config.shadow;
+
+    for (int32_t y = y0; y < y1; y++) {
+        const uint32_t plane_y = y & plane_height_mask;
+        const uint32_t page_y = plane_y >> stream->page_shift;
+        const uint32_t row = plane_y & page_mask;
+
+        /* Bit mask of pages touched by this row */
+        uint32_t page_bits;
+        page_bits = 0;
+
+        for (int32_t x = x0; x < x1; x++) {
+            const uint32_t plane_x = x & plane_width_mask;
+            const uint32_t page =
+              (page_y * stream->page_columns) + (plane_x >> stream->page_shift);
+            const uint32_t index = (page * page_dimension) +
+              (row << stream->page_shift) + (plane_x & page_mask);
+
+            const uint32_t pnd = _map_pnd_get(stream, x, y);
+
+            if (stream->pnd_size == 1) {
+                shadow_16[index] = pnd;
+            } else {
+                shadow_32[index] = pnd;
+            }
+
+            page_bits |= 1 << page;
+        }
+
+        for (uint32_t page = 0; page_bits != 0; page++, page_bits >>= 1) {
+            if ((page_bits & 1) != 0) {
+                _dirty_mark(stream, page, row);
+            }
+        }
+    }
+
+    if ((x1 > x0) && (y1 > y0)) {
+        stream->written += (x1 - x0) * (y1 - y0);
+    }
+}
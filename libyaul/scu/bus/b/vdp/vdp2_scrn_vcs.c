@@ -5,6 +5,11 @@
  * Israel Jacquez <mrkotfw@gmail.com>
  */
 
+#include <assert.h>
+
+#include <gamemath/fix16/fix16_trig.h>
+
+#include <vdp.h>
 #include <vdp2/scrn.h>
 #include <vdp2/vram.h>
 
@@ -50,3 +55,59 @@ vdp2_scrn_vcs_clear(void)
 {
     _state_vdp2()->shadow_regs.scrctl &= 0xFEFE;
 }
+
+void
+vdp2_scrn_vcs_table_init(vdp2_scrn_vcs_table_t *table,
+  const vdp2_scrn_vcs_format_t *vcs_format, uint16_t count, fix16_t *buffer)
+{
+    assert(table != NULL);
+    assert(vcs_format != NULL);
+    assert(buffer != NULL);
+    assert(count > 0);
+
+    table->format = *vcs_format;
+    table->count = count;
+    table->back = 0;
+    table->buffer = buffer;
+
+    vdp2_scrn_vcs_set(vcs_format);
+}
+
+fix16_t *
+vdp2_scrn_vcs_table_back_get(const vdp2_scrn_vcs_table_t *table)
+{
+    assert(table != NULL);
+
+    return &table->buffer[table->back * table->count];
+}
+
+void
+vdp2_scrn_vcs_table_wobble_build(vdp2_scrn_vcs_table_t *table,
+  const vdp2_scrn_wobble_t *wobble)
+{
+    assert(table != NULL);
+    assert(wobble != NULL);
+
+    fix16_t * const values = vdp2_scrn_vcs_table_back_get(table);
+
+    angle_t angle;
+    angle = wobble->phase;
+
+    for (uint32_t i = 0; i < table->count; i++) {
+        values[i] = wobble->scroll.y + fix16_mul(wobble->amplitude, fix16_sin(angle));
+
+        angle += wobble->frequency;
+    }
+}
+
+void
+vdp2_scrn_vcs_table_sync(vdp2_scrn_vcs_table_t *table)
+{
+    assert(table != NULL);
+
+    vdp_dma_enqueue((void *)table->format.table_base,
+      vdp2_scrn_vcs_table_back_get(table),
+      table->count * sizeof(fix16_t));
+
+    table->back ^= 1;
+}
@@ -11,6 +11,7 @@
 
 #include <cpu/cache.h>
 #include <cpu/dmac.h>
+#include <cpu/frt.h>
 #include <cpu/intc.h>
 
 #include <scu/ic.h>
@@ -133,6 +134,31 @@ static struct {
 
 static_assert(sizeof(_state) == 24);
 
+static struct {
+    vdp_sync_stats_t stats;
+    uint16_t samples[VDP_SYNC_STATS_SAMPLE_COUNT];
+    uint16_t sample_index;
+    uint16_t budget;
+    callback_t overrun_callback;
+} _stats;
+
+static struct {
+    vdp1_sync_pacing_t pacing;
+    vdp1_sync_frame_stats_t frames[VDP1_SYNC_FRAME_STATS_COUNT];
+    uint8_t frame_index;
+    uint8_t frame_flags;
+    bool submitted;
+    uint32_t vblank_count;
+    uint32_t frame_vblank_count;
+    uint32_t frame_start_ticks;
+    uint32_t submit_ticks;
+    uint32_t draw_start_ticks;
+    uint32_t draw_ticks;
+    /* Extends the 16-bit FRT count */
+    uint32_t ticks_high;
+    uint16_t ticks_last;
+} _pacing;
+
 static scu_dma_handle_t _vdp1_dma_handle;
 static scu_dma_handle_t _vdp1_orderlist_dma_handle;
 static scu_dma_handle_t _vdp1_stride_dma_handle;
@@ -144,6 +170,7 @@ static void _dma_queue_transfer(void);
 static callback_t _vdp1_put_callback;
 static callback_t _vdp1_render_callback;
 static callback_t _vdp1_transfer_over_callback;
+static callback_t _vdp1_transfer_over_notify_callback;
 static callback_t _vblank_in_callback;
 static callback_t _vblank_out_callback;
 static callback_list_t *_dma_callback_list;
@@ -237,6 +264,15 @@ static void _vdp1_dma_transfer(const scu_dma_handle_t *dma_handle);
 
 static void _vdp2_init(void);
 
+static void _pacing_init(void);
+static uint32_t _pacing_ticks_get(void);
+static void _pacing_draw_start(void);
+static void _pacing_frame_end(void);
+
+static void _stats_init(void);
+static inline __always_inline void _stats_stage_end(vdp_sync_stage_t stage, uint16_t *ticks);
+static void _stats_vblank_in_end(uint16_t start_ticks);
+
 static void _vdp1_dma_level_end_handler(void *work);
 static void _vblank_in_handler(void);
 static void _vblank_out_handler(void);
@@ -249,6 +285,8 @@ __vdp_sync_init(void)
 
     _state.flags = SYNC_FLAG_NONE;
 
+    _stats_init();
+    _pacing_init();
     _dma_queue_init();
     _vdp1_init();
     _vdp2_init();
@@ -262,10 +300,16 @@ __vdp_sync_init(void)
     scu_ic_mask_chg(SCU_MASK_UNMASK, SCU_IC_MASK_NONE);
 }
 
-void
+int32_t
 vdp_dma_enqueue(void *dst, const void *src, size_t len)
 {
-    dma_queue_enqueue(&_state.dma_queue, dst, src, len);
+    return dma_queue_enqueue(&_state.dma_queue, dst, src, len);
+}
+
+uint32_t
+vdp_sync_ticks_get(void)
+{
+    return _pacing_ticks_get();
 }
 
 uint32_t
@@ -292,6 +336,11 @@ vdp1_sync(void)
 
     _state.flags |= SYNC_FLAG_MASK_V1SVBI | SYNC_FLAG_MASK_V1SVBO;
 
+    if (!_pacing.submitted) {
+        _pacing.submitted = true;
+        _pacing.submit_ticks = _pacing_ticks_get() - _pacing.frame_start_ticks;
+    }
+
     cpu_intc_mask_set(sr_mask);
 
     DEBUG_PRINTF("%s: Exit L%i\n", __function_name, __LINE__);
@@ -520,6 +569,13 @@ vdp1_sync_transfer_over_set(callback_handler_t callback_handler, void *work)
     callback_set(&_vdp1_transfer_over_callback, callback_handler, work);
 }
 
+void
+vdp1_sync_transfer_over_notify_set(callback_handler_t callback_handler,
+  void *work)
+{
+    callback_set(&_vdp1_transfer_over_notify_callback, callback_handler, work);
+}
+
 void
 vdp2_sync(void)
 {
@@ -567,6 +623,105 @@ vdp2_sync_wait(void)
     DEBUG_PRINTF("%s: Exit L%i\n", __function_name, __LINE__);
 }
 
+const vdp_sync_stats_t *
+vdp_sync_stats_get(void)
+{
+    return &_stats.stats;
+}
+
+void
+vdp_sync_stats_clear(void)
+{
+    const uint32_t sr_mask = cpu_intc_mask_get();
+    cpu_intc_mask_set(15);
+
+    const uint16_t bucket_ticks = _stats.stats.bucket_ticks;
+
+    (void)memset(&_stats.stats, 0, sizeof(_stats.stats));
+    (void)memset(_stats.samples, 0, sizeof(_stats.samples));
+
+    _stats.stats.bucket_ticks = bucket_ticks;
+    _stats.stats.histogram[0] = VDP_SYNC_STATS_SAMPLE_COUNT;
+    _stats.sample_index = 0;
+
+    cpu_intc_mask_set(sr_mask);
+}
+
+void
+vdp_sync_stats_bucket_set(uint16_t bucket_ticks)
+{
+    assert(bucket_ticks > 0);
+
+    _stats.stats.bucket_ticks = bucket_ticks;
+
+    /* The samples already in the histogram were bucketed by the previous
+     * width */
+    vdp_sync_stats_clear();
+}
+
+void
+vdp_sync_budget_set(uint16_t ticks)
+{
+    _stats.budget = ticks;
+}
+
+void
+vdp_sync_overrun_set(callback_handler_t callback_handler, void *work)
+{
+    callback_set(&_stats.overrun_callback, callback_handler, work);
+}
+
+uint32_t
+vdp1_sync_frame_stats_get(vdp1_sync_frame_stats_t *frame_stats, uint32_t count)
+{
+    assert(frame_stats != NULL);
+
+    const uint32_t sr_mask = cpu_intc_mask_get();
+    cpu_intc_mask_set(15);
+
+    if (count > _pacing.pacing.frame_count) {
+        count = _pacing.pacing.frame_count;
+    }
+
+    if (count > VDP1_SYNC_FRAME_STATS_COUNT) {
+        count = VDP1_SYNC_FRAME_STATS_COUNT;
+    }
+
+    uint32_t index;
+    index = _pacing.frame_index;
+
+    for (uint32_t i = 0; i < count; i++) {
+        index = (index - 1) & (VDP1_SYNC_FRAME_STATS_COUNT - 1);
+
+        frame_stats[i] = _pacing.frames[index];
+    }
+
+    cpu_intc_mask_set(sr_mask);
+
+    return count;
+}
+
+const vdp1_sync_pacing_t *
+vdp1_sync_pacing_get(void)
+{
+    return &_pacing.pacing;
+}
+
+void
+vdp1_sync_pacing_clear(void)
+{
+    const uint32_t sr_mask = cpu_intc_mask_get();
+    cpu_intc_mask_set(15);
+
+    _pacing.pacing.frame_count = 0;
+    _pacing.pacing.late_count = 0;
+    _pacing.pacing.dropped_count = 0;
+
+    _pacing.frame_index = 0;
+
+    cpu_intc_mask_set(sr_mask);
+}
+
 callback_id_t
 vdp_dma_callback_add(callback_handler_t callback_handler, void *work)
 {
@@ -634,6 +789,173 @@ _dma_queue_transfer(void)
     callback_list_clear(_dma_callback_list);
 }
 
+static void
+_pacing_init(void)
+{
+    _pacing.ticks_high = 0;
+    _pacing.ticks_last = cpu_frt_count_get();
+
+    _pacing.vblank_count = 0;
+    _pacing.frame_vblank_count = 0;
+    _pacing.frame_flags = 0;
+    _pacing.submitted = false;
+    _pacing.submit_ticks = 0;
+    _pacing.draw_ticks = 0;
+    _pacing.frame_start_ticks = _pacing_ticks_get();
+    _pacing.draw_start_ticks = _pacing.frame_start_ticks;
+
+    vdp1_sync_pacing_clear();
+}
+
+static uint32_t
+_pacing_ticks_get(void)
+{
+    /* The FRT wraps in just under 20ms with a divisor of 8, so this is called
+     * at least from both VBLANK-IN and VBLANK-OUT handlers to catch every
+     * wrap */
+    const uint32_t sr_mask = cpu_intc_mask_get();
+    cpu_intc_mask_set(15);
+
+    const uint16_t count = cpu_frt_count_get();
+
+    if (count < _pacing.ticks_last) {
+        _pacing.ticks_high += 0x00010000;
+    }
+
+    _pacing.ticks_last = count;
+
+    const uint32_t ticks = _pacing.ticks_high | count;
+
+    cpu_intc_mask_set(sr_mask);
+
+    return ticks;
+}
+
+static void
+_pacing_draw_start(void)
+{
+    _pacing.draw_start_ticks = _pacing_ticks_get();
+}
+
+static void
+_pacing_frame_end(void)
+{
+    const uint32_t interval = _pacing.vblank_count - _pacing.frame_vblank_count;
+
+    uint32_t target_interval;
+
+    switch (_state.vdp1.interval_mode) {
+    case VDP1_INTERVAL_MODE_FIXED:
+        target_interval = _state.vdp1.frame_rate;
+        break;
+    case VDP1_INTERVAL_MODE_VARIABLE:
+        target_interval = _state.vdp1.frame_rate + 1;
+        break;
+    default:
+        target_interval = 1;
+        break;
+    }
+
+    uint8_t flags;
+    flags = _pacing.frame_flags;
+
+    if (interval > target_interval) {
+        flags |= VDP1_SYNC_FRAME_LATE;
+
+        _pacing.pacing.late_count++;
+    }
+
+    if ((flags & VDP1_SYNC_FRAME_DROPPED) != 0) {
+        _pacing.pacing.dropped_count++;
+    }
+
+    vdp1_sync_frame_stats_t * const frame = &_pacing.frames[_pacing.frame_index];
+
+    frame->submit_ticks = _pacing.submit_ticks;
+    frame->draw_ticks = _pacing.draw_ticks;
+    frame->interval = (interval > UINT8_MAX) ? UINT8_MAX : interval;
+    frame->flags = flags;
+
+    _pacing.frame_index = (_pacing.frame_index + 1) & (VDP1_SYNC_FRAME_STATS_COUNT - 1);
+    _pacing.pacing.frame_count++;
+
+    _pacing.frame_vblank_count = _pacing.vblank_count;
+    _pacing.frame_flags = 0;
+    _pacing.submitted = false;
+    _pacing.submit_ticks = 0;
+    _pacing.draw_ticks = 0;
+    _pacing.frame_start_ticks = _pacing_ticks_get();
+}
+
+static void
+_stats_init(void)
+{
+    callback_init(&_stats.overrun_callback);
+
+    _stats.budget = 0;
+    _stats.stats.bucket_ticks = CPU_FRT_NTSC_320_8_COUNT_1MS / 8;
+
+    vdp_sync_stats_clear();
+}
+
+static inline void __always_inline
+_stats_stage_end(vdp_sync_stage_t stage, uint16_t *ticks)
+{
+    const uint16_t end_ticks = cpu_frt_count_get();
+    /* The FRT is free running, so this is correct across the wrap */
+    const uint16_t delta_ticks = end_ticks - *ticks;
+
+    _stats.stats.stage_ticks[stage] = delta_ticks;
+
+    if (delta_ticks > _stats.stats.stage_ticks_max[stage]) {
+        _stats.stats.stage_ticks_max[stage] = delta_ticks;
+    }
+
+    *ticks = end_ticks;
+}
+
+static void
+_stats_vblank_in_end(uint16_t start_ticks)
+{
+    vdp_sync_stats_t * const stats = &_stats.stats;
+
+    const uint16_t ticks = cpu_frt_count_get() - start_ticks;
+
+    stats->vblank_in_ticks = ticks;
+    stats->frame_count++;
+
+    /* Replace the oldest sample in the rolling histogram */
+    uint32_t bucket;
+    bucket = _stats.samples[_stats.sample_index] / stats->bucket_ticks;
+
+    if (bucket >= VDP_SYNC_STATS_BUCKET_COUNT) {
+        bucket = VDP_SYNC_STATS_BUCKET_COUNT - 1;
+    }
+
+    stats->histogram[bucket]--;
+
+    bucket = ticks / stats->bucket_ticks;
+
+    if (bucket >= VDP_SYNC_STATS_BUCKET_COUNT) {
+        bucket = VDP_SYNC_STATS_BUCKET_COUNT - 1;
+    }
+
+    stats->histogram[bucket]++;
+
+    _stats.samples[_stats.sample_index] = ticks;
+    _stats.sample_index = (_stats.sample_index + 1) & (VDP_SYNC_STATS_SAMPLE_COUNT - 1);
+
+    const bool over_budget = (_stats.budget != 0) && (ticks > _stats.budget);
+
+    /* Still being in VBLANK is the only reliable indication that the display
+     * wasn't disturbed */
+    if (!(vdp2_tvmd_vblank_in()) || over_budget) {
+        stats->overrun_count++;
+
+        callback_call(&_stats.overrun_callback);
+    }
+}
+
 static void
 _vdp1_init(void)
 {
@@ -671,6 +993,7 @@ _vdp1_init(void)
     callback_init(&_vdp1_put_callback);
     callback_init(&_vdp1_render_callback);
     callback_init(&_vdp1_transfer_over_callback);
+    callback_init(&_vdp1_transfer_over_notify_callback);
 
     _state.vdp1.flags = VDP1_FLAG_IDLE;
     _state.vdp1.current_mode = NULL;
@@ -698,6 +1021,7 @@ _vdp1_transfer_over_process(void)
 
     if ((transfer_status.cef | transfer_status.bef) == 0) {
         callback_call(&_vdp1_transfer_over_callback);
+        callback_call(&_vdp1_transfer_over_notify_callback);
     }
 }
 
@@ -764,6 +1088,8 @@ _vdp1_sprite_end_call(void)
      * interrupt */
     _state.flags &= ~SYNC_FLAG_VDP1_VBLANK_OUT;
 
+    _pacing.draw_ticks = _pacing_ticks_get() - _pacing.draw_start_ticks;
+
     _state.vdp1.current_mode->sprite_end();
 
     _state.flags |= SYNC_FLAG_VDP1_VBLANK_OUT;
@@ -794,6 +1120,8 @@ _vdp1_mode_auto_dma(void)
 
     vdp1_ioregs->ptmr = VDP1_PTMR_AUTO;
 
+    _pacing_draw_start();
+
     _state.vdp1.flags |= VDP1_FLAG_LIST_XFERRED;
 
     callback_call(&_vdp1_put_callback);
@@ -849,6 +1177,8 @@ _vdp1_mode_auto_vblank_out(void)
 
     _vdp1_transfer_over_process();
 
+    _pacing_frame_end();
+
     _state.flags &= ~SYNC_FLAG_VDP1_SYNC;
 
     _state.vdp1.flags &= ~VDP1_FLAG_MASK;
@@ -868,6 +1198,8 @@ _vdp1_mode_fixed_sync_render(void)
     volatile vdp1_ioregs_t * const vdp1_ioregs = (volatile vdp1_ioregs_t *)VDP1_IOREG_BASE;
 
     vdp1_ioregs->ptmr = VDP1_PTMR_PLOT;
+
+    _pacing_draw_start();
 }
 
 static void
@@ -926,6 +1258,8 @@ _vdp1_mode_fixed_vblank_in(void)
         if (!list_committed && !transfer_status.cef) {
             vdp1_ioregs->ptmr = VDP1_PTMR_IDLE;
 
+            _pacing.frame_flags |= VDP1_SYNC_FRAME_DROPPED;
+
             _vdp1_sprite_end_call();
         }
 
@@ -962,6 +1296,8 @@ _vdp1_mode_fixed_vblank_out(void)
 
     _vdp1_transfer_over_process();
 
+    _pacing_frame_end();
+
     _state.flags &= ~SYNC_FLAG_VDP1_SYNC;
 
     state_vdp1_flags &= ~VDP1_FLAG_MASK;
@@ -983,6 +1319,8 @@ _vdp1_mode_variable_sync_render(void)
     volatile vdp1_ioregs_t * const vdp1_ioregs = (volatile vdp1_ioregs_t *)VDP1_IOREG_BASE;
 
     vdp1_ioregs->ptmr = VDP1_PTMR_PLOT;
+
+    _pacing_draw_start();
 }
 
 static void
@@ -1086,6 +1424,8 @@ _vdp1_mode_variable_vblank_out(void)
      * following the VBLANK-OUT interrupt */
     vdp2_tvmd_vcount_wait(0);
 
+    _pacing_frame_end();
+
     _state.flags &= ~SYNC_FLAG_VDP1_SYNC;
 
     state_vdp1_flags &= ~VDP1_FLAG_MASK;
@@ -1173,6 +1513,15 @@ _vblank_in_handler(void)
 
     DEBUG_PRINTF("_state.vdp1.flags: 0x%02X\n", _state.vdp1.flags);
 
+    const uint16_t start_ticks = cpu_frt_count_get();
+
+    uint16_t ticks;
+    ticks = start_ticks;
+
+    _pacing.vblank_count++;
+
+    (void)_pacing_ticks_get();
+
     uint8_t state_flags;
     state_flags = _state.flags;
 
@@ -1180,17 +1529,29 @@ _vblank_in_handler(void)
         _vdp1_vblank_in_call();
     }
 
+    _stats_stage_end(VDP_SYNC_STAGE_VDP1_VBLANK_IN, &ticks);
+
     callback_call(&_vblank_in_callback);
 
+    _stats_stage_end(VDP_SYNC_STAGE_VBLANK_IN_CALLBACK, &ticks);
+
     /* VBLANK-IN interrupt runs at scanline #224 */
     if ((state_flags & SYNC_FLAG_VDP2_SYNC) == SYNC_FLAG_VDP2_SYNC) {
         _vdp2_sync_commit();
     }
 
+    _stats_stage_end(VDP_SYNC_STAGE_VDP2_COMMIT, &ticks);
+
     _dma_queue_transfer();
 
+    _stats_stage_end(VDP_SYNC_STAGE_DMA_QUEUE, &ticks);
+
     _vdp2_sync_commit_wait();
 
+    _stats_stage_end(VDP_SYNC_STAGE_VDP2_COMMIT_WAIT, &ticks);
+
+    _stats_vblank_in_end(start_ticks);
+
     state_flags &= ~SYNC_FLAG_VDP2_SYNC;
 
     _state.flags = state_flags;
@@ -1205,11 +1566,24 @@ _vblank_out_handler(void)
 
     /* VBLANK-OUT interrupt runs at scanline #511 */
 
+    const uint16_t start_ticks = cpu_frt_count_get();
+
+    uint16_t ticks;
+    ticks = start_ticks;
+
+    (void)_pacing_ticks_get();
+
     if ((_state.flags & SYNC_FLAG_MASK_V1SVBO) == SYNC_FLAG_MASK_V1SVBO) {
         _vdp1_vblank_out_call();
     }
 
+    _stats_stage_end(VDP_SYNC_STAGE_VDP1_VBLANK_OUT, &ticks);
+
     callback_call(&_vblank_out_callback);
 
+    _stats_stage_end(VDP_SYNC_STAGE_VBLANK_OUT_CALLBACK, &ticks);
+
+    _stats.stats.vblank_out_ticks = ticks - start_ticks;
+
     DEBUG_PRINTF("%s: Exit L%i\n", __function_name, __LINE__);
 }
@@ -18,7 +18,9 @@
 #include <cpu/frt.h>
 #include <cpu/instructions.h>
 #include <cpu/intc.h>
+#include <cpu/job.h>
 #include <cpu/registers.h>
+#include <cpu/ring.h>
 #include <cpu/sci.h>
 #include <cpu/sync.h>
 #include <cpu/wdt.h>
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) Israel Jacquez
+ * See LICENSE for details.
+ *
+ * Israel Jacquez <mrkotfw@gmail.com>
+ */
+
+#ifndef _YAUL_CPU_JOB_H_
+#define _YAUL_CPU_JOB_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <sys/cdefs.h>
+
+#include <cpu/sync.h>
+#include <cpu/which.h>
+
+__BEGIN_DECLS
+
+/// @defgroup CPU_JOB CPU Jobs
+///
+/// @details A job scheduler that spreads work across the master and slave
+/// CPUs.
+///
+/// Each CPU owns a deque of jobs. A CPU pushes and pops jobs at the bottom of
+/// its own deque, and when its deque is empty, steals the oldest job from the
+/// top of the other CPU's deque.
+///
+/// The slave CPU executes jobs from its CPU-FRT ICI handler. Submitting a job
+/// from the master CPU notifies the slave CPU. The master CPU executes jobs
+/// while in @ref cpu_job_wait.
+///
+/// A job can be the parent of other jobs. A job is finished only once it and
+/// all of its children have finished. Children must be submitted before the
+/// parent job function returns.
+///
+/// Cache rules:
+///
+/// - Job structures are always accessed through the cache-through mirror, and
+///   may be placed anywhere in HWRAM, including the stack, so long as they
+///   outlive the job.
+/// - Before a job function is called on a CPU other than the one that
+///   submitted it, the work area of the job is purged from the cache of the
+///   executing CPU.
+/// - Before @ref cpu_job_wait returns, the work area of the job is purged
+///   from the cache of the waiting CPU if the other CPU executed the job, or
+///   any of its children.
+/// - Only the work area of the job being waited on is purged. Any data written
+///   by the children of a job must be covered by the work area of the parent
+///   job, or be accessed through the cache-through mirror.
+/// - Any other shared data must be accessed through the cache-through mirror,
+///   or be purged by the user.
+
+/// @addtogroup CPU_JOB
+/// @{
+
+/// @brief Maximum number of jobs in a CPU's deque.
+#define CPU_JOB_DEQUE_COUNT (64)
+
+/// @brief Number of consecutive locks used in the BIOS lock array.
+#define CPU_JOB_LOCK_COUNT  (3)
+
+/// @brief Not yet documented.
+typedef struct cpu_job cpu_job_t;
+
+/// @brief Job function.
+///
+/// @param job  The job being executed.
+/// @param work The work area of the job.
+typedef void (*cpu_job_func_t)(cpu_job_t *job, void *work);
+
+/// @brief Job.
+///
+/// @details Use @ref cpu_job_create to initialize. The fields are private.
+struct cpu_job {
+    cpu_job_func_t func;
+    void *work;
+    uint32_t work_size;
+    cpu_job_t *parent;
+    volatile uint32_t unfinished;
+    volatile cpu_which_t submitter;
+    /* Bit N is set once CPU N executed the job or one of its children */
+    volatile uint8_t executors;
+};
+
+/// @brief Initialize the job scheduler.
+///
+/// @details Changes the master-slave CPU communication mode to
+/// @ref CPU_DUAL_ENTRY_ICI, and sets the slave CPU entry handler. Any entry
+/// handler previously set via @ref cpu_dual_slave_set is replaced.
+///
+/// @param lock_base The first of @ref CPU_JOB_LOCK_COUNT consecutive locks in
+///                  the BIOS lock array.
+extern void cpu_job_init(cpu_sync_lock_t lock_base);
+
+/// @brief Initialize a job.
+///
+/// @param[out] job       The job.
+/// @param      func      The job function.
+/// @param      work      The work area passed to @p func. Can be `NULL`.
+/// @param      work_size The size of the work area in bytes.
+/// @param      parent    The parent job. Can be `NULL`.
+extern void cpu_job_create(cpu_job_t *job, cpu_job_func_t func, void *work,
+    uint32_t work_size, cpu_job_t *parent);
+
+/// @brief Submit a job to the deque of the calling CPU.
+///
+/// @param job The job.
+///
+/// @returns `0` on success, or `-1` if the deque is full, in which case the
+/// job is not submitted.
+extern int cpu_job_submit(cpu_job_t *job);
+
+/// @brief Determine if a job and all of its children have finished.
+///
+/// @param job The job.
+///
+/// @returns `true` if finished, otherwise `false`.
+extern bool cpu_job_done(const cpu_job_t *job);
+
+/// @brief Wait for a job and all of its children to finish.
+///
+/// @details While waiting, the calling CPU executes jobs from its own deque,
+/// or steals jobs from the other CPU.
+///
+/// @param job The job.
+extern void cpu_job_wait(cpu_job_t *job);
+
+/// @}
+
+__END_DECLS
+
+#endif /* !_YAUL_CPU_JOB_H_ */
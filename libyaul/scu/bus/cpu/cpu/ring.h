@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) Israel Jacquez
+ * See LICENSE for details.
+ *
+ * Israel Jacquez <mrkotfw@gmail.com>
+ */
+
+#ifndef _YAUL_CPU_RING_H_
+#define _YAUL_CPU_RING_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <sys/cdefs.h>
+
+#include <cpu/sync.h>
+
+__BEGIN_DECLS
+
+/// @defgroup CPU_RING CPU Ring Buffers
+///
+/// @details Lock-free ring buffers to exchange data between the master and
+/// slave CPUs.
+///
+/// The ring and its element buffer are always accessed through the
+/// cache-through mirror, so neither CPU has to purge its cache to see what
+/// the other CPU has written.
+///
+/// A single-producer/single-consumer ring requires no locking. A
+/// multi-producer/single-consumer ring serializes the producers with a lock
+/// from the BIOS lock array (see @ref CPU_SYNC).
+
+/// @addtogroup CPU_RING
+/// @{
+
+/// @brief Ring buffer flags.
+typedef enum cpu_ring_flags {
+    /// @brief Single-producer/single-consumer.
+    CPU_RING_FLAG_NONE   = 0,
+    /// @brief Allow more than one producer.
+    CPU_RING_FLAG_MP     = 1 << 0,
+    /// @brief Notify the other CPU when the ring goes from empty to non-empty.
+    CPU_RING_FLAG_NOTIFY = 1 << 1
+} cpu_ring_flags_t;
+
+/// @brief Ring buffer.
+///
+/// @details The head and tail indices are free running, and are only masked
+/// when indexing into the element buffer.
+typedef struct cpu_ring {
+    /// @brief Index of the next element to pop. Only written by the consumer.
+    volatile uint32_t head;
+    /// @brief Index of the next element to push. Only written by the
+    /// producer(s).
+    volatile uint32_t tail;
+    /// @brief Number of elements minus one.
+    uint32_t mask;
+    /// @brief Size of an element in bytes.
+    uint32_t size;
+    /// @brief Element buffer.
+    uint8_t *buffer;
+    /// @brief Flags.
+    cpu_ring_flags_t flags;
+    /// @brief Lock index used when @ref CPU_RING_FLAG_MP is set.
+    cpu_sync_lock_t lock;
+} cpu_ring_t;
+
+/// @brief Initialize a ring buffer.
+///
+/// @param[out] ring   The ring buffer.
+/// @param      buffer The element buffer of `count * size` bytes. Must be in
+///                    HWRAM.
+/// @param      count  Number of elements. Must be a power of two.
+/// @param      size   Size of an element in bytes.
+/// @param      flags  Flags.
+/// @param      lock   Lock index. Only used when @ref CPU_RING_FLAG_MP is set.
+extern void cpu_ring_init(cpu_ring_t *ring, void *buffer, uint32_t count,
+    uint32_t size, cpu_ring_flags_t flags, cpu_sync_lock_t lock);
+
+/// @brief Push up to @p count elements.
+///
+/// @details When @ref CPU_RING_FLAG_NOTIFY is set, the other CPU is notified
+/// at most once per call, and only when the ring was empty.
+///
+/// @param ring     The ring buffer.
+/// @param elements The elements to push.
+/// @param count    Number of elements.
+///
+/// @returns The number of elements pushed.
+extern uint32_t cpu_ring_push(cpu_ring_t *ring, const void *elements,
+    uint32_t count);
+
+/// @brief Pop up to @p count elements.
+///
+/// @details Only one CPU may pop from a ring.
+///
+/// @param      ring     The ring buffer.
+/// @param[out] elements The popped elements.
+/// @param      count    Number of elements.
+///
+/// @returns The number of elements popped.
+extern uint32_t cpu_ring_pop(cpu_ring_t *ring, void *elements, uint32_t count);
+
+/// @brief Obtain the number of elements in the ring.
+///
+/// @param ring The ring buffer.
+///
+/// @returns The number of elements.
+extern uint32_t cpu_ring_count_get(const cpu_ring_t *ring);
+
+/// @}
+
+__END_DECLS
+
+#endif /* !_YAUL_CPU_RING_H_ */
@@ -0,0 +1,265 @@
+/*
+ * Copyright (c) Israel Jacquez
+ * See LICENSE for details.
+ *
+ * Israel Jacquez <mrkotfw@gmail.com>
+ */
+
+#include <assert.h>
+
+#include <cpu/cache.h>
+#include <cpu/dual.h>
+#include <cpu/intc.h>
+#include <cpu/job.h>
+#include <cpu/sync.h>
+
+#define LOCK_DEQUE(which)       (_lock_base + (which))
+#define LOCK_COUNTER()          (_lock_base + 2)
+
+typedef struct {
+    cpu_job_t *jobs[CPU_JOB_DEQUE_COUNT];
+    /* Next job to steal */
+    uint32_t top;
+    /* Next free slot */
+    uint32_t bottom;
+} deque_t;
+
+static deque_t _deques[2] __uncached;
+
+static cpu_sync_lock_t _lock_base __uncached;
+
+static void _slave_entry(void);
+
+static cpu_job_t *_deque_take(cpu_which_t owner, cpu_which_t which);
+
+static bool _job_run_one(cpu_which_t which);
+static void _job_finish(volatile cpu_job_t *job_through);
+
+static inline volatile cpu_job_t * __always_inline
+_job_through(const cpu_job_t *job)
+{
+    return (volatile cpu_job_t *)(CPU_CACHE_THROUGH | (uintptr_t)job);
+}
+
+void
+cpu_job_init(cpu_sync_lock_t lock_base)
+{
+    _lock_base = lock_base;
+
+    for (uint32_t i = 0; i < 2; i++) {
+        _deques[i].top = 0;
+        _deques[i].bottom = 0;
+    }
+
+    cpu_sync_spinlock_clear(LOCK_DEQUE(CPU_MASTER));
+    cpu_sync_spinlock_clear(LOCK_DEQUE(CPU_SLAVE));
+    cpu_sync_spinlock_clear(LOCK_COUNTER());
+
+    cpu_dual_slave_set(_slave_entry);
+    cpu_dual_comm_mode_set(CPU_DUAL_ENTRY_ICI);
+}
+
+void
+cpu_job_create(cpu_job_t *job, cpu_job_func_t func, void *work,
+    uint32_t work_size, cpu_job_t *parent)
+{
+    assert(job != NULL);
+    assert(func != NULL);
+
+    volatile cpu_job_t * const job_through = _job_through(job);
+
+    job_through->func = func;
+    job_through->work = work;
+    job_through->work_size = (work != NULL) ? work_size : 0;
+    job_through->parent = parent;
+    job_through->unfinished = 1;
+    job_through->submitter = CPU_MASTER;
+    job_through->executors = 0x00;
+}
+
+int
+cpu_job_submit(cpu_job_t *job)
+{
+    assert(job != NULL);
+
+    volatile cpu_job_t * const job_through = _job_through(job);
+
+    const cpu_which_t which = cpu_dual_executor_get();
+
+    deque_t * const deque = &_deques[which];
+
+    job_through->submitter = which;
+
+    const uint32_t sr_mask = cpu_intc_mask_get();
+    cpu_intc_mask_set(15);
+
+    cpu_sync_spinlock(LOCK_DEQUE(which));
+
+    if ((deque->bottom - deque->top) >= CPU_JOB_DEQUE_COUNT) {
+        cpu_sync_spinlock_clear(LOCK_DEQUE(which));
+
+        cpu_intc_mask_set(sr_mask);
+
+        return -1;
+    }
+
+    /* The parent must account for the child before the child can possibly
+     * be executed, or else the parent could finish early */
+    if (job_through->parent != NULL) {
+        volatile cpu_job_t * const parent_through =
+            _job_through(job_through->parent);
+
+        cpu_sync_spinlock(LOCK_COUNTER());
+        parent_through->unfinished++;
+        cpu_sync_spinlock_clear(LOCK_COUNTER());
+    }
+
+    deque->jobs[deque->bottom % CPU_JOB_DEQUE_COUNT] = job;
+    deque->bottom++;
+
+    cpu_sync_spinlock_clear(LOCK_DEQUE(which));
+
+    cpu_intc_mask_set(sr_mask);
+
+    if (which == CPU_MASTER) {
+        cpu_dual_slave_notify();
+    }
+
+    return 0;
+}
+
+bool
+cpu_job_done(const cpu_job_t *job)
+{
+    assert(job != NULL);
+
+    return (_job_through(job)->unfinished == 0);
+}
+
+void
+cpu_job_wait(cpu_job_t *job)
+{
+    assert(job != NULL);
+
+    volatile cpu_job_t * const job_through = _job_through(job);
+
+    const cpu_which_t which = cpu_dual_executor_get();
+
+    while (job_through->unfinished != 0) {
+        (void)_job_run_one(which);
+    }
+
+    /* The children of the job may have executed on the other CPU, even when
+     * the job itself executed on the waiting CPU */
+    const uint8_t other_executor = 1 << (which ^ 1);
+
+    if (((job_through->executors & other_executor) != 0x00) &&
+        (job_through->work != NULL)) {
+        cpu_cache_area_purge(job_through->work, job_through->work_size);
+    }
+}
+
+static void
+_slave_entry(void)
+{
+    while ((_job_run_one(CPU_SLAVE))) {
+    }
+}
+
+static cpu_job_t *
+_deque_take(cpu_which_t owner, cpu_which_t which)
+{
+    deque_t * const deque = &_deques[owner];
+
+    cpu_job_t *job;
+    job = NULL;
+
+    const uint32_t sr_mask = cpu_intc_mask_get();
+    cpu_intc_mask_set(15);
+
+    cpu_sync_spinlock(LOCK_DEQUE(owner));
+
+    if (deque->bottom != deque->top) {
+        if (owner == which) {
+            /* The owner pops the most recently pushed job */
+            deque->bottom--;
+            job = deque->jobs[deque->bottom % CPU_JOB_DEQUE_COUNT];
+        } else {
+            /* A thief steals the oldest job */
+            job = deque->jobs[deque->top % CPU_JOB_DEQUE_COUNT];
+            deque->top++;
+        }
+    }
+
+    cpu_sync_spinlock_clear(LOCK_DEQUE(owner));
+
+    cpu_intc_mask_set(sr_mask);
+
+    return job;
+}
+
+static bool
+_job_run_one(cpu_which_t which)
+{
+    cpu_job_t *job;
+    job = _deque_take(which, which);
+
+    if (job == NULL) {
+        job = _deque_take(which ^ 1, which);
+    }
+
+    if (job == NULL) {
+        return false;
+    }
+
+    volatile cpu_job_t * const job_through = _job_through(job);
+
+    /* None of the children can have finished yet, as the job function
+     * submits them */
+    job_through->executors |= 1 << which;
+
+    void * const work = job_through->work;
+
+    if ((job_through->submitter != which) && (work != NULL)) {
+        cpu_cache_area_purge(work, job_through->work_size);
+    }
+
+    job_through->func(job, work);
+
+    _job_finish(job_through);
+
+    return true;
+}
+
+static void
+_job_finish(volatile cpu_job_t *job_through)
+{
+    while (job_through != NULL) {
+        /* Once the counter reaches zero, a waiter is free to reuse the job, so
+         * the parent has to be read beforehand */
+        cpu_job_t * const parent = job_through->parent;
+
+        const uint32_t sr_mask = cpu_intc_mask_get();
+        cpu_intc_mask_set(15);
+
+        cpu_sync_spinlock(LOCK_COUNTER());
+
+        const uint32_t unfinished = --job_through->unfinished;
+
+        /* Hand the executors over to the parent before its counter is
+         * decremented, so that a waiter on the parent sees them */
+        if ((unfinished == 0) && (parent != NULL)) {
+            _job_through(parent)->executors |= job_through->executors;
+        }
+
+        cpu_sync_spinlock_clear(LOCK_COUNTER());
+
+        cpu_intc_mask_set(sr_mask);
+
+        if (unfinished != 0) {
+            break;
+        }
+
+        job_through = (parent != NULL) ? _job_through(parent) : NULL;
+    }
+}
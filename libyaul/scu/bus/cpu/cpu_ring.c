@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) Israel Jacquez
+ * See LICENSE for details.
+ *
+ * Israel Jacquez <mrkotfw@gmail.com>
+ */
+
+#include <assert.h>
+#include <string.h>
+
+#include <cpu/cache.h>
+#include <cpu/dual.h>
+#include <cpu/intc.h>
+#include <cpu/ring.h>
+#include <cpu/sync.h>
+
+static inline volatile cpu_ring_t * __always_inline
+_ring_through(const cpu_ring_t *ring)
+{
+    return (volatile cpu_ring_t *)(CPU_CACHE_THROUGH | (uintptr_t)ring);
+}
+
+static uint32_t _push(volatile cpu_ring_t *ring, const void *elements,
+    uint32_t count, bool *was_empty);
+static void _notify(void);
+
+void
+cpu_ring_init(cpu_ring_t *ring, void *buffer, uint32_t count, uint32_t size,
+    cpu_ring_flags_t flags, cpu_sync_lock_t lock)
+{
+    assert(ring != NULL);
+    assert(buffer != NULL);
+    assert(count > 0);
+    assert((count & (count - 1)) == 0);
+    assert(size > 0);
+
+    volatile cpu_ring_t * const ring_through = _ring_through(ring);
+
+    ring_through->head = 0;
+    ring_through->tail = 0;
+    ring_through->mask = count - 1;
+    ring_through->size = size;
+    ring_through->buffer = (uint8_t *)(CPU_CACHE_THROUGH | (uintptr_t)buffer);
+    ring_through->flags = flags;
+    ring_through->lock = lock;
+
+    if ((flags & CPU_RING_FLAG_MP) != 0) {
+        cpu_sync_spinlock_clear(lock);
+    }
+
+    /* Drop any lines of the ring that may be in the cache of this CPU */
+    cpu_cache_area_purge(ring, sizeof(cpu_ring_t));
+}
+
+uint32_t
+cpu_ring_push(cpu_ring_t *ring, const void *elements, uint32_t count)
+{
+    assert(ring != NULL);
+    assert(elements != NULL);
+
+    volatile cpu_ring_t * const ring_through = _ring_through(ring);
+
+    bool was_empty;
+    uint32_t pushed;
+
+    if ((ring_through->flags & CPU_RING_FLAG_MP) != 0) {
+        /* Prevent an interrupt handler on this CPU that also pushes from
+         * spinning forever on the lock */
+        const uint32_t sr_mask = cpu_intc_mask_get();
+        cpu_intc_mask_set(15);
+
+        cpu_sync_spinlock(ring_through->lock);
+
+        pushed = _push(ring_through, elements, count, &was_empty);
+
+        cpu_sync_spinlock_clear(ring_through->lock);
+
+        cpu_intc_mask_set(sr_mask);
+    } else {
+        pushed = _push(ring_through, elements, count, &was_empty);
+    }
+
+    if ((pushed > 0) && was_empty &&
+        ((ring_through->flags & CPU_RING_FLAG_NOTIFY) != 0)) {
+        _notify();
+    }
+
+    return pushed;
+}
+
+uint32_t
+cpu_ring_pop(cpu_ring_t *ring, void *elements, uint32_t count)
+{
+    assert(ring != NULL);
+    assert(elements != NULL);
+
+    volatile cpu_ring_t * const ring_through = _ring_through(ring);
+
+    const uint32_t head = ring_through->head;
+    const uint32_t available = ring_through->tail - head;
+
+    if (count > available) {
+        count = available;
+    }
+
+    const uint32_t size = ring_through->size;
+    const uint32_t mask = ring_through->mask;
+    uint8_t * const buffer = ring_through->buffer;
+
+    uint8_t *out;
+    out = elements;
+
+    for (uint32_t i = 0; i < count; i++) {
+        (void)memcpy(out, &buffer[((head + i) & mask) * size], size);
+
+        out += size;
+    }
+
+    /* Publish only after the elements have been copied out, as the producer
+     * is then free to overwrite them */
+    ring_through->head = head + count;
+
+    return count;
+}
+
+uint32_t
+cpu_ring_count_get(const cpu_ring_t *ring)
+{
+    assert(ring != NULL);
+
+    volatile cpu_ring_t * const ring_through = _ring_through(ring);
+
+    return (ring_through->tail - ring_through->head);
+}
+
+static uint32_t
+_push(volatile cpu_ring_t *ring, const void *elements, uint32_t count,
+    bool *was_empty)
+{
+    const uint32_t tail = ring->tail;
+    const uint32_t free_count = (ring->mask + 1) - (tail - ring->head);
+
+    if (count > free_count) {
+        count = free_count;
+    }
+
+    const uint32_t size = ring->size;
+    const uint32_t mask = ring->mask;
+    uint8_t * const buffer = ring->buffer;
+
+    const uint8_t *in;
+    in = elements;
+
+    for (uint32_t i = 0; i < count; i++) {
+        (void)memcpy(&buffer[((tail + i) & mask) * size], in, size);
+
+        in += size;
+    }
+
+    /* Publish only after the elements have been written */
+    ring->tail = tail + count;
+
+    /* Checking after publishing guarantees that a consumer that has drained
+     * the ring before the new tail was visible gets notified */
+    *was_empty = (ring->head == tail);
+
+    return count;
+}
+
+static void
+_notify(void)
+{
+    if ((cpu_dual_executor_get()) == CPU_MASTER) {
+        cpu_dual_slave_notify();
+    } else {
+        cpu_dual_master_notify();
+    }
+}
@@ -56,7 +56,9 @@ typedef enum scu_ic_interrupt {
     /// SCU-DMA illegal interrupt.
     SCU_IC_INTERRUPT_DMA_ILLEGAL     = 0x4C,
     /// VDP1 sprite end interrupt.
-    SCU_IC_INTERRUPT_SPRITE_END      = 0x4D
+    SCU_IC_INTERRUPT_SPRITE_END      = 0x4D,
+    /// A-Bus external interrupt #0 (CD-block).
+    SCU_IC_INTERRUPT_EXTERNAL_00     = 0x50
 } scu_ic_interrupt_t;
 
 /// @brief Mask values.
@@ -53,5 +53,7 @@
 #include <sys/dma-queue.h>
 
 #include <fs/cd/cdfs.h>
+#include <fs/fmv/fmv.h>
+#include <fs/pack/pack.h>
 
 #endif /* !_YAUL_H_ */
@@ -21,8 +21,10 @@
 #include <errno.h>
 #include <inttypes.h>
 #include <math.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "shared.h"
 
@@ -31,6 +33,10 @@
 /* The maximum number of nodes in the Huffman tree is 2^(8+1)-1 = 511 */
 #define MAX_TREE_NODES 511
 
+/* Canonical codes are limited in length so that they fit in a nibble */
+#define CANONICAL_MAX_BITS    (15)
+#define CANONICAL_HEADER_SIZE (128)
+
 typedef struct {
     uint8_t *byte_ptr;
     uint32_t bit_pos;
@@ -59,18 +65,24 @@ struct huff_decodenode {
 };
 
 int _huffman_compress(uint8_t *in, uint8_t *out, uint32_t in_size);
+int _huffman_canonical_compress(uint8_t *in, uint8_t *out, uint32_t in_size);
 
 int
 main(int argc, char *argv[])
 {
-    if (argc != 3) {
-        print_usage(PROGNAME);
+    /* With -c, use canonical codes, to be decompressed with
+     * bcl_huffman_canonical_decompress() */
+    const bool canonical = (argc == 4) && ((strcmp(argv[1], "-c")) == 0);
+
+    if ((argc != 3) && !canonical) {
+        (void)fprintf(stderr, "Usage: %s [-c] [in-file] [out-file]\n",
+            PROGNAME);
 
         return 0;
     }
 
-    const char * const in_filename = argv[1];
-    const char * const out_filename = argv[2];
+    const char * const in_filename = argv[argc - 2];
+    const char * const out_filename = argv[argc - 1];
 
     input_file_t input_file;
 
@@ -88,14 +100,21 @@ main(int argc, char *argv[])
      * larger plus 1 byte */
     size_t out_size = (size_t)floor(1.004f * (float)input_file.buffer_len) + 1;
 
+    /* Limiting code lengths can make codes longer than 8 bits, and the code
+     * lengths are stored up front */
+    if (canonical) {
+        out_size = (2 * input_file.buffer_len) + CANONICAL_HEADER_SIZE;
+    }
+
     if ((out_buffer = malloc(out_size)) == NULL) {
         print_errno(PROGNAME);
 
         return 1;
     }
 
-    const uint32_t out_file_size =
-      _huffman_compress(input_file.buffer, out_buffer, input_file.buffer_len);
+    const uint32_t out_file_size = (canonical)
+        ? _huffman_canonical_compress(input_file.buffer, out_buffer, input_file.buffer_len)
+        : _huffman_compress(input_file.buffer, out_buffer, input_file.buffer_len);
 
     (void)printf("%zu -> %"PRIu32"\n", input_file.buffer_len, out_file_size);
 
@@ -328,3 +347,182 @@ _huffman_compress(uint8_t *in, uint8_t *out, uint32_t in_size)
 
     return total_bytes;
 }
+
+/* Calculate Huffman code lengths, limited to CANONICAL_MAX_BITS */
+static void
+_huffman_lengths_calculate(const huff_sym_t *sym, uint32_t *lengths)
+{
+    int32_t parents[2 * 256];
+    uint32_t counts[2 * 256];
+    bool alive[2 * 256];
+    uint32_t k, node_count;
+
+    for (k = 0; k < 256; ++k) {
+        parents[k] = -1;
+        counts[k] = sym[k].count;
+        alive[k] = (sym[k].count > 0);
+        lengths[k] = 0;
+    }
+
+    /* Join the two lightest nodes until there is only one node left */
+    for (node_count = 256; ; ++node_count) {
+        int32_t node_1, node_2;
+
+        node_1 = -1;
+        node_2 = -1;
+
+        for (k = 0; k < node_count; ++k) {
+            if (!alive[k]) {
+                continue;
+            }
+
+            if ((node_1 < 0) || (counts[k] < counts[node_1])) {
+                node_2 = node_1;
+                node_1 = k;
+            } else if ((node_2 < 0) || (counts[k] < counts[node_2])) {
+                node_2 = k;
+            }
+        }
+
+        if (node_2 < 0) {
+            break;
+        }
+
+        parents[node_1] = node_count;
+        parents[node_2] = node_count;
+        alive[node_1] = false;
+        alive[node_2] = false;
+
+        parents[node_count] = -1;
+        counts[node_count] = counts[node_1] + counts[node_2];
+        alive[node_count] = true;
+    }
+
+    uint32_t length_counts[256];
+
+    (void)memset(length_counts, 0, sizeof(length_counts));
+
+    for (k = 0; k < 256; ++k) {
+        if (sym[k].count == 0) {
+            continue;
+        }
+
+        uint32_t length;
+        length = 0;
+
+        for (int32_t node = k; parents[node] >= 0; node = parents[node]) {
+            ++length;
+        }
+
+        /* Special case: only one symbol */
+        if (length == 0) {
+            length = 1;
+        }
+
+        ++length_counts[length];
+    }
+
+    /* Move the deepest codes up the tree, two at a time, by pairing each
+     * with a shorter code pushed down a level (JPEG, Annex K.3) */
+    for (uint32_t i = 255; i > CANONICAL_MAX_BITS; --i) {
+        while (length_counts[i] > 0) {
+            uint32_t j;
+
+            for (j = i - 2; length_counts[j] == 0; --j) {
+            }
+
+            length_counts[i] -= 2;
+            length_counts[i - 1] += 1;
+            length_counts[j + 1] += 2;
+            length_counts[j] -= 1;
+        }
+    }
+
+    /* Hand out the lengths, shortest to the most frequent symbols */
+    uint32_t order[256];
+    uint32_t order_count;
+
+    order_count = 0;
+
+    for (k = 0; k < 256; ++k) {
+        if (sym[k].count > 0) {
+            order[order_count++] = k;
+        }
+    }
+
+    for (uint32_t i = 1; i < order_count; ++i) {
+        const uint32_t symbol = order[i];
+        uint32_t j;
+
+        for (j = i; (j > 0) && (sym[order[j - 1]].count < sym[symbol].count); --j) {
+            order[j] = order[j - 1];
+        }
+
+        order[j] = symbol;
+    }
+
+    uint32_t length;
+    length = 1;
+
+    for (k = 0; k < order_count; ++k) {
+        while (length_counts[length] == 0) {
+            ++length;
+        }
+
+        lengths[order[k]] = length;
+        --length_counts[length];
+    }
+}
+
+int
+_huffman_canonical_compress(uint8_t *in, uint8_t *out, uint32_t in_size)
+{
+    huff_sym_t sym[256];
+    huff_bitstream_t stream;
+    uint32_t lengths[256];
+    uint32_t k, total_bytes;
+
+    /* Do we have anything to compress? */
+    if (in_size < 1) {
+        return 0;
+    }
+
+    _huffman_histogram_calculate(in, sym, in_size);
+    _huffman_lengths_calculate(sym, lengths);
+
+    /* Store the code lengths, two to a byte */
+    for (k = 0; k < CANONICAL_HEADER_SIZE; ++k) {
+        out[k] = (lengths[2 * k] << 4) | lengths[(2 * k) + 1];
+    }
+
+    /* Assign codes in order of length, then of symbol */
+    uint32_t code;
+    code = 0;
+
+    for (uint32_t length = 1; length <= CANONICAL_MAX_BITS; ++length) {
+        for (k = 0; k < 256; ++k) {
+            if (lengths[k] == length) {
+                sym[k].code = code++;
+                sym[k].bits = length;
+            }
+        }
+
+        code <<= 1;
+    }
+
+    _huffman_bitstream_init(&stream, &out[CANONICAL_HEADER_SIZE]);
+
+    /* Encode input stream */
+    for (k = 0; k < in_size; ++k) {
+        _huffman_bits_write(&stream, sym[in[k]].code, sym[in[k]].bits);
+    }
+
+    /* Calculate size of output data */
+    total_bytes = (int)(stream.byte_ptr - out);
+
+    if (stream.bit_pos > 0) {
+        ++total_bytes;
+    }
+
+    return total_bytes;
+}
@@ -37,8 +37,9 @@ static int _lz_compress(uint8_t *in, uint8_t *out, uint32_t insize, uint32_t max
 int
 main(int argc, char *argv[])
 {
-    if (argc != 3) {
-        print_usage(PROGNAME);
+    if ((argc != 3) && (argc != 4)) {
+        (void)fprintf(stderr, "Usage: %s [in-file] [out-file] [max-offset]\n",
+            PROGNAME);
 
         return 0;
     }
@@ -46,6 +47,23 @@ main(int argc, char *argv[])
     const char * const in_filename = argv[1];
     const char * const out_filename = argv[2];
 
+    /* Limiting the offset bounds the window needed by the streaming
+     * decoder */
+    uint32_t max_offset;
+    max_offset = LZ_MAX_OFFSET;
+
+    if (argc == 4) {
+        char *end;
+
+        max_offset = strtoul(argv[3], &end, 0);
+
+        if ((*end != '\0') || (max_offset < 3)) {
+            (void)fprintf(stderr, "Error: %s: Invalid max-offset\n", PROGNAME);
+
+            return 1;
+        }
+    }
+
     input_file_t input_file;
 
     if ((input_file_open(in_filename, &input_file)) != 0) {
@@ -69,7 +87,7 @@ main(int argc, char *argv[])
     }
 
     const uint32_t out_file_size =
-      _lz_compress(input_file.buffer, out_buffer, input_file.buffer_len, LZ_MAX_OFFSET);
+      _lz_compress(input_file.buffer, out_buffer, input_file.buffer_len, max_offset);
 
     (void)printf("%zu -> %"PRIu32"\n", input_file.buffer_len, out_file_size);
 
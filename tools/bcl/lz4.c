@@ -0,0 +1,396 @@
+/*
+ * Copyright (c) Israel Jacquez
+ * See LICENSE for details.
+ *
+ * Israel Jacquez <mrkotfw@gmail.com>
+ */
+
+/* Compressor for the LZ4 block format, with optimal parsing. Each position is
+ * priced by the number of bytes it takes to get there, taking token sharing
+ * and length extension bytes into account */
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "shared.h"
+
+#define PROGNAME "bcl_lz4"
+
+#define MIN_MATCH         (4)
+/* The last match has to start at least 12 bytes before the end */
+#define MATCH_FIND_LIMIT  (12)
+/* The last 5 bytes are always literals */
+#define LAST_LITERALS     (5)
+#define MAX_OFFSET        (65535)
+
+#define HASH_BITS         (16)
+#define HASH_SIZE         (1 << HASH_BITS)
+/* Candidates looked at per position */
+#define CHAIN_DEPTH       (256)
+/* Matches at least this long are taken as is */
+#define SUFFICIENT_LENGTH (256)
+/* Match lengths priced individually at each position */
+#define PRICED_LENGTHS    (64)
+
+#define PRICE_MAX         (UINT32_MAX)
+
+typedef struct {
+    uint32_t price;
+    /* Literals leading up to here */
+    uint32_t literal_count;
+    /* Length and offset of the match ending here, or zero for a literal */
+    uint32_t match_length;
+    uint32_t match_offset;
+} node_t;
+
+typedef struct {
+    const uint8_t *in;
+    uint32_t in_size;
+
+    int32_t *head;
+    int32_t *chain;
+    uint32_t inserted;
+} match_finder_t;
+
+static uint32_t _lz4_compress(const uint8_t *in, uint8_t *out, uint32_t in_size);
+
+int
+main(int argc, char *argv[])
+{
+    if (argc != 3) {
+        print_usage(PROGNAME);
+
+        return 0;
+    }
+
+    const char * const in_filename = argv[1];
+    const char * const out_filename = argv[2];
+
+    input_file_t input_file;
+
+    if ((input_file_open(in_filename, &input_file)) != 0) {
+        print_errno(PROGNAME);
+
+        return 1;
+    }
+
+    /* Worst case is all literals, with a length extension byte for every 255
+     * of them */
+    const size_t out_size =
+        input_file.buffer_len + (input_file.buffer_len / 255) + 16;
+
+    void *out_buffer;
+
+    if ((out_buffer = malloc(out_size)) == NULL) {
+        print_errno(PROGNAME);
+
+        return 1;
+    }
+
+    const uint32_t out_file_size =
+      _lz4_compress(input_file.buffer, out_buffer, input_file.buffer_len);
+
+    (void)printf("%zu -> %"PRIu32"\n", input_file.buffer_len, out_file_size);
+
+    if (out_file_size == 0) {
+        fprintf(stderr, "Error: %s: LZ4 compression failed\n", PROGNAME);
+
+        return 1;
+    }
+
+    if ((output_file_write(out_filename, out_buffer, out_file_size)) != 0) {
+        print_errno(PROGNAME);
+
+        return 1;
+    }
+
+    input_file_close(&input_file);
+
+    free(out_buffer);
+
+    return 0;
+}
+
+static inline uint32_t
+_length_extension_size(uint32_t length)
+{
+    return ((length < 15) ? 0 : (1 + ((length - 15) / 255)));
+}
+
+/* Bytes taken up by a run of literals, not counting the token */
+static inline uint32_t
+_literals_price(uint32_t count)
+{
+    return (count + _length_extension_size(count));
+}
+
+/* Bytes taken up by a match: the token, the offset, and any extension bytes */
+static inline uint32_t
+_match_price(uint32_t length)
+{
+    return (1 + 2 + _length_extension_size(length - MIN_MATCH));
+}
+
+static inline uint32_t
+_hash(const uint8_t *p)
+{
+    const uint32_t value =
+        p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+
+    return ((value * 2654435761U) >> (32 - HASH_BITS));
+}
+
+static void
+_match_finder_insert(match_finder_t *finder, uint32_t position)
+{
+    for (; finder->inserted <= position; finder->inserted++) {
+        const uint32_t i = finder->inserted;
+
+        if ((i + MIN_MATCH) > finder->in_size) {
+            continue;
+        }
+
+        const uint32_t hash = _hash(&finder->in[i]);
+
+        finder->chain[i] = finder->head[hash];
+        finder->head[hash] = i;
+    }
+}
+
+/* Find the longest match at position, which is always the cheapest as every
+ * offset costs the same */
+static uint32_t
+_match_find(match_finder_t *finder, uint32_t position, uint32_t max_length,
+    uint32_t *offset)
+{
+    const uint8_t * const in = finder->in;
+
+    uint32_t best_length;
+    best_length = 0;
+
+    int32_t candidate;
+    candidate = finder->chain[position];
+
+    for (uint32_t depth = 0; (depth < CHAIN_DEPTH) && (candidate >= 0); depth++) {
+        const uint32_t distance = position - candidate;
+
+        if (distance > MAX_OFFSET) {
+            break;
+        }
+
+        /* Check the byte that would make this match the longest first */
+        if (in[candidate + best_length] == in[position + best_length]) {
+            uint32_t length;
+
+            for (length = 0; (length < max_length) &&
+                     (in[candidate + length] == in[position + length]); length++) {
+            }
+
+            if (length > best_length) {
+                best_length = length;
+                *offset = distance;
+
+                if (length == max_length) {
+                    break;
+                }
+            }
+        }
+
+        candidate = finder->chain[candidate];
+    }
+
+    return ((best_length >= MIN_MATCH) ? best_length : 0);
+}
+
+static uint8_t *
+_length_write(uint8_t *out, uint32_t length)
+{
+    if (length >= 15) {
+        length -= 15;
+
+        for (; length >= 255; length -= 255) {
+            *out++ = 255;
+        }
+
+        *out++ = length;
+    }
+
+    return out;
+}
+
+static uint8_t *
+_sequence_write(uint8_t *out, const uint8_t *literals, uint32_t literal_count,
+    uint32_t match_length, uint32_t match_offset)
+{
+    const uint32_t literal_nibble = (literal_count < 15) ? literal_count : 15;
+
+    uint32_t match_nibble;
+    match_nibble = 0;
+
+    if (match_length > 0) {
+        const uint32_t length = match_length - MIN_MATCH;
+
+        match_nibble = (length < 15) ? length : 15;
+    }
+
+    *out++ = (literal_nibble << 4) | match_nibble;
+
+    out = _length_write(out, literal_count);
+
+    (void)memcpy(out, literals, literal_count);
+    out += literal_count;
+
+    if (match_length > 0) {
+        *out++ = match_offset & 0xFF;
+        *out++ = (match_offset >> 8) & 0xFF;
+
+        out = _length_write(out, match_length - MIN_MATCH);
+    }
+
+    return out;
+}
+
+static uint32_t
+_lz4_compress(const uint8_t *in, uint8_t *out, uint32_t in_size)
+{
+    if (in_size < 1) {
+        return 0;
+    }
+
+    node_t * const nodes = malloc((in_size + 1) * sizeof(node_t));
+
+    match_finder_t finder = {
+        .in      = in,
+        .in_size = in_size,
+        .head     = malloc(HASH_SIZE * sizeof(int32_t)),
+        .chain    = malloc(in_size * sizeof(int32_t)),
+        .inserted = 0
+    };
+
+    if ((nodes == NULL) || (finder.head == NULL) || (finder.chain == NULL)) {
+        return 0;
+    }
+
+    for (uint32_t i = 0; i < HASH_SIZE; i++) {
+        finder.head[i] = -1;
+    }
+
+    for (uint32_t i = 0; i <= in_size; i++) {
+        nodes[i].price = PRICE_MAX;
+    }
+
+    nodes[0].price = 0;
+    nodes[0].literal_count = 0;
+    nodes[0].match_length = 0;
+
+    for (uint32_t i = 0; i < in_size; i++) {
+        const node_t * const node = &nodes[i];
+
+        /* Extend the run of literals by one */
+        const uint32_t literal_count = node->literal_count + 1;
+        const uint32_t literal_price = node->price +
+            _literals_price(literal_count) - _literals_price(literal_count - 1);
+
+        if (literal_price < nodes[i + 1].price) {
+            nodes[i + 1].price = literal_price;
+            nodes[i + 1].literal_count = literal_count;
+            nodes[i + 1].match_length = 0;
+        }
+
+        _match_finder_insert(&finder, i);
+
+        if ((i + MATCH_FIND_LIMIT) > in_size) {
+            continue;
+        }
+
+        uint32_t offset;
+        const uint32_t length =
+            _match_find(&finder, i, in_size - LAST_LITERALS - i, &offset);
+
+        if (length == 0) {
+            continue;
+        }
+
+        /* Every match length up to the longest is possible at this offset */
+        const uint32_t priced_length =
+            (length < PRICED_LENGTHS) ? length : PRICED_LENGTHS;
+
+        for (uint32_t l = MIN_MATCH; l <= length; l++) {
+            if ((l > priced_length) && (l < length)) {
+                l = length;
+            }
+
+            const uint32_t price = node->price + _match_price(l);
+
+            if (price < nodes[i + l].price) {
+                nodes[i + l].price = price;
+                nodes[i + l].literal_count = 0;
+                nodes[i + l].match_length = l;
+                nodes[i + l].match_offset = offset;
+            }
+        }
+
+        /* Long matches are taken as is, rather than searching every position
+         * they cover */
+        if (length >= SUFFICIENT_LENGTH) {
+            _match_finder_insert(&finder, i + length - 1);
+
+            i += length - 1;
+        }
+    }
+
+    /* Walk back from the end, linking each match to the one before it */
+    uint32_t position;
+    position = in_size;
+
+    uint32_t next;
+    next = 0;
+
+    while (position > 0) {
+        node_t * const node = &nodes[position];
+
+        if (node->match_length == 0) {
+            position--;
+
+            continue;
+        }
+
+        const uint32_t start = position - node->match_length;
+
+        /* Reuse the literal count to point to the next match */
+        node->literal_count = next;
+        next = position;
+
+        position = start;
+    }
+
+    uint8_t *out_ptr;
+    out_ptr = out;
+
+    uint32_t literal_start;
+    literal_start = 0;
+
+    for (uint32_t end = next; end != 0; ) {
+        const node_t * const node = &nodes[end];
+
+        const uint32_t start = end - node->match_length;
+
+        out_ptr = _sequence_write(out_ptr, &in[literal_start],
+            start - literal_start, node->match_length, node->match_offset);
+
+        literal_start = end;
+        end = node->literal_count;
+    }
+
+    out_ptr = _sequence_write(out_ptr, &in[literal_start],
+        in_size - literal_start, 0, 0);
+
+    free(finder.chain);
+    free(finder.head);
+    free(nodes);
+
+    return (out_ptr - out);
+}
@@ -3,7 +3,6 @@
  * long as he's credited for the compression and decompression code. */
 
 #include <inttypes.h>
-#include <math.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -48,9 +47,9 @@ main(int argc, char *argv[])
      * big the out file size will be */
     void *out_buffer;
 
-    /* According to the original sources, the output buffer must be 0.4%
-     * larger plus 1 byte */
-    size_t out_size = (size_t)floor(1.004f * (float)input_file.buffer_len) + 1;
+    /* Each literal costs a control bit on top of the byte itself, plus the
+     * first control byte and the end marker */
+    size_t out_size = input_file.buffer_len + (input_file.buffer_len / 8) + 4;
 
     if ((out_buffer = malloc(out_size)) == NULL) {
         print_errno(PROGNAME);
@@ -145,7 +144,9 @@ static void
 _prs_finish(prs_compressor_t *pc)
 {
     _prs_put_control_bit(pc, 0);
-    _prs_put_control_bit(pc, 1);
+    /* The decoder reads the next control byte only once it needs another
+     * bit, so none may be placed between the last bit and the end marker */
+    _prs_put_control_bit_nosave(pc, 1);
 
     if (pc->bit_pos != 0) {
         *pc->control_byte_ptr = ((*pc->control_byte_ptr << pc->bit_pos) >> 8);
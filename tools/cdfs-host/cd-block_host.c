@@ -0,0 +1,365 @@
+/*
+ * Copyright (c) Israel Jacquez
+ * See LICENSE for details.
+ *
+ * Israel Jacquez <mrkotfw@gmail.com>
+ */
+
+#include <assert.h>
+#include <ctype.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+#include <cd-block.h>
+
+#define RAW_SECTOR_SIZE      (2352)
+/* Sync pattern and header */
+#define MODE1_DATA_OFFSET    (16)
+/* Sync pattern, header and subheader */
+#define MODE2_DATA_OFFSET    (24)
+
+/* Sectors per second at 1x */
+#define SECTORS_PER_SECOND   (75)
+
+#define LINE_SIZE            (1024)
+
+static struct {
+    FILE *fp;
+    uint32_t sector_size;
+    uint32_t data_offset;
+
+    bool latency_enabled;
+    cd_block_host_latency_t latency;
+    /* Where the previous read ended */
+    fad_t next_fad;
+
+    /* Next sector to be transferred, and how many are left, since the last
+     * cd_block_cmd_disk_play() */
+    fad_t play_fad;
+    uint32_t play_sector_count;
+
+    cd_block_host_stats_t stats;
+} _state;
+
+static int _cue_parse(const char *cue_path, char *bin_path, size_t bin_path_size);
+static bool _extension_match(const char *path, const char *extension);
+static void _latency_account(fad_t fad, uint32_t sector_count);
+static int _sector_copy(fad_t fad, uint8_t *buffer, uint32_t length);
+
+int
+cd_block_host_open(const char *path)
+{
+    assert(path != NULL);
+
+    cd_block_host_close();
+
+    char bin_path[LINE_SIZE];
+
+    _state.sector_size = CDFS_SECTOR_SIZE;
+    _state.data_offset = 0;
+
+    if ((_extension_match(path, ".cue"))) {
+        if ((_cue_parse(path, bin_path, sizeof(bin_path))) != 0) {
+            return -1;
+        }
+
+        path = bin_path;
+    } else if ((_extension_match(path, ".bin"))) {
+        _state.sector_size = RAW_SECTOR_SIZE;
+        _state.data_offset = MODE1_DATA_OFFSET;
+    }
+
+    if ((_state.fp = fopen(path, "rb")) == NULL) {
+        return -1;
+    }
+
+    _state.next_fad = LBA2FAD(0);
+
+    _state.play_fad = LBA2FAD(0);
+    _state.play_sector_count = 0;
+
+    cd_block_host_stats_clear();
+
+    return 0;
+}
+
+void
+cd_block_host_close(void)
+{
+    if (_state.fp != NULL) {
+        (void)fclose(_state.fp);
+    }
+
+    _state.fp = NULL;
+}
+
+void
+cd_block_host_latency_set(const cd_block_host_latency_t *latency)
+{
+    _state.latency_enabled = (latency != NULL);
+
+    if (latency != NULL) {
+        assert(latency->speed > 0);
+
+        _state.latency = *latency;
+    }
+}
+
+const cd_block_host_stats_t *
+cd_block_host_stats_get(void)
+{
+    return &_state.stats;
+}
+
+void
+cd_block_host_stats_clear(void)
+{
+    (void)memset(&_state.stats, 0, sizeof(_state.stats));
+}
+
+int
+cd_block_sector_read(fad_t fad, void *output_buffer)
+{
+    return cd_block_sectors_read(fad, output_buffer, CDFS_SECTOR_SIZE);
+}
+
+int
+cd_block_sectors_read(fad_t fad, void *output_buffer, uint32_t length)
+{
+    assert(_state.fp != NULL);
+    assert(fad >= 150);
+    assert(output_buffer != NULL);
+    assert(length > 0);
+
+    const uint32_t sector_count =
+        (length + (CDFS_SECTOR_SIZE - 1)) / CDFS_SECTOR_SIZE;
+
+    _latency_account(fad, sector_count);
+
+    uint8_t *buffer_ptr;
+    buffer_ptr = output_buffer;
+
+    uint32_t bytes_missing;
+    bytes_missing = length;
+
+    for (uint32_t i = 0; i < sector_count; i++) {
+        const uint32_t bytes_to_read = (bytes_missing > CDFS_SECTOR_SIZE)
+            ? CDFS_SECTOR_SIZE
+            : bytes_missing;
+
+        if ((_sector_copy(fad + i, buffer_ptr, bytes_to_read)) != 0) {
+            return -1;
+        }
+
+        buffer_ptr += bytes_to_read;
+        bytes_missing -= bytes_to_read;
+    }
+
+    return 0;
+}
+
+int
+cd_block_cmd_disk_play(int32_t mode __unused, fad_t start_fad,
+    int32_t num_sectors)
+{
+    assert(_state.fp != NULL);
+    assert(start_fad >= 150);
+    assert(num_sectors > 0);
+
+    _latency_account(start_fad, num_sectors);
+
+    _state.play_fad = start_fad;
+    _state.play_sector_count = num_sectors;
+
+    return 0;
+}
+
+int
+cd_block_cmd_cd_dev_connection_set(uint8_t filter __unused)
+{
+    return 0;
+}
+
+int
+cd_block_cmd_selector_reset(uint8_t flags __unused, uint8_t sel_num __unused)
+{
+    return 0;
+}
+
+int
+cd_block_cmd_sector_number_get(uint8_t buff_num __unused)
+{
+    return _state.play_sector_count;
+}
+
+int
+cd_block_transfer_data(uint16_t offset __unused, uint16_t buffer_number __unused,
+    uint8_t *output_buffer, uint32_t buffer_length)
+{
+    assert(_state.fp != NULL);
+    assert(output_buffer != NULL);
+    assert(buffer_length <= CDFS_SECTOR_SIZE);
+
+    if (_state.play_sector_count == 0) {
+        return -1;
+    }
+
+    const int ret = _sector_copy(_state.play_fad, output_buffer, buffer_length);
+
+    _state.play_fad++;
+    _state.play_sector_count--;
+
+    return ret;
+}
+
+static int
+_cue_parse(const char *cue_path, char *bin_path, size_t bin_path_size)
+{
+    FILE *fp;
+
+    if ((fp = fopen(cue_path, "r")) == NULL) {
+        return -1;
+    }
+
+    char line[LINE_SIZE];
+    char file_name[LINE_SIZE];
+
+    file_name[0] = '\0';
+
+    bool track_found;
+    track_found = false;
+
+    while (((fgets(line, sizeof(line), fp)) != NULL) && !track_found) {
+        char *s;
+
+        for (s = line; isspace((unsigned char)*s); s++) {
+        }
+
+        if ((strncasecmp(s, "FILE", 4)) == 0) {
+            char * const start = strchr(s, '"');
+            char * const end = (start != NULL) ? strchr(start + 1, '"') : NULL;
+
+            if (end == NULL) {
+                continue;
+            }
+
+            *end = '\0';
+
+            (void)snprintf(file_name, sizeof(file_name), "%s", start + 1);
+        } else if ((strncasecmp(s, "TRACK", 5)) == 0) {
+            /* Only the first track, which holds the file system, is used */
+            track_found = true;
+
+            if ((strstr(s, "MODE1/2048")) != NULL) {
+                _state.sector_size = CDFS_SECTOR_SIZE;
+                _state.data_offset = 0;
+            } else if ((strstr(s, "MODE1/2352")) != NULL) {
+                _state.sector_size = RAW_SECTOR_SIZE;
+                _state.data_offset = MODE1_DATA_OFFSET;
+            } else if ((strstr(s, "MODE2/2352")) != NULL) {
+                _state.sector_size = RAW_SECTOR_SIZE;
+                _state.data_offset = MODE2_DATA_OFFSET;
+            } else {
+                track_found = false;
+            }
+        }
+    }
+
+    (void)fclose(fp);
+
+    if (!track_found || (file_name[0] == '\0')) {
+        errno = EINVAL;
+
+        return -1;
+    }
+
+    /* The BIN file is relative to the CUE sheet */
+    const char * const slash = strrchr(cue_path, '/');
+
+    if ((slash == NULL) || (file_name[0] == '/')) {
+        (void)snprintf(bin_path, bin_path_size, "%s", file_name);
+    } else {
+        (void)snprintf(bin_path, bin_path_size, "%.*s/%s",
+            (int)(slash - cue_path), cue_path, file_name);
+    }
+
+    return 0;
+}
+
+static bool
+_extension_match(const char *path, const char *extension)
+{
+    const size_t path_len = strlen(path);
+    const size_t extension_len = strlen(extension);
+
+    if (path_len < extension_len) {
+        return false;
+    }
+
+    return ((strcasecmp(&path[path_len - extension_len], extension)) == 0);
+}
+
+static void
+_latency_account(fad_t fad, uint32_t sector_count)
+{
+    _state.stats.reads++;
+    _state.stats.sectors_read += sector_count;
+
+    uint64_t usecs;
+    usecs = 0;
+
+    if (fad != _state.next_fad) {
+        _state.stats.seeks++;
+
+        if (_state.latency_enabled) {
+            const uint32_t distance = (fad > _state.next_fad)
+                ? (fad - _state.next_fad)
+                : (_state.next_fad - fad);
+
+            usecs += _state.latency.seek_usecs;
+            usecs += ((uint64_t)distance * _state.latency.seek_usecs_per_ksector) / 1000;
+        }
+    }
+
+    _state.next_fad = fad + sector_count;
+
+    if (!_state.latency_enabled) {
+        return;
+    }
+
+    usecs += ((uint64_t)sector_count * 1000000) /
+        (SECTORS_PER_SECOND * _state.latency.speed);
+
+    _state.stats.simulated_usecs += usecs;
+
+    if (_state.latency.realtime) {
+        const struct timespec ts = {
+            .tv_sec  = usecs / 1000000,
+            .tv_nsec = (usecs % 1000000) * 1000
+        };
+
+        (void)nanosleep(&ts, NULL);
+    }
+}
+
+static int
+_sector_copy(fad_t fad, uint8_t *buffer, uint32_t length)
+{
+    const long offset = ((long)FAD2LBA(fad) * _state.sector_size) +
+        _state.data_offset;
+
+    if ((fseek(_state.fp, offset, SEEK_SET)) != 0) {
+        return -1;
+    }
+
+    if ((fread(buffer, 1, length, _state.fp)) != length) {
+        /* Reading past the end of the image */
+        (void)memset(buffer, 0x00, length);
+    }
+
+    return 0;
+}
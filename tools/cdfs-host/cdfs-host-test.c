@@ -0,0 +1,994 @@
+/*
+ * Copyright (c) Israel Jacquez
+ * See LICENSE for details.
+ *
+ * Israel Jacquez <mrkotfw@gmail.com>
+ */
+
+/* Checks cdfs, the sector cache, the pack reader, and the CD-block request
+ * queue against a disc image.
+ *
+ * "generate" writes the files of the image, along with the make-pack list and
+ * the make-iso-native order file. Once the pack and the image are built, "run"
+ * reads them back through libcdfs-host. Every file is filled with a pattern
+ * that only depends on its seed, so reads are checked without the original
+ * files */
+
+#define PROGNAME "cdfs-host-test"
+
+#include <sys/stat.h>
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <cd-block.h>
+
+#include <fs/cd/cdfs.h>
+#include <fs/pack/pack.h>
+
+#define PATH_SIZE (1024)
+
+#define CHECK(x) _check((x), #x, __FILE__, __LINE__)
+
+typedef struct {
+    const char *path;
+    uint32_t size;
+    uint8_t seed;
+} test_file_t;
+
+/* In the order given to make-iso-native. The pack comes first, and A.BIN is
+ * right before LEVEL1.BIN */
+#define FILE_PACK   (0)
+#define FILE_A      (1)
+#define FILE_LEVEL1 (2)
+#define FILE_DEEP   (3)
+
+static const test_file_t _files[] = {
+    { "DATA/GAME.PAK",     0,                            0 },
+    { "A.BIN",             5000,                         1 },
+    { "DATA/LEVEL1.BIN",   (3 * CDFS_SECTOR_SIZE) + 100, 2 },
+    { "DATA/SUB/DEEP.TXT", 10,                           3 }
+};
+
+#define FILE_COUNT (sizeof(_files) / sizeof(*_files))
+
+/* In the order given to make-pack */
+static const test_file_t _pack_files[] = {
+    { "TEX/A.BIN", 3000,             4 },
+    { "TEX/B.BIN", CDFS_SECTOR_SIZE, 5 },
+    { "SND/C.BIN", 100,              6 }
+};
+
+#define PACK_FILE_COUNT (sizeof(_pack_files) / sizeof(*_pack_files))
+
+/* Files that have to be on the disc, but aren't checked */
+static const char * const _extra_files[] = {
+    "ABS.TXT",
+    "BIB.TXT",
+    "CPY.TXT"
+};
+
+#define EXTRA_FILE_COUNT (sizeof(_extra_files) / sizeof(*_extra_files))
+
+/* Written to the root directory by make-iso-native */
+#define INDEX_FILE "INDEX.CDX"
+
+/* A sector per malformed pack header, see _bad_pack_write() */
+#define BAD_PACK_FILE "BAD.PAK"
+
+#define BAD_PACK_COUNT_OVERFLOW     (0)
+#define BAD_PACK_TOC_OVERFLOW       (1)
+#define BAD_PACK_TOC_EMPTY          (2)
+#define BAD_PACK_SECTOR_COUNT       (3)
+
+/* Sector cache of 2 lines of 4 sectors */
+#define CACHE_SECTOR_COUNT      (8)
+#define CACHE_LINE_SECTOR_COUNT (4)
+
+#define INDEX_ENTRY_COUNT       (16)
+#define FILELIST_ENTRY_COUNT    (16)
+
+static uint32_t _failed_count;
+static uint32_t _check_count;
+
+static sector_buffer_t _cache_sectors[CACHE_SECTOR_COUNT];
+static uint8_t _buffer[8 * CDFS_SECTOR_SIZE] __aligned(4);
+static uint8_t _toc_buffer[CDFS_SECTOR_SIZE] __aligned(4);
+static uint8_t _index_buffer[CDFS_SECTOR_SIZE] __aligned(4);
+
+static cdfs_index_entry_t _index_entries[INDEX_ENTRY_COUNT];
+static cdfs_index_t _index;
+
+static void _usage_print(void);
+static void _error_print(const char *fmt, ...);
+static void _check(int result, const char *expression, const char *file,
+    int line);
+
+static int _generate(const char *dir);
+static int _run(const char *image_path);
+
+static void _cdfs_walk_test(void);
+static void _cdfs_open_test(cdfs_filelist_entry_t *entries);
+static void _cdfs_index_load_test(const cdfs_filelist_entry_t *entries);
+static void _sector_cache_test(const cdfs_filelist_entry_t *entries);
+static void _pack_test(const cdfs_filelist_entry_t *entries);
+static void _queue_merge_test(const cdfs_filelist_entry_t *entries);
+static void _queue_deadline_test(const cdfs_filelist_entry_t *entries);
+
+static int _bad_pack_write(const char *path);
+
+static size_t _index_data_write(uint8_t *data, uint32_t magic, uint32_t count,
+    const uint32_t *hashes, uint32_t hash_count);
+static void _be32_write(uint8_t *buffer, uint32_t value);
+static uint32_t _be32_read(const uint8_t *buffer);
+
+static int _sectors_read_fail(sector_t sector, sector_buffer_t *sector_buffers,
+    uint32_t count);
+
+static uint8_t _pattern_byte(uint8_t seed, uint32_t offset);
+static int _pattern_match(uint8_t seed, uint32_t offset, const uint8_t *buffer,
+    uint32_t length);
+static int _pattern_file_write(const char *path, uint8_t seed, uint32_t size);
+static int _directories_make(const char *path);
+
+int
+main(int argc, char *argv[])
+{
+    if (argc != 3) {
+        _usage_print();
+
+        return 2;
+    }
+
+    if ((strcmp(argv[1], "generate")) == 0) {
+        return _generate(argv[2]);
+    }
+
+    if ((strcmp(argv[1], "run")) == 0) {
+        return _run(argv[2]);
+    }
+
+    _usage_print();
+
+    return 2;
+}
+
+static void
+_usage_print(void)
+{
+    (void)fprintf(stderr,
+        "Usage: %s generate directory\n"
+        "       %s run image\n"
+        "\n"
+        "generate writes the files of the image, the list for make-pack to\n"
+        "write directory/cd/DATA/GAME.PAK, and the order file for\n"
+        "make-iso-native, all under directory.\n",
+        PROGNAME,
+        PROGNAME);
+}
+
+static void
+_error_print(const char *fmt, ...)
+{
+    va_list ap;
+
+    va_start(ap, fmt);
+
+    (void)fprintf(stderr, "Error: %s: ", PROGNAME);
+    (void)vfprintf(stderr, fmt, ap);
+
+    va_end(ap);
+}
+
+static void
+_check(int result, const char *expression, const char *file, int line)
+{
+    _check_count++;
+
+    if (!result) {
+        _failed_count++;
+
+        (void)fprintf(stderr, "%s:%i: Check failed: %s\n", file, line,
+            expression);
+    }
+}
+
+static int
+_generate(const char *dir)
+{
+    char path[PATH_SIZE];
+
+    /* Skip the pack, which is written by make-pack */
+    for (uint32_t i = 0; i < FILE_COUNT; i++) {
+        if (i == FILE_PACK) {
+            continue;
+        }
+
+        (void)snprintf(path, sizeof(path), "%s/cd/%s", dir, _files[i].path);
+
+        if ((_pattern_file_write(path, _files[i].seed, _files[i].size)) != 0) {
+            return 1;
+        }
+    }
+
+    for (uint32_t i = 0; i < EXTRA_FILE_COUNT; i++) {
+        (void)snprintf(path, sizeof(path), "%s/cd/%s", dir, _extra_files[i]);
+
+        if ((_pattern_file_write(path, 0, 1)) != 0) {
+            return 1;
+        }
+    }
+
+    (void)snprintf(path, sizeof(path), "%s/cd/%s", dir, BAD_PACK_FILE);
+
+    if ((_bad_pack_write(path)) != 0) {
+        return 1;
+    }
+
+    (void)snprintf(path, sizeof(path), "%s/IP.BIN", dir);
+
+    if ((_pattern_file_write(path, 0, 0)) != 0) {
+        return 1;
+    }
+
+    /* Make sure GAME.PAK has a directory to go into */
+    (void)snprintf(path, sizeof(path), "%s/cd/%s", dir, _files[FILE_PACK].path);
+
+    if ((_directories_make(path)) != 0) {
+        return 1;
+    }
+
+    FILE *list_fp;
+    FILE *order_fp;
+
+    (void)snprintf(path, sizeof(path), "%s/pack.list", dir);
+
+    if ((list_fp = fopen(path, "w")) == NULL) {
+        _error_print("%s: %s\n", path, strerror(errno));
+
+        return 1;
+    }
+
+    for (uint32_t i = 0; i < PACK_FILE_COUNT; i++) {
+        (void)snprintf(path, sizeof(path), "%s/pack/%s", dir,
+            _pack_files[i].path);
+
+        if ((_pattern_file_write(path, _pack_files[i].seed, _pack_files[i].size)) != 0) {
+            (void)fclose(list_fp);
+
+            return 1;
+        }
+
+        (void)fprintf(list_fp, "%s %s none\n", _pack_files[i].path, path);
+    }
+
+    (void)fclose(list_fp);
+
+    (void)snprintf(path, sizeof(path), "%s/order.txt", dir);
+
+    if ((order_fp = fopen(path, "w")) == NULL) {
+        _error_print("%s: %s\n", path, strerror(errno));
+
+        return 1;
+    }
+
+    for (uint32_t i = 0; i < FILE_COUNT; i++) {
+        (void)fprintf(order_fp, "%s\n", _files[i].path);
+    }
+
+    (void)fclose(order_fp);
+
+    return 0;
+}
+
+static int
+_run(const char *image_path)
+{
+    if ((cd_block_host_open(image_path)) != 0) {
+        _error_print("%s: %s\n", image_path, strerror(errno));
+
+        return 1;
+    }
+
+    cdfs_filelist_entry_t entries[FILE_COUNT];
+
+    cdfs_init();
+
+    _cdfs_walk_test();
+    _cdfs_open_test(entries);
+    _cdfs_index_load_test(entries);
+    _sector_cache_test(entries);
+    _pack_test(entries);
+    _queue_merge_test(entries);
+    _queue_deadline_test(entries);
+
+    cd_block_host_close();
+
+    (void)printf("%s: %" PRIu32 " checks, %" PRIu32 " failed\n", PROGNAME,
+        _check_count, _failed_count);
+
+    return (_failed_count == 0) ? 0 : 1;
+}
+
+static void
+_cdfs_walk_test(void)
+{
+    cdfs_filelist_entry_t filelist_entries[FILELIST_ENTRY_COUNT];
+    cdfs_filelist_t filelist;
+
+    cdfs_filelist_init(&filelist, filelist_entries, FILELIST_ENTRY_COUNT);
+    cdfs_filelist_root_read(&filelist);
+
+    /* A.BIN, BAD.PAK, DATA, the index, and the extra files */
+    CHECK(filelist.entries_count == (4 + EXTRA_FILE_COUNT));
+
+    const cdfs_filelist_entry_t *a_entry;
+    a_entry = NULL;
+
+    const cdfs_filelist_entry_t *data_entry;
+    data_entry = NULL;
+
+    for (uint32_t i = 0; i < filelist.entries_count; i++) {
+        const cdfs_filelist_entry_t * const entry = &filelist.entries[i];
+
+        if ((strcmp(entry->name, "A.BIN")) == 0) {
+            a_entry = entry;
+        } else if ((strcmp(entry->name, "DATA")) == 0) {
+            data_entry = entry;
+        }
+    }
+
+    CHECK(a_entry != NULL);
+    CHECK(data_entry != NULL);
+
+    if (a_entry != NULL) {
+        CHECK(a_entry->type == CDFS_ENTRY_TYPE_FILE);
+        CHECK(a_entry->size == _files[FILE_A].size);
+    }
+
+    if (data_entry == NULL) {
+        return;
+    }
+
+    CHECK(data_entry->type == CDFS_ENTRY_TYPE_DIRECTORY);
+
+    /* GAME.PAK, LEVEL1.BIN, and SUB */
+    cdfs_filelist_init(&filelist, filelist_entries, FILELIST_ENTRY_COUNT);
+    cdfs_filelist_read(&filelist, *data_entry);
+
+    CHECK(filelist.entries_count == 3);
+}
+
+static void
+_cdfs_open_test(cdfs_filelist_entry_t *entries)
+{
+    CHECK((cdfs_index_build(&_index, _index_entries, INDEX_ENTRY_COUNT)) == 0);
+
+    /* Files, the extra files, BAD.PAK, the index, and the DATA and DATA/SUB
+     * directories */
+    CHECK(_index.count == (FILE_COUNT + EXTRA_FILE_COUNT + 4));
+
+    for (uint32_t i = 0; i < FILE_COUNT; i++) {
+        cdfs_filelist_entry_t * const entry = &entries[i];
+
+        (void)memset(entry, 0, sizeof(*entry));
+
+        CHECK((cdfs_open(_files[i].path, entry)) == 0);
+        CHECK(entry->type == CDFS_ENTRY_TYPE_FILE);
+
+        if (i == FILE_PACK) {
+            continue;
+        }
+
+        CHECK(entry->size == _files[i].size);
+        CHECK(entry->sector_count == cdfs_sector_count_round(_files[i].size));
+
+        CHECK((cd_block_sectors_read(entry->starting_fad, _buffer, entry->size)) == 0);
+        CHECK((_pattern_match(_files[i].seed, 0, _buffer, entry->size)) == 0);
+    }
+
+    CHECK((strcmp(entries[FILE_DEEP].name, "DEEP.TXT")) == 0);
+
+    /* The files are placed in the order given */
+    for (uint32_t i = 1; i < FILE_COUNT; i++) {
+        CHECK(entries[i - 1].starting_fad < entries[i].starting_fad);
+    }
+
+    CHECK(entries[FILE_A].starting_fad + entries[FILE_A].sector_count ==
+          entries[FILE_LEVEL1].starting_fad);
+
+    cdfs_filelist_entry_t entry;
+
+    CHECK((cdfs_open("DATA/SUB", &entry)) == 0);
+    CHECK(entry.type == CDFS_ENTRY_TYPE_DIRECTORY);
+
+    /* Paths are case insensitive */
+    CHECK((cdfs_open("data/level1.bin", &entry)) == 0);
+    CHECK(entry.starting_fad == entries[FILE_LEVEL1].starting_fad);
+
+    CHECK((cdfs_open("DATA/MISSING.BIN", &entry)) == -1);
+    CHECK((cdfs_open("LEVEL1.BIN", &entry)) == -1);
+}
+
+static void
+_cdfs_index_load_test(const cdfs_filelist_entry_t *entries)
+{
+    cdfs_index_t index;
+    size_t size;
+
+    /* Malformed indices are turned down */
+    size = _index_data_write(_index_buffer, CDFS_INDEX_MAGIC, 0, NULL, 0);
+    CHECK((cdfs_index_load(&index, _index_buffer, size - 1)) == -1);
+
+    size = _index_data_write(_index_buffer, 0x12345678, 0, NULL, 0);
+    CHECK((cdfs_index_load(&index, _index_buffer, size)) == -1);
+
+    /* A count that would overflow 32 bits once multiplied out */
+    const uint32_t one_hash[] = { 1 };
+
+    size = _index_data_write(_index_buffer, CDFS_INDEX_MAGIC, 0x10000001,
+        one_hash, 1);
+    CHECK((cdfs_index_load(&index, _index_buffer, size)) == -1);
+
+    const uint32_t sorted_hashes[] = { 1, 2, 3 };
+
+    size = _index_data_write(_index_buffer, CDFS_INDEX_MAGIC, 3, sorted_hashes, 3);
+    CHECK((cdfs_index_load(&index, _index_buffer, size - 1)) == -1);
+
+    const uint32_t unsorted_hashes[] = { 1, 3, 2 };
+
+    size = _index_data_write(_index_buffer, CDFS_INDEX_MAGIC, 3, unsorted_hashes, 3);
+    CHECK((cdfs_index_load(&index, _index_buffer, size)) == -1);
+
+    const uint32_t duplicate_hashes[] = { 1, 2, 2 };
+
+    size = _index_data_write(_index_buffer, CDFS_INDEX_MAGIC, 3, duplicate_hashes, 3);
+    CHECK((cdfs_index_load(&index, _index_buffer, size)) == -2);
+
+    size = _index_data_write(_index_buffer, CDFS_INDEX_MAGIC, 3, sorted_hashes, 3);
+    CHECK((cdfs_index_load(&index, _index_buffer, size)) == 0);
+    CHECK(index.count == 3);
+
+    /* The index written by make-iso-native matches the one built by walking
+     * the disc */
+    cdfs_filelist_entry_t entry;
+
+    CHECK((cdfs_open(INDEX_FILE, &entry)) == -1);
+
+    CHECK((cdfs_index_build(&_index, _index_entries, INDEX_ENTRY_COUNT)) == 0);
+    CHECK((cdfs_open(INDEX_FILE, &entry)) == 0);
+    CHECK(entry.size == (sizeof(cdfs_index_header_t) +
+                         (_index.count * sizeof(cdfs_index_entry_t))));
+    CHECK(entry.size <= sizeof(_index_buffer));
+
+    if (entry.size > sizeof(_index_buffer)) {
+        return;
+    }
+
+    CHECK((cd_block_sectors_read(entry.starting_fad, _index_buffer, entry.size)) == 0);
+    CHECK((cdfs_index_load(&index, _index_buffer, entry.size)) == 0);
+    CHECK(index.count == _index.count);
+    CHECK((memcmp(index.entries, _index.entries,
+                  _index.count * sizeof(cdfs_index_entry_t))) == 0);
+
+    /* Paths now resolve through the loaded index */
+    CHECK((cdfs_open(_files[FILE_DEEP].path, &entry)) == 0);
+    CHECK(entry.starting_fad == entries[FILE_DEEP].starting_fad);
+}
+
+static void
+_sector_cache_test(const cdfs_filelist_entry_t *entries)
+{
+    const cdfs_filelist_entry_t * const a_entry = &entries[FILE_A];
+    const cdfs_filelist_entry_t * const level1_entry = &entries[FILE_LEVEL1];
+    const cdfs_filelist_entry_t * const deep_entry = &entries[FILE_DEEP];
+
+    cdfs_sector_cache_init(_cache_sectors, CACHE_SECTOR_COUNT,
+        CACHE_LINE_SECTOR_COUNT);
+
+    const cdfs_sector_cache_stats_t * const stats = cdfs_sector_cache_stats_get();
+    const cd_block_host_stats_t * const host_stats = cd_block_host_stats_get();
+
+    cd_block_host_stats_clear();
+
+    /* The first sector misses, and reads ahead the other three. The PVD is
+     * read first, for the size of the volume */
+    CHECK((cdfs_sector_cache_file_read(level1_entry, 0, _buffer, level1_entry->size)) == 0);
+
+    CHECK(stats->misses == 1);
+    CHECK(stats->hits == 3);
+    CHECK(host_stats->reads == 2);
+    CHECK((_pattern_match(_files[FILE_LEVEL1].seed, 0, _buffer, level1_entry->size)) == 0);
+
+    /* Reading at an offset within a sector */
+    cdfs_sector_cache_file_read(level1_entry, CDFS_SECTOR_SIZE + 7, _buffer, 100);
+
+    CHECK(stats->misses == 1);
+    CHECK(stats->hits == 4);
+    CHECK((_pattern_match(_files[FILE_LEVEL1].seed, CDFS_SECTOR_SIZE + 7, _buffer, 100)) == 0);
+
+    /* Read-ahead stops short of LEVEL1.BIN, which is already cached */
+    cdfs_sector_cache_file_read(a_entry, 0, _buffer, a_entry->size);
+
+    CHECK(stats->misses == 2);
+    CHECK(stats->hits == 6);
+    CHECK(stats->sectors_read == (1 + CACHE_LINE_SECTOR_COUNT + a_entry->sector_count));
+    CHECK((_pattern_match(_files[FILE_A].seed, 0, _buffer, a_entry->size)) == 0);
+
+    /* Both lines are in use, so reading DEEP.TXT evicts the least recently
+     * used line, which holds A.BIN */
+    cdfs_sector_cache_file_read(level1_entry, 0, _buffer, level1_entry->size);
+    cdfs_sector_cache_file_read(deep_entry, 0, _buffer, deep_entry->size);
+
+    CHECK(stats->misses == 3);
+    CHECK(stats->hits == 10);
+    CHECK((_pattern_match(_files[FILE_DEEP].seed, 0, _buffer, deep_entry->size)) == 0);
+
+    cdfs_sector_cache_file_read(level1_entry, 0, _buffer, level1_entry->size);
+
+    CHECK(stats->misses == 3);
+    CHECK(stats->hits == 14);
+
+    cdfs_sector_cache_file_read(a_entry, 0, _buffer, a_entry->size);
+
+    CHECK(stats->misses == 4);
+    CHECK(stats->hits == 16);
+    CHECK((_pattern_match(_files[FILE_A].seed, 0, _buffer, a_entry->size)) == 0);
+
+    /* Every miss is a single read, besides the PVD */
+    CHECK(host_stats->reads == (1 + stats->misses));
+    CHECK(host_stats->sectors_read == stats->sectors_read);
+
+    cdfs_sector_cache_invalidate();
+    cdfs_sector_cache_stats_clear();
+
+    cdfs_sector_cache_file_read(deep_entry, 0, _buffer, deep_entry->size);
+
+    CHECK(stats->misses == 1);
+    CHECK(stats->hits == 0);
+
+    /* Read-ahead stops at the end of the volume */
+    CHECK((cd_block_sector_read(LBA2FAD(16), _buffer)) == 0);
+
+    const uint32_t volume_sector_count = _be32_read(&_buffer[84]);
+
+    cdfs_sector_cache_invalidate();
+    cdfs_sector_cache_stats_clear();
+    cd_block_host_stats_clear();
+
+    CHECK(cdfs_sector_cache_get(volume_sector_count - 2) != NULL);
+    CHECK(stats->sectors_read == (1 + 2));
+    CHECK(host_stats->sectors_read == (1 + 2));
+
+    CHECK(cdfs_sector_cache_get(volume_sector_count) == NULL);
+    CHECK(host_stats->reads == 2);
+
+    /* A failed read leaves the line empty, so the sector misses again */
+    cdfs_sector_cache_stats_clear();
+    cdfs_sector_cache_sectors_read_set(_sectors_read_fail);
+
+    CHECK((cdfs_sector_cache_file_read(a_entry, 0, _buffer, a_entry->size)) == -3);
+    CHECK(stats->sectors_read == 0);
+
+    cdfs_sector_cache_sectors_read_set(NULL);
+
+    CHECK((cdfs_sector_cache_file_read(a_entry, 0, _buffer, a_entry->size)) == 0);
+    CHECK(stats->misses == 2);
+    CHECK((_pattern_match(_files[FILE_A].seed, 0, _buffer, a_entry->size)) == 0);
+}
+
+static int
+_sectors_read_fail(sector_t sector __unused,
+    sector_buffer_t *sector_buffers __unused, uint32_t count __unused)
+{
+    return -3;
+}
+
+static void
+_pack_test(const cdfs_filelist_entry_t *entries)
+{
+    pack_t pack;
+
+    CHECK((pack_open(&pack, entries[FILE_PACK].starting_fad, _toc_buffer,
+                sizeof(_toc_buffer))) == 0);
+    CHECK(pack.count == PACK_FILE_COUNT);
+    CHECK(pack.sector_count == entries[FILE_PACK].sector_count);
+
+    const pack_entry_t *pack_entries[PACK_FILE_COUNT];
+
+    for (uint32_t i = 0; i < PACK_FILE_COUNT; i++) {
+        const pack_entry_t * const pack_entry =
+            pack_entry_path_find(&pack, _pack_files[i].path);
+
+        pack_entries[i] = pack_entry;
+
+        CHECK(pack_entry != NULL);
+
+        if (pack_entry == NULL) {
+            return;
+        }
+
+        CHECK(pack_entry->codec == PACK_CODEC_NONE);
+        CHECK(pack_entry->size == _pack_files[i].size);
+        CHECK(pack_entry->unpacked_size == _pack_files[i].size);
+
+        CHECK((pack_entry_read(&pack, pack_entry, _buffer)) == 0);
+        CHECK((_pattern_match(_pack_files[i].seed, 0, _buffer, pack_entry->size)) == 0);
+    }
+
+    CHECK((pack_entry_path_find(&pack, "TEX/MISSING.BIN")) == NULL);
+
+    /* Entries are placed in the order given to make-pack */
+    for (uint32_t i = 1; i < PACK_FILE_COUNT; i++) {
+        CHECK(pack_entries[i - 1]->sector < pack_entries[i]->sector);
+    }
+
+    /* The opening read, one per entry */
+    CHECK(pack_stats_get(&pack)->reads == (1 + PACK_FILE_COUNT));
+
+    pack_stats_clear(&pack);
+
+    /* Listed out of order, and read with a single read */
+    const pack_entry_t * const group[] = {
+        pack_entries[1],
+        pack_entries[0]
+    };
+
+    void *pointers[2];
+
+    CHECK((pack_entries_size_get(&pack, group, 2)) ==
+          ((pack_entry_sector_count_get(pack_entries[0]) +
+            pack_entry_sector_count_get(pack_entries[1])) * CDFS_SECTOR_SIZE));
+
+    CHECK((pack_entries_read(&pack, group, 2, _buffer, pointers)) == 0);
+    CHECK(pack_stats_get(&pack)->reads == 1);
+    CHECK(pack_stats_get(&pack)->entries_read == 2);
+    CHECK(pointers[1] == _buffer);
+    CHECK((_pattern_match(_pack_files[0].seed, 0, pointers[1], _pack_files[0].size)) == 0);
+    CHECK((_pattern_match(_pack_files[1].seed, 0, pointers[0], _pack_files[1].size)) == 0);
+
+    /* A buffer smaller than a sector is turned down before reading */
+    cd_block_host_stats_clear();
+
+    CHECK((pack_open(&pack, entries[FILE_PACK].starting_fad, _toc_buffer,
+                CDFS_SECTOR_SIZE - 1)) == -2);
+    CHECK(cd_block_host_stats_get()->reads == 0);
+
+    /* Counts that would overflow once multiplied out */
+    cdfs_filelist_entry_t bad_entry;
+
+    CHECK((cdfs_open(BAD_PACK_FILE, &bad_entry)) == 0);
+
+    const fad_t bad_fad = bad_entry.starting_fad;
+
+    CHECK((pack_open(&pack, bad_fad + BAD_PACK_COUNT_OVERFLOW, _toc_buffer,
+                sizeof(_toc_buffer))) == -1);
+    CHECK((pack_open(&pack, bad_fad + BAD_PACK_TOC_OVERFLOW, _toc_buffer,
+                sizeof(_toc_buffer))) == -1);
+    CHECK((pack_open(&pack, bad_fad + BAD_PACK_TOC_EMPTY, _toc_buffer,
+                sizeof(_toc_buffer))) == -1);
+    CHECK(pack.entries == NULL);
+    CHECK(pack.count == 0);
+}
+
+static void
+_request_complete(void *work)
+{
+    uint32_t * const completed_count = work;
+
+    (*completed_count)++;
+}
+
+static void
+_queue_merge_test(const cdfs_filelist_entry_t *entries)
+{
+    const fad_t pack_fad = entries[FILE_PACK].starting_fad;
+    const fad_t level1_fad = entries[FILE_LEVEL1].starting_fad;
+
+    static uint8_t buffers[4][2 * CDFS_SECTOR_SIZE + 1] __aligned(4);
+
+    uint32_t completed_count;
+    completed_count = 0;
+
+    cd_block_request_t requests[] = {
+        /* The first two sectors of LEVEL1.BIN */
+        {
+            .fad    = level1_fad,
+            .length = 2 * CDFS_SECTOR_SIZE,
+            .buffer = buffers[0]
+        },
+        /* Contiguous with the first */
+        {
+            .fad    = level1_fad + 2,
+            .length = CDFS_SECTOR_SIZE,
+            .buffer = buffers[1]
+        },
+        /* Overlaps the first, into a buffer that can't be transferred into
+         * directly */
+        {
+            .fad    = level1_fad + 1,
+            .length = CDFS_SECTOR_SIZE,
+            .buffer = &buffers[2][1]
+        },
+        /* Nowhere near the others */
+        {
+            .fad    = pack_fad,
+            .length = 100,
+            .buffer = buffers[3]
+        }
+    };
+
+    const uint32_t request_count = sizeof(requests) / sizeof(*requests);
+
+    CHECK(level1_fad > (pack_fad + 1));
+
+    /* Move the drive away from both */
+    CHECK((cd_block_sector_read(LBA2FAD(16), _buffer)) == 0);
+
+    cd_block_queue_init();
+    cd_block_host_stats_clear();
+
+    for (uint32_t i = 0; i < request_count; i++) {
+        requests[i].priority = CD_BLOCK_REQUEST_PRIORITY_NORMAL;
+        requests[i].deadline = CD_BLOCK_REQUEST_DEADLINE_NONE;
+        requests[i].callback_handler = _request_complete;
+        requests[i].work = &completed_count;
+        requests[i].status = -1;
+
+        cd_block_queue_submit(&requests[i]);
+    }
+
+    CHECK(cd_block_queue_pending_count() == request_count);
+
+    /* Sweeping by ascending FAD, the pack comes first */
+    CHECK((cd_block_queue_service(0)) == 1);
+    CHECK(completed_count == 1);
+    CHECK(requests[3].status == 0);
+
+    /* Then the other three, merged into a single read */
+    CHECK((cd_block_queue_service(0)) == 3);
+    CHECK(completed_count == request_count);
+    CHECK(cd_block_queue_pending_count() == 0);
+    CHECK((cd_block_queue_service(0)) == 0);
+
+    const cd_block_queue_stats_t * const stats = cd_block_queue_stats_get();
+
+    CHECK(stats->requests == request_count);
+    CHECK(stats->reads == 2);
+    CHECK(stats->seeks_avoided == 2);
+    CHECK(stats->bytes_merged == (2 * CDFS_SECTOR_SIZE));
+
+    const cd_block_host_stats_t * const host_stats = cd_block_host_stats_get();
+
+    CHECK(host_stats->reads == 2);
+    CHECK(host_stats->seeks == 2);
+    CHECK(host_stats->sectors_read == (1 + 3));
+
+    const uint8_t seed = _files[FILE_LEVEL1].seed;
+
+    for (uint32_t i = 0; i < request_count; i++) {
+        CHECK(requests[i].status == 0);
+        CHECK(requests[i].next == NULL);
+    }
+
+    CHECK((_pattern_match(seed, 0, buffers[0], 2 * CDFS_SECTOR_SIZE)) == 0);
+    CHECK((_pattern_match(seed, 2 * CDFS_SECTOR_SIZE, buffers[1], CDFS_SECTOR_SIZE)) == 0);
+    CHECK((_pattern_match(seed, CDFS_SECTOR_SIZE, &buffers[2][1], CDFS_SECTOR_SIZE)) == 0);
+
+    /* The pack header starts with its magic, big endian */
+    CHECK((memcmp(buffers[3], "PACK", 4)) == 0);
+}
+
+static void
+_request_order_record(void *work)
+{
+    cd_block_request_t * const request = work;
+
+    /* Stash the order of completion in the status, which is set before the
+     * callback is called */
+    static uint32_t order;
+
+    request->status = ++order;
+}
+
+static void
+_queue_deadline_test(const cdfs_filelist_entry_t *entries)
+{
+    cd_block_request_t requests[] = {
+        {
+            .fad      = entries[FILE_PACK].starting_fad,
+            .priority = CD_BLOCK_REQUEST_PRIORITY_HIGH,
+            .deadline = CD_BLOCK_REQUEST_DEADLINE_NONE
+        },
+        {
+            .fad      = entries[FILE_A].starting_fad,
+            .priority = CD_BLOCK_REQUEST_PRIORITY_LOW,
+            .deadline = CD_BLOCK_REQUEST_DEADLINE_NONE
+        },
+        {
+            .fad      = entries[FILE_DEEP].starting_fad,
+            .priority = CD_BLOCK_REQUEST_PRIORITY_LOW,
+            .deadline = 5
+        }
+    };
+
+    const uint32_t request_count = sizeof(requests) / sizeof(*requests);
+
+    cd_block_queue_init();
+
+    for (uint32_t i = 0; i < request_count; i++) {
+        requests[i].length = CDFS_SECTOR_SIZE;
+        requests[i].buffer = _buffer;
+        requests[i].callback_handler = _request_order_record;
+        requests[i].work = &requests[i];
+
+        cd_block_queue_submit(&requests[i]);
+    }
+
+    /* Before the deadline, the highest priority goes first */
+    CHECK((cd_block_queue_service(1)) == 1);
+    /* Once overdue, the deadline beats the sweep */
+    CHECK((cd_block_queue_service(10)) == 1);
+    CHECK((cd_block_queue_service(10)) == 1);
+
+    CHECK(requests[0].status == 1);
+    CHECK(requests[2].status == 2);
+    CHECK(requests[1].status == 3);
+
+    CHECK(cd_block_queue_stats_get()->seeks_avoided == 0);
+}
+
+/* Write a serialized index, big endian as on the disc */
+static size_t
+_index_data_write(uint8_t *data, uint32_t magic, uint32_t count,
+    const uint32_t *hashes, uint32_t hash_count)
+{
+    (void)memset(data, 0, sizeof(cdfs_index_header_t) +
+        (hash_count * sizeof(cdfs_index_entry_t)));
+
+    _be32_write(&data[0], magic);
+    _be32_write(&data[4], count);
+
+    uint8_t * const entries = &data[sizeof(cdfs_index_header_t)];
+
+    for (uint32_t i = 0; i < hash_count; i++) {
+        uint8_t * const entry = &entries[i * sizeof(cdfs_index_entry_t)];
+
+        _be32_write(&entry[0], hashes[i]);
+        entry[12] = CDFS_ENTRY_TYPE_FILE;
+    }
+
+    return sizeof(cdfs_index_header_t) +
+        (hash_count * sizeof(cdfs_index_entry_t));
+}
+
+/* Write a pack header at the start of each sector, none of which can be
+ * opened */
+static int
+_bad_pack_write(const char *path)
+{
+    static const uint32_t headers[BAD_PACK_SECTOR_COUNT][3] = {
+        /* Count * sizeof(pack_entry_t) wraps around to 4 */
+        [BAD_PACK_COUNT_OVERFLOW] = { PACK_MAGIC, 0x0CCCCCCDUL, 1 },
+        /* TOC sectors * CDFS_SECTOR_SIZE wraps around to 0 */
+        [BAD_PACK_TOC_OVERFLOW]   = { PACK_MAGIC, 1, 0x00200000UL },
+        [BAD_PACK_TOC_EMPTY]      = { PACK_MAGIC, 0, 0 }
+    };
+
+    uint8_t sector[CDFS_SECTOR_SIZE];
+
+    FILE *fp;
+
+    if ((fp = fopen(path, "wb")) == NULL) {
+        _error_print("%s: %s\n", path, strerror(errno));
+
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < BAD_PACK_SECTOR_COUNT; i++) {
+        (void)memset(sector, 0, sizeof(sector));
+
+        _be32_write(&sector[0], headers[i][0]);
+        _be32_write(&sector[4], headers[i][1]);
+        _be32_write(&sector[8], headers[i][2]);
+        _be32_write(&sector[12], BAD_PACK_SECTOR_COUNT - i);
+
+        (void)fwrite(sector, sizeof(sector), 1, fp);
+    }
+
+    (void)fclose(fp);
+
+    return 0;
+}
+
+static void
+_be32_write(uint8_t *buffer, uint32_t value)
+{
+    buffer[0] = (value >> 24) & 0xFF;
+    buffer[1] = (value >> 16) & 0xFF;
+    buffer[2] = (value >> 8) & 0xFF;
+    buffer[3] = value & 0xFF;
+}
+
+static uint32_t
+_be32_read(const uint8_t *buffer)
+{
+    return ((uint32_t)buffer[0] << 24) |
+           ((uint32_t)buffer[1] << 16) |
+           ((uint32_t)buffer[2] << 8) |
+           buffer[3];
+}
+
+static uint8_t
+_pattern_byte(uint8_t seed, uint32_t offset)
+{
+    return ((offset * 7) + (offset >> 11) + (seed * 31)) & 0xFF;
+}
+
+static int
+_pattern_match(uint8_t seed, uint32_t offset, const uint8_t *buffer,
+    uint32_t length)
+{
+    for (uint32_t i = 0; i < length; i++) {
+        if (buffer[i] != _pattern_byte(seed, offset + i)) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static int
+_pattern_file_write(const char *path, uint8_t seed, uint32_t size)
+{
+    if ((_directories_make(path)) != 0) {
+        return -1;
+    }
+
+    FILE *fp;
+
+    if ((fp = fopen(path, "wb")) == NULL) {
+        _error_print("%s: %s\n", path, strerror(errno));
+
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < size; i++) {
+        (void)fputc(_pattern_byte(seed, i), fp);
+    }
+
+    (void)fclose(fp);
+
+    return 0;
+}
+
+/* Make every directory leading up to the file */
+static int
+_directories_make(const char *path)
+{
+    char dir[PATH_SIZE];
+
+    (void)snprintf(dir, sizeof(dir), "%s", path);
+
+    for (char *s = &dir[1]; *s != '\0'; s++) {
+        if (*s != '/') {
+            continue;
+        }
+
+        *s = '\0';
+
+        if (((mkdir(dir, 0755)) != 0) && (errno != EEXIST)) {
+            _error_print("%s: %s\n", dir, strerror(errno));
+
+            return -1;
+        }
+
+        *s = '/';
+    }
+
+    return 0;
+}
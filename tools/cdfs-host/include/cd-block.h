@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) Israel Jacquez
+ * See LICENSE for details.
+ *
+ * Israel Jacquez <mrkotfw@gmail.com>
+ */
+
+/* Host stand-in for libyaul's cd-block.h. Sectors are read from a disc image
+ * instead of the CD-block, so that cdfs, the pack reader, and the request queue
+ * can be built and run on the host */
+
+#ifndef _YAUL_CD_BLOCK_H_
+#define _YAUL_CD_BLOCK_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <sys/cdefs.h>
+
+#ifndef __aligned
+#define __aligned(x) __attribute__ ((aligned(x)))
+#endif /* !__aligned */
+
+#ifndef __packed
+#define __packed __attribute__ ((packed))
+#endif /* !__packed */
+
+#ifndef __unused
+#define __unused __attribute__ ((unused))
+#endif /* !__unused */
+
+#define CDFS_SECTOR_SIZE (2048U)
+
+#define FAD2LBA(x)      ((x) - 150)
+#define LBA2FAD(x)      ((x) + 150)
+
+__BEGIN_DECLS
+
+typedef uint32_t fad_t;
+
+/* As in sys/callback-list.h */
+typedef void (*callback_handler_t)(void *work);
+
+typedef struct {
+    /* Reads issued */
+    uint32_t reads;
+    /* Reads that didn't start where the previous read ended */
+    uint32_t seeks;
+    uint32_t sectors_read;
+    /* Time the reads would have taken on the drive */
+    uint64_t simulated_usecs;
+} cd_block_host_stats_t;
+
+typedef struct {
+    /* Drive speed, 1 for 150KiB/s, 2 for 300KiB/s */
+    uint32_t speed;
+    /* Fixed cost of a seek */
+    uint32_t seek_usecs;
+    /* Added cost of a seek per 1,000 sectors travelled */
+    uint32_t seek_usecs_per_ksector;
+    /* Sleep for the simulated time instead of only accounting for it */
+    bool realtime;
+} cd_block_host_latency_t;
+
+/**
+ * Open a disc image. An ISO image is read as 2048-byte sectors. A BIN image
+ * is read as raw 2352-byte sectors, in the mode given by the CUE sheet when a
+ * CUE sheet is opened, or else as Mode 1.
+ *
+ * @return 0 on success, or -1 with errno set.
+ */
+extern int cd_block_host_open(const char *path);
+extern void cd_block_host_close(void);
+
+/**
+ * Set the latency model. Passing NULL disables latency simulation.
+ */
+extern void cd_block_host_latency_set(const cd_block_host_latency_t *latency);
+
+extern const cd_block_host_stats_t *cd_block_host_stats_get(void);
+extern void cd_block_host_stats_clear(void);
+
+extern int cd_block_sector_read(fad_t fad, void *output_buffer);
+extern int cd_block_sectors_read(fad_t fad, void *output_buffer, uint32_t length);
+
+/* The drive only ever plays into buffer partition 0, and filters and
+ * connections are ignored. A play counts as a read in
+ * cd_block_host_stats_t */
+extern int cd_block_cmd_disk_play(int32_t mode, fad_t start_fad, int32_t num_sectors);
+extern int cd_block_cmd_cd_dev_connection_set(uint8_t filter);
+extern int cd_block_cmd_selector_reset(uint8_t flags, uint8_t sel_num);
+extern int cd_block_cmd_sector_number_get(uint8_t buff_num);
+
+/* Transfer the next sector played */
+extern int cd_block_transfer_data(uint16_t offset, uint16_t buffer_number,
+    uint8_t *output_buffer, uint32_t buffer_length);
+
+/* Requests are dispatched highest priority first, unless a deadline is due */
+#define CD_BLOCK_REQUEST_PRIORITY_LOW    (0)
+#define CD_BLOCK_REQUEST_PRIORITY_NORMAL (1)
+#define CD_BLOCK_REQUEST_PRIORITY_HIGH   (2)
+
+/* No deadline */
+#define CD_BLOCK_REQUEST_DEADLINE_NONE   (0)
+
+typedef struct cd_block_request cd_block_request_t;
+
+struct cd_block_request {
+    fad_t fad;
+    uint32_t length;
+    void *buffer;
+    uint8_t priority;
+    uint32_t deadline;
+    callback_handler_t callback_handler;
+    void *work;
+
+    int status;
+
+    /* Private */
+    cd_block_request_t *next;
+};
+
+typedef struct {
+    uint32_t requests;
+    uint32_t reads;
+    uint32_t seeks_avoided;
+    uint32_t bytes_merged;
+} cd_block_queue_stats_t;
+
+extern void cd_block_queue_init(void);
+extern void cd_block_queue_submit(cd_block_request_t *request);
+extern uint32_t cd_block_queue_service(uint32_t now);
+extern uint32_t cd_block_queue_pending_count(void);
+
+extern const cd_block_queue_stats_t *cd_block_queue_stats_get(void);
+extern void cd_block_queue_stats_clear(void);
+
+__END_DECLS
+
+#endif /* !_YAUL_CD_BLOCK_H_ */
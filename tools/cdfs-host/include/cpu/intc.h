@@ -0,0 +1,27 @@
+/*
+ * Copyright (c) Israel Jacquez
+ * See LICENSE for details.
+ *
+ * Israel Jacquez <mrkotfw@gmail.com>
+ */
+
+/* Host stand-in for libyaul's cpu/intc.h. There are no interrupts on the host,
+ * so masking them does nothing */
+
+#ifndef _YAUL_CPU_INTC_H_
+#define _YAUL_CPU_INTC_H_
+
+#include <stdint.h>
+
+static inline uint8_t
+cpu_intc_mask_get(void)
+{
+    return 0;
+}
+
+static inline void
+cpu_intc_mask_set(uint8_t mask __attribute__ ((unused)))
+{
+}
+
+#endif /* !_YAUL_CPU_INTC_H_ */
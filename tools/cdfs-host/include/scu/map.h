@@ -0,0 +1,14 @@
+/*
+ * Copyright (c) Israel Jacquez
+ * See LICENSE for details.
+ *
+ * Israel Jacquez <mrkotfw@gmail.com>
+ */
+
+/* Host stand-in for libyaul's scu/map.h. Nothing in it is needed on the
+ * host */
+
+#ifndef _YAUL_SCU_MAP_H_
+#define _YAUL_SCU_MAP_H_
+
+#endif /* !_YAUL_SCU_MAP_H_ */
@@ -0,0 +1,14 @@
+/*
+ * Copyright (c) Israel Jacquez
+ * See LICENSE for details.
+ *
+ * Israel Jacquez <mrkotfw@gmail.com>
+ */
+
+/* Host stand-in for libyaul's usb-cart.h. Nothing in it is needed on the
+ * host */
+
+#ifndef _YAUL_USB_CART_H_
+#define _YAUL_USB_CART_H_
+
+#endif /* !_YAUL_USB_CART_H_ */
@@ -0,0 +1,580 @@
+/*
+ * Copyright (c) Israel Jacquez
+ * See LICENSE for details.
+ *
+ * Israel Jacquez <mrkotfw@gmail.com>
+ */
+
+#define PROGNAME "make-fmv-track"
+
+#include <sys/stat.h>
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Subheader channels, to be set as fmv_config_t::video_channel and
+ * fmv_config_t::audio_channel */
+#define VIDEO_CHANNEL       (1)
+#define AUDIO_CHANNEL       (2)
+
+#define SECTOR_SIZE         (2048)
+#define RAW_SECTOR_SIZE     (2352)
+
+/* Frame addresses start after the two second lead-in, and a data track that
+ * follows another data track of a different mode has a two second pregap */
+#define LEAD_IN_SECTORS     (150)
+#define PREGAP_SECTORS      (150)
+
+#define PVD_SECTOR          (16)
+/* Both-endian volume space size within the primary volume descriptor */
+#define PVD_VOLUME_SIZE     (80)
+
+#define SUBMODE_EOR         (0x01)
+#define SUBMODE_DATA        (0x08)
+#define SUBMODE_EOF         (0x80)
+
+#define LINE_SIZE           (4096)
+
+typedef struct {
+    const uint8_t *buffer;
+    uint32_t count;
+    uint32_t sector_count;
+    uint32_t period;
+    uint8_t channel;
+} substream_t;
+
+static uint8_t _ecc_f_lut[256];
+static uint8_t _ecc_b_lut[256];
+static uint32_t _edc_lut[256];
+
+static void _usage_print(void);
+static void _error_print(const char *format, ...);
+
+static int _substream_load(substream_t *substream, const char *filename,
+    const char *sector_count, const char *period, uint8_t channel);
+static int _uint_parse(const char *s, uint32_t *value);
+
+static int _iso_sectors_get(const char *iso_filename, uint32_t *sector_count);
+static int _cue_append(const char *cue_filename, const char *out_filename);
+static int _track_write(const char *out_filename, uint32_t fad,
+    const substream_t *video, const substream_t *audio,
+    uint32_t *sector_count);
+
+static void _sector_build(uint8_t *sector, uint32_t fad, uint8_t channel,
+    uint8_t submode, const uint8_t *data);
+static void _luts_init(void);
+static uint32_t _edc_compute(const uint8_t *buffer, uint32_t size);
+static void _ecc_block_compute(const uint8_t *src, uint32_t major_count,
+    uint32_t minor_count, uint32_t major_mult, uint32_t minor_inc,
+    uint8_t *dst);
+
+static uint8_t *_file_read(const char *filename, uint32_t *size);
+
+static inline uint8_t
+_bcd(uint32_t value)
+{
+    return (((value / 10) << 4) | (value % 10));
+}
+
+int
+main(int argc, char *argv[])
+{
+    if (argc != 10) {
+        _usage_print();
+
+        return 1;
+    }
+
+    substream_t video;
+    substream_t audio;
+
+    if ((_substream_load(&video, argv[1], argv[2], argv[3], VIDEO_CHANNEL)) != 0) {
+        return 1;
+    }
+
+    if ((_substream_load(&audio, argv[4], argv[5], argv[6], AUDIO_CHANNEL)) != 0) {
+        return 1;
+    }
+
+    const char * const iso_filename = argv[7];
+    const char * const cue_filename = argv[8];
+    const char * const out_filename = argv[9];
+
+    uint32_t iso_sector_count;
+
+    if ((_iso_sectors_get(iso_filename, &iso_sector_count)) != 0) {
+        return 1;
+    }
+
+    const uint32_t fad = LEAD_IN_SECTORS + iso_sector_count + PREGAP_SECTORS;
+
+    _luts_init();
+
+    uint32_t sector_count;
+
+    if ((_track_write(out_filename, fad, &video, &audio, &sector_count)) != 0) {
+        return 1;
+    }
+
+    if ((_cue_append(cue_filename, out_filename)) != 0) {
+        return 1;
+    }
+
+    (void)printf("%s: FAD %" PRIu32 ", %" PRIu32 " sectors, %" PRIu32
+        " video frames, %" PRIu32 " audio chunks\n", out_filename, fad,
+        sector_count, video.count, audio.count);
+
+    return 0;
+}
+
+static void
+_usage_print(void)
+{
+    (void)fprintf(stderr,
+        "Usage: %s video-file frame-sectors frame-period\n"
+        "       audio-file chunk-sectors chunk-period\n"
+        "       iso-file cue-file out-file\n"
+        "\n"
+        "Interleave video frames and audio chunks into a Mode 2 Form 1 track for\n"
+        "fmv_start(), and append the track to cue-file after the ISO track.\n"
+        "Video sectors are on channel %i, and audio sectors on channel %i.\n"
+        "\n"
+        "Each video frame is frame-sectors sectors of video-file, presented every\n"
+        "frame-period vertical blanks. Each audio chunk is chunk-sectors sectors\n"
+        "of audio-file, played every chunk-period vertical blanks. The last frame\n"
+        "and chunk are padded with zeros.\n"
+        "\n"
+        "The track starts at FAD 150 + sectors of iso-file + 150, which is\n"
+        "printed out. The volume space size of iso-file must match its size.\n",
+        PROGNAME, VIDEO_CHANNEL, AUDIO_CHANNEL);
+}
+
+static void
+_error_print(const char *format, ...)
+{
+    va_list args;
+
+    va_start(args, format);
+
+    (void)fprintf(stderr, "Error: %s: ", PROGNAME);
+    (void)vfprintf(stderr, format, args);
+
+    va_end(args);
+}
+
+static int
+_substream_load(substream_t *substream, const char *filename,
+    const char *sector_count, const char *period, uint8_t channel)
+{
+    if (((_uint_parse(sector_count, &substream->sector_count)) != 0) ||
+        (substream->sector_count == 0)) {
+        _error_print("%s: Invalid sector count \"%s\"\n", filename, sector_count);
+
+        return -1;
+    }
+
+    if (((_uint_parse(period, &substream->period)) != 0) ||
+        (substream->period == 0)) {
+        _error_print("%s: Invalid period \"%s\"\n", filename, period);
+
+        return -1;
+    }
+
+    uint32_t size;
+    uint8_t * const buffer = _file_read(filename, &size);
+
+    if (buffer == NULL) {
+        return -1;
+    }
+
+    const uint32_t unit_size = substream->sector_count * SECTOR_SIZE;
+
+    substream->count = (size + (unit_size - 1)) / unit_size;
+    substream->channel = channel;
+
+    /* Pad the last unit out with zeros */
+    uint8_t * const padded = calloc(1, (substream->count * unit_size) + 1);
+
+    if (padded == NULL) {
+        _error_print("%s\n", strerror(errno));
+
+        free(buffer);
+
+        return -1;
+    }
+
+    (void)memcpy(padded, buffer, size);
+
+    free(buffer);
+
+    substream->buffer = padded;
+
+    return 0;
+}
+
+static int
+_uint_parse(const char *s, uint32_t *value)
+{
+    char *end;
+
+    errno = 0;
+
+    const unsigned long parsed = strtoul(s, &end, 0);
+
+    if ((errno != 0) || (end == s) || (*end != '\0') || (parsed > UINT32_MAX)) {
+        return -1;
+    }
+
+    *value = parsed;
+
+    return 0;
+}
+
+static int
+_iso_sectors_get(const char *iso_filename, uint32_t *sector_count)
+{
+    uint32_t size;
+    uint8_t * const buffer = _file_read(iso_filename, &size);
+
+    if (buffer == NULL) {
+        return -1;
+    }
+
+    int ret;
+    ret = 0;
+
+    if (((size % SECTOR_SIZE) != 0) || (size < ((PVD_SECTOR + 1) * SECTOR_SIZE))) {
+        _error_print("%s: Not an ISO9660 image\n", iso_filename);
+
+        ret = -1;
+    } else {
+        const uint8_t * const pvd = &buffer[PVD_SECTOR * SECTOR_SIZE];
+        const uint8_t * const p = &pvd[PVD_VOLUME_SIZE];
+
+        const uint32_t volume_size =
+            p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+
+        *sector_count = size / SECTOR_SIZE;
+
+        if ((pvd[0] != 0x01) || ((memcmp(&pvd[1], "CD001", 5)) != 0)) {
+            _error_print("%s: Not an ISO9660 image\n", iso_filename);
+
+            ret = -1;
+        } else if (volume_size != *sector_count) {
+            /* The program can only work out where the track starts from the
+             * volume space size */
+            _error_print("%s: Volume space size of %" PRIu32 " sectors doesn't"
+                " match the %" PRIu32 " sectors of the image\n", iso_filename,
+                volume_size, *sector_count);
+
+            ret = -1;
+        }
+    }
+
+    free(buffer);
+
+    return ret;
+}
+
+static int
+_cue_append(const char *cue_filename, const char *out_filename)
+{
+    FILE *fp;
+
+    if ((fp = fopen(cue_filename, "r")) == NULL) {
+        _error_print("%s: %s\n", cue_filename, strerror(errno));
+
+        return -1;
+    }
+
+    char line[LINE_SIZE];
+
+    uint32_t track_count;
+    track_count = 0;
+
+    while ((fgets(line, sizeof(line), fp)) != NULL) {
+        if ((strstr(line, "TRACK")) != NULL) {
+            track_count++;
+        }
+    }
+
+    (void)fclose(fp);
+
+    /* Any other track in between would move the start of this one */
+    if (track_count != 1) {
+        _error_print("%s: Expected only the ISO track, found %" PRIu32 " tracks\n",
+            cue_filename, track_count);
+
+        return -1;
+    }
+
+    if ((fp = fopen(cue_filename, "a")) == NULL) {
+        _error_print("%s: %s\n", cue_filename, strerror(errno));
+
+        return -1;
+    }
+
+    /* The track is referred to relative to the CUE sheet */
+    const char * const slash = strrchr(out_filename, '/');
+    const char * const out_basename = (slash != NULL) ? (slash + 1) : out_filename;
+
+    (void)fprintf(fp,
+        "FILE \"%s\" BINARY\n"
+        "  TRACK 02 MODE2/2352\n"
+        "    PREGAP 00:02:00\n"
+        "    INDEX 01 00:00:00\n",
+        out_basename);
+
+    (void)fclose(fp);
+
+    return 0;
+}
+
+static int
+_track_write(const char *out_filename, uint32_t fad, const substream_t *video,
+    const substream_t *audio, uint32_t *sector_count)
+{
+    FILE *fp;
+
+    if ((fp = fopen(out_filename, "wb")) == NULL) {
+        _error_print("%s: %s\n", out_filename, strerror(errno));
+
+        return -1;
+    }
+
+    const uint32_t total_sector_count =
+        (video->count * video->sector_count) + (audio->count * audio->sector_count);
+
+    uint8_t sector[RAW_SECTOR_SIZE];
+
+    uint32_t frame;
+    frame = 0;
+
+    uint32_t chunk;
+    chunk = 0;
+
+    *sector_count = 0;
+
+    /* Lay out the units by when they're due, so neither partition gets too far
+     * ahead of the other. An audio chunk goes before a video frame due at the
+     * same time, as audio gaps are more noticeable */
+    while ((frame < video->count) || (chunk < audio->count)) {
+        const bool audio_next = (chunk < audio->count) &&
+            ((frame >= video->count) ||
+             ((chunk * audio->period) <= (frame * video->period)));
+
+        const substream_t * const substream = audio_next ? audio : video;
+        const uint32_t unit = audio_next ? chunk++ : frame++;
+
+        const uint8_t * const data =
+            &substream->buffer[unit * substream->sector_count * SECTOR_SIZE];
+
+        for (uint32_t i = 0; i < substream->sector_count; i++) {
+            uint8_t submode;
+            submode = SUBMODE_DATA;
+
+            if (i == (substream->sector_count - 1)) {
+                submode |= SUBMODE_EOR;
+            }
+
+            if ((*sector_count + 1) == total_sector_count) {
+                submode |= SUBMODE_EOF;
+            }
+
+            _sector_build(sector, fad + *sector_count, substream->channel,
+                submode, &data[i * SECTOR_SIZE]);
+
+            if ((fwrite(sector, 1, sizeof(sector), fp)) != sizeof(sector)) {
+                _error_print("%s: %s\n", out_filename, strerror(errno));
+
+                (void)fclose(fp);
+
+                return -1;
+            }
+
+            (*sector_count)++;
+        }
+    }
+
+    if ((fclose(fp)) != 0) {
+        _error_print("%s: %s\n", out_filename, strerror(errno));
+
+        return -1;
+    }
+
+    return 0;
+}
+
+static void
+_sector_build(uint8_t *sector, uint32_t fad, uint8_t channel, uint8_t submode,
+    const uint8_t *data)
+{
+    /* Sync pattern */
+    sector[0] = 0x00;
+    (void)memset(&sector[1], 0xFF, 10);
+    sector[11] = 0x00;
+
+    /* Header */
+    sector[12] = _bcd(fad / (60 * 75));
+    sector[13] = _bcd((fad / 75) % 60);
+    sector[14] = _bcd(fad % 75);
+    sector[15] = 0x02;
+
+    /* Subheader, written twice: file, channel, submode, and coding */
+    for (uint32_t i = 0; i < 2; i++) {
+        uint8_t * const subheader = &sector[16 + (i * 4)];
+
+        subheader[0] = 0x00;
+        subheader[1] = channel;
+        subheader[2] = submode;
+        subheader[3] = 0x00;
+    }
+
+    (void)memcpy(&sector[24], data, SECTOR_SIZE);
+
+    /* The EDC covers the subheader and the user data */
+    const uint32_t edc = _edc_compute(&sector[16], 8 + SECTOR_SIZE);
+
+    sector[2072] = edc;
+    sector[2073] = edc >> 8;
+    sector[2074] = edc >> 16;
+    sector[2075] = edc >> 24;
+
+    /* In Mode 2, the header is taken to be zero for the ECC */
+    uint8_t header[4];
+
+    (void)memcpy(header, &sector[12], sizeof(header));
+    (void)memset(&sector[12], 0x00, sizeof(header));
+
+    /* P parity, then Q parity, which also covers the P parity */
+    _ecc_block_compute(&sector[12], 86, 24, 2, 86, &sector[2076]);
+    _ecc_block_compute(&sector[12], 52, 43, 86, 88, &sector[2248]);
+
+    (void)memcpy(&sector[12], header, sizeof(header));
+}
+
+static void
+_luts_init(void)
+{
+    for (uint32_t i = 0; i < 256; i++) {
+        const uint32_t j = (i << 1) ^ (((i & 0x80) != 0) ? 0x11D : 0x000);
+
+        _ecc_f_lut[i] = j;
+        _ecc_b_lut[i ^ j] = i;
+
+        uint32_t edc;
+        edc = i;
+
+        for (uint32_t k = 0; k < 8; k++) {
+            edc = (edc >> 1) ^ (((edc & 1) != 0) ? 0xD8018001UL : 0x00000000UL);
+        }
+
+        _edc_lut[i] = edc;
+    }
+}
+
+static uint32_t
+_edc_compute(const uint8_t *buffer, uint32_t size)
+{
+    uint32_t edc;
+    edc = 0;
+
+    for (uint32_t i = 0; i < size; i++) {
+        edc = (edc >> 8) ^ _edc_lut[(edc ^ buffer[i]) & 0xFF];
+    }
+
+    return edc;
+}
+
+static void
+_ecc_block_compute(const uint8_t *src, uint32_t major_count,
+    uint32_t minor_count, uint32_t major_mult, uint32_t minor_inc,
+    uint8_t *dst)
+{
+    const uint32_t size = major_count * minor_count;
+
+    for (uint32_t major = 0; major < major_count; major++) {
+        uint32_t index;
+        index = ((major >> 1) * major_mult) + (major & 1);
+
+        uint8_t ecc_a;
+        ecc_a = 0;
+
+        uint8_t ecc_b;
+        ecc_b = 0;
+
+        for (uint32_t minor = 0; minor < minor_count; minor++) {
+            const uint8_t value = src[index];
+
+            index += minor_inc;
+
+            if (index >= size) {
+                index -= size;
+            }
+
+            ecc_a ^= value;
+            ecc_b ^= value;
+            ecc_a = _ecc_f_lut[ecc_a];
+        }
+
+        ecc_a = _ecc_b_lut[_ecc_f_lut[ecc_a] ^ ecc_b];
+
+        dst[major] = ecc_a;
+        dst[major + major_count] = ecc_a ^ ecc_b;
+    }
+}
+
+static uint8_t *
+_file_read(const char *filename, uint32_t *size)
+{
+    FILE *fp;
+
+    if ((fp = fopen(filename, "rb")) == NULL) {
+        _error_print("%s: %s\n", filename, strerror(errno));
+
+        return NULL;
+    }
+
+    struct stat file_stat;
+
+    if ((fstat(fileno(fp), &file_stat)) != 0) {
+        _error_print("%s: %s\n", filename, strerror(errno));
+
+        (void)fclose(fp);
+
+        return NULL;
+    }
+
+    *size = file_stat.st_size;
+
+    /* Allocate at least one byte so that empty files are valid */
+    uint8_t * const buffer = malloc(*size + 1);
+
+    if (buffer == NULL) {
+        _error_print("%s\n", strerror(errno));
+
+        (void)fclose(fp);
+
+        return NULL;
+    }
+
+    if ((fread(buffer, 1, *size, fp)) != *size) {
+        _error_print("%s: %s\n", filename, strerror(errno));
+
+        free(buffer);
+
+        (void)fclose(fp);
+
+        return NULL;
+    }
+
+    (void)fclose(fp);
+
+    return buffer;
+}
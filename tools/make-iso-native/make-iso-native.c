@@ -0,0 +1,1188 @@
+/*
+ * Copyright (c) Israel Jacquez
+ * See LICENSE for details.
+ *
+ * Israel Jacquez <mrkotfw@gmail.com>
+ */
+
+/* Write an ISO9660 level 1 image with the IP.BIN in the system area, without
+ * going through xorrisofs. Files are placed in the order given by an optional
+ * file ordering list, so that files that are read together end up next to one
+ * another, and hot files end up near the start of the disc */
+
+#define PROGNAME "make-iso-native"
+
+#include <sys/stat.h>
+
+#include <ctype.h>
+#include <dirent.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SECTOR_SIZE          (2048)
+/* Sectors 0 to 15 */
+#define SYSTEM_AREA_SIZE     (16 * SECTOR_SIZE)
+
+#define PVD_SECTOR           (16)
+#define TERMINATOR_SECTOR    (17)
+#define PATH_TABLE_SECTOR    (18)
+
+/* Same as the padding xorrisofs adds by default */
+#define PADDING_SECTOR_COUNT (150)
+
+#define DIR_LEVEL_MAX        (8)
+#define DIR_RECORD_SIZE      (33)
+
+#define FILE_FLAG_DIRECTORY  (0x02)
+
+#define SYSTEM_ID            "SEGA SEGASATURN"
+#define PUBLISHER_ID         "SEGA ENTERPRISES, LTD."
+
+#define ABSTRACT_FILE_ID     "ABS.TXT"
+#define BIBLIO_FILE_ID       "BIB.TXT"
+#define COPYRIGHT_FILE_ID    "CPY.TXT"
+
+#define LINE_SIZE            (4096)
+
+/* Must match the directory index in libyaul (see fs/cd/cdfs.h) */
+#define INDEX_MAGIC          (0x43444958UL) /* "CDIX" */
+#define INDEX_HEADER_SIZE    (8)
+#define INDEX_ENTRY_SIZE     (16)
+#define INDEX_HASH_INIT      (0x811C9DC5UL)
+#define INDEX_HASH_PRIME     (0x01000193UL)
+#define INDEX_TYPE_FILE      (1)
+#define INDEX_TYPE_DIRECTORY (2)
+
+/* Same as LBA2FAD() */
+#define FAD_OFFSET           (150)
+
+typedef struct node node_t;
+
+struct node {
+    /* Name as stored in the image, without the ";1" version */
+    char *name;
+    /* Path on the host */
+    char *host_path;
+    /* Path within the image, e.g. "DIR/FILE.BIN" */
+    char *image_path;
+
+    bool directory;
+    uint32_t level;
+
+    node_t *parent;
+    node_t **children;
+    uint32_t child_count;
+
+    /* Position in the path table, starting from 1 */
+    uint32_t dir_number;
+
+    uint32_t lba;
+    uint32_t size;
+    bool placed;
+
+    /* Written from memory instead of from a host file */
+    const uint8_t *data;
+};
+
+static node_t *_root = NULL;
+
+static node_t **_dirs = NULL;
+static uint32_t _dir_count = 0;
+
+static node_t **_files = NULL;
+static uint32_t _file_count = 0;
+
+static uint32_t _path_table_size = 0;
+static uint32_t _path_table_sector_count = 0;
+static uint32_t _volume_sector_count = 0;
+
+static struct tm _tm;
+
+static node_t *_index_node = NULL;
+
+static void _error_print(const char *format, ...);
+
+static node_t *_tree_build(node_t *parent, const char *host_path,
+    const char *name);
+static int _name_convert(const char *name, bool directory, char *iso_name);
+static int _node_compare(const void *a, const void *b);
+
+static void _dirs_collect(void);
+static void _files_collect(node_t *dir);
+static uint32_t _dir_size_calculate(const node_t *dir);
+static void _path_table_size_calculate(void);
+
+static int _index_add(const char *name);
+static int _index_write(void);
+static uint32_t _index_hash(const char *image_path);
+static int _index_entry_compare(const void *a, const void *b);
+
+static int _order_read(const char *order_filename, uint32_t *lba);
+static node_t *_file_find(const char *image_path);
+static void _file_place(node_t *file, uint32_t *lba);
+
+static int _image_write(const char *ip_bin_path, const char *image_path);
+static void _pvd_write(uint8_t *sector);
+static void _terminator_write(uint8_t *sector);
+static void _path_table_write(uint8_t *buffer, bool big_endian);
+static void _dir_write(uint8_t *buffer, const node_t *dir);
+static uint32_t _dir_record_write(uint8_t *record, const node_t *node,
+    const char *id, uint32_t id_len);
+
+static void _both_16_write(uint8_t *buffer, uint16_t value);
+static void _both_32_write(uint8_t *buffer, uint32_t value);
+static void _le16_write(uint8_t *buffer, uint16_t value);
+static void _le32_write(uint8_t *buffer, uint32_t value);
+static void _be16_write(uint8_t *buffer, uint16_t value);
+static void _be32_write(uint8_t *buffer, uint32_t value);
+static void _string_write(uint8_t *buffer, const char *s, size_t size);
+static void _long_date_write(uint8_t *buffer, bool unset);
+static void _short_date_write(uint8_t *buffer);
+
+static inline uint32_t
+_sector_count_round(uint32_t size)
+{
+    return ((size + (SECTOR_SIZE - 1)) / SECTOR_SIZE);
+}
+
+int
+main(int argc, char *argv[])
+{
+    const char *index_name;
+    index_name = NULL;
+
+    int option;
+
+    while ((option = getopt(argc, argv, "x:")) != -1) {
+        switch (option) {
+        case 'x':
+            index_name = optarg;
+            break;
+        default:
+            argc = 0;
+            break;
+        }
+    }
+
+    argc -= optind;
+    argv += optind;
+
+    if ((argc != 4) && (argc != 5)) {
+        (void)fprintf(stderr,
+            "Usage: %s [-x index-name] cd-directory IP.BIN-path image-output-path image-output-name [order-file]\n"
+            "\n"
+            "Each line of order-file is the path of a file within cd-directory, e.g.\n"
+            "DATA/LEVEL1.PAK. Listed files are placed first, in the order listed, and\n"
+            "anything after the path on a line is ignored, so that a CD access trace\n"
+            "can be used as is. Lines starting with '#' are ignored.\n"
+            "\n"
+            "With -x, a directory index of every file and directory on the disc,\n"
+            "itself included, is written to the root directory as index-name. It can\n"
+            "be read into memory and passed to cdfs_index_load(). The index can be\n"
+            "listed in order-file like any other file.\n",
+            PROGNAME);
+
+        return 2;
+    }
+
+    const char * const cd_directory = argv[0];
+    const char * const ip_bin_path = argv[1];
+    const char * const output_directory = argv[2];
+    const char * const image_name = argv[3];
+    const char * const order_filename = (argc == 5) ? argv[4] : NULL;
+
+    /* Honor SOURCE_DATE_EPOCH for reproducible images */
+    time_t now;
+    now = time(NULL);
+
+    const char * const source_date_epoch = getenv("SOURCE_DATE_EPOCH");
+
+    if (source_date_epoch != NULL) {
+        now = (time_t)strtoll(source_date_epoch, NULL, 10);
+    }
+
+    (void)gmtime_r(&now, &_tm);
+
+    if ((_root = _tree_build(NULL, cd_directory, "")) == NULL) {
+        return 1;
+    }
+
+    const char * const required_files[] = {
+        ABSTRACT_FILE_ID,
+        BIBLIO_FILE_ID,
+        COPYRIGHT_FILE_ID
+    };
+
+    for (uint32_t i = 0; i < 3; i++) {
+        if ((_file_find(required_files[i])) == NULL) {
+            _error_print("%s: Does not exist in %s\n", required_files[i],
+                cd_directory);
+
+            return 1;
+        }
+    }
+
+    if (index_name != NULL) {
+        if ((_index_add(index_name)) != 0) {
+            return 1;
+        }
+    }
+
+    _dirs_collect();
+    _path_table_size_calculate();
+
+    /* Every file and directory other than the root directory */
+    if (_index_node != NULL) {
+        _index_node->size = INDEX_HEADER_SIZE +
+            (((_dir_count - 1) + _file_count) * INDEX_ENTRY_SIZE);
+    }
+
+    /* Both path tables, then the directories */
+    uint32_t lba;
+    lba = PATH_TABLE_SECTOR + (2 * _path_table_sector_count);
+
+    for (uint32_t i = 0; i < _dir_count; i++) {
+        node_t * const dir = _dirs[i];
+
+        dir->size = _dir_size_calculate(dir);
+        dir->lba = lba;
+
+        lba += _sector_count_round(dir->size);
+    }
+
+    /* Files that are listed come first, in the order listed */
+    if (order_filename != NULL) {
+        if ((_order_read(order_filename, &lba)) != 0) {
+            return 1;
+        }
+    }
+
+    for (uint32_t i = 0; i < _file_count; i++) {
+        _file_place(_files[i], &lba);
+    }
+
+    _volume_sector_count = lba + PADDING_SECTOR_COUNT;
+
+    /* Only now is every file placed */
+    if (_index_node != NULL) {
+        if ((_index_write()) != 0) {
+            return 1;
+        }
+    }
+
+    char image_path[LINE_SIZE];
+
+    (void)snprintf(image_path, sizeof(image_path), "%s/%s.iso",
+        output_directory, image_name);
+
+    if ((_image_write(ip_bin_path, image_path)) != 0) {
+        (void)remove(image_path);
+
+        return 1;
+    }
+
+    return 0;
+}
+
+static void
+_error_print(const char *format, ...)
+{
+    va_list args;
+
+    va_start(args, format);
+
+    (void)fprintf(stderr, "%s: Error: ", PROGNAME);
+    (void)vfprintf(stderr, format, args);
+
+    va_end(args);
+}
+
+static node_t *
+_tree_build(node_t *parent, const char *host_path, const char *name)
+{
+    struct stat node_stat;
+
+    if ((stat(host_path, &node_stat)) != 0) {
+        _error_print("%s: %s\n", host_path, strerror(errno));
+
+        return NULL;
+    }
+
+    node_t * const node = calloc(1, sizeof(node_t));
+
+    node->host_path = strdup(host_path);
+    node->parent = parent;
+    node->directory = S_ISDIR(node_stat.st_mode);
+    node->level = (parent != NULL) ? (parent->level + 1) : 1;
+
+    if (parent == NULL) {
+        node->name = strdup("");
+        node->image_path = strdup("");
+    } else {
+        char iso_name[16];
+
+        if ((_name_convert(name, node->directory, iso_name)) != 0) {
+            _error_print("%s: Not a valid ISO9660 level 1 name\n", host_path);
+
+            return NULL;
+        }
+
+        node->name = strdup(iso_name);
+
+        const size_t image_path_size =
+            strlen(parent->image_path) + strlen(iso_name) + 2;
+
+        node->image_path = malloc(image_path_size);
+
+        (void)snprintf(node->image_path, image_path_size, "%s%s%s",
+            parent->image_path, (parent->parent != NULL) ? "/" : "", iso_name);
+    }
+
+    if (!node->directory) {
+        if (!S_ISREG(node_stat.st_mode)) {
+            _error_print("%s: Not a file\n", host_path);
+
+            return NULL;
+        }
+
+        if ((uint64_t)node_stat.st_size > UINT32_MAX) {
+            _error_print("%s: File is too large\n", host_path);
+
+            return NULL;
+        }
+
+        node->size = node_stat.st_size;
+
+        _files = realloc(_files, (_file_count + 1) * sizeof(node_t *));
+        _files[_file_count] = node;
+        _file_count++;
+
+        return node;
+    }
+
+    if (node->level > DIR_LEVEL_MAX) {
+        _error_print("%s: Directories are nested too deep\n", host_path);
+
+        return NULL;
+    }
+
+    DIR *dp;
+
+    if ((dp = opendir(host_path)) == NULL) {
+        _error_print("%s: %s\n", host_path, strerror(errno));
+
+        return NULL;
+    }
+
+    struct dirent *dirent;
+
+    while ((dirent = readdir(dp)) != NULL) {
+        /* Hidden files and directories, such as editor swap files, are left
+         * out, as make-iso does with -m ".*". This also skips "." and ".." */
+        if (dirent->d_name[0] == '.') {
+            continue;
+        }
+
+        const size_t child_path_size =
+            strlen(host_path) + strlen(dirent->d_name) + 2;
+
+        char * const child_path = malloc(child_path_size);
+
+        (void)snprintf(child_path, child_path_size, "%s/%s", host_path,
+            dirent->d_name);
+
+        node_t * const child = _tree_build(node, child_path, dirent->d_name);
+
+        free(child_path);
+
+        if (child == NULL) {
+            (void)closedir(dp);
+
+            return NULL;
+        }
+
+        node->children = realloc(node->children,
+            (node->child_count + 1) * sizeof(node_t *));
+        node->children[node->child_count] = child;
+        node->child_count++;
+    }
+
+    (void)closedir(dp);
+
+    qsort(node->children, node->child_count, sizeof(node_t *), _node_compare);
+
+    for (uint32_t i = 1; i < node->child_count; i++) {
+        if ((strcmp(node->children[i - 1]->name, node->children[i]->name)) == 0) {
+            _error_print("%s: Two entries map to %s\n", host_path,
+                node->children[i]->name);
+
+            return NULL;
+        }
+    }
+
+    return node;
+}
+
+/* Convert to an upper case 8.3 file name, or an 8 character directory name */
+static int
+_name_convert(const char *name, bool directory, char *iso_name)
+{
+    uint32_t base_len;
+    base_len = 0;
+
+    uint32_t ext_len;
+    ext_len = 0;
+
+    bool in_ext;
+    in_ext = false;
+
+    char *out;
+    out = iso_name;
+
+    for (const char *s = name; *s != '\0'; s++) {
+        const char c = toupper((unsigned char)*s);
+
+        if ((c == '.') && !directory && !in_ext) {
+            in_ext = true;
+            *out++ = c;
+
+            continue;
+        }
+
+        if (!(((c >= 'A') && (c <= 'Z')) ||
+              ((c >= '0') && (c <= '9')) ||
+              (c == '_'))) {
+            return -1;
+        }
+
+        if (in_ext) {
+            ext_len++;
+        } else {
+            base_len++;
+        }
+
+        if ((base_len > 8) || (ext_len > 3)) {
+            return -1;
+        }
+
+        *out++ = c;
+    }
+
+    *out = '\0';
+
+    return ((base_len == 0) ? -1 : 0);
+}
+
+/* ISO9660 orders by name, then by extension, each padded with spaces */
+static int
+_node_compare(const void *a, const void *b)
+{
+    const node_t * const node_a = *(const node_t * const *)a;
+    const node_t * const node_b = *(const node_t * const *)b;
+
+    const char *name_a;
+    name_a = node_a->name;
+
+    const char *name_b;
+    name_b = node_b->name;
+
+    for (uint32_t part = 0; part < 2; part++) {
+        while (true) {
+            const char c_a = ((*name_a == '.') || (*name_a == '\0')) ? ' ' : *name_a;
+            const char c_b = ((*name_b == '.') || (*name_b == '\0')) ? ' ' : *name_b;
+
+            if ((c_a == ' ') && (c_b == ' ')) {
+                break;
+            }
+
+            if (c_a != c_b) {
+                return ((unsigned char)c_a - (unsigned char)c_b);
+            }
+
+            if (c_a != ' ') {
+                name_a++;
+            }
+
+            if (c_b != ' ') {
+                name_b++;
+            }
+        }
+
+        if (*name_a == '.') {
+            name_a++;
+        }
+
+        if (*name_b == '.') {
+            name_b++;
+        }
+    }
+
+    return 0;
+}
+
+/* Breadth first, which is also path table order */
+static void
+_dirs_collect(void)
+{
+    _dirs = malloc(sizeof(node_t *));
+    _dirs[0] = _root;
+    _dir_count = 1;
+
+    _root->dir_number = 1;
+
+    for (uint32_t i = 0; i < _dir_count; i++) {
+        node_t * const dir = _dirs[i];
+
+        for (uint32_t j = 0; j < dir->child_count; j++) {
+            node_t * const child = dir->children[j];
+
+            if (!child->directory) {
+                continue;
+            }
+
+            _dirs = realloc(_dirs, (_dir_count + 1) * sizeof(node_t *));
+            _dirs[_dir_count] = child;
+            _dir_count++;
+
+            child->dir_number = _dir_count;
+        }
+    }
+
+    /* Files not in the ordering list are placed directory by directory */
+    free(_files);
+
+    _files = NULL;
+    _file_count = 0;
+
+    for (uint32_t i = 0; i < _dir_count; i++) {
+        _files_collect(_dirs[i]);
+    }
+}
+
+static void
+_files_collect(node_t *dir)
+{
+    for (uint32_t i = 0; i < dir->child_count; i++) {
+        node_t * const child = dir->children[i];
+
+        if (child->directory) {
+            continue;
+        }
+
+        _files = realloc(_files, (_file_count + 1) * sizeof(node_t *));
+        _files[_file_count] = child;
+        _file_count++;
+    }
+}
+
+static uint32_t
+_record_size(uint32_t id_len)
+{
+    const uint32_t size = DIR_RECORD_SIZE + id_len;
+
+    /* Padded to an even size */
+    return (size + (size & 1));
+}
+
+static uint32_t
+_child_id_len(const node_t *child)
+{
+    /* Files have the ";1" version appended */
+    return (strlen(child->name) + (child->directory ? 0 : 2));
+}
+
+static uint32_t
+_dir_size_calculate(const node_t *dir)
+{
+    /* The "." and ".." records */
+    uint32_t size;
+    size = 2 * _record_size(1);
+
+    for (uint32_t i = 0; i < dir->child_count; i++) {
+        const uint32_t record_size = _record_size(_child_id_len(dir->children[i]));
+
+        /* Records can't cross a sector boundary */
+        const uint32_t sector_left = SECTOR_SIZE - (size % SECTOR_SIZE);
+
+        if (record_size > sector_left) {
+            size += sector_left;
+        }
+
+        size += record_size;
+    }
+
+    return (_sector_count_round(size) * SECTOR_SIZE);
+}
+
+static void
+_path_table_size_calculate(void)
+{
+    _path_table_size = 0;
+
+    for (uint32_t i = 0; i < _dir_count; i++) {
+        const uint32_t id_len = (i == 0) ? 1 : strlen(_dirs[i]->name);
+
+        _path_table_size += 8 + id_len + (id_len & 1);
+    }
+
+    _path_table_sector_count = _sector_count_round(_path_table_size);
+}
+
+static int
+_index_add(const char *name)
+{
+    char iso_name[16];
+
+    if ((_name_convert(name, false, iso_name)) != 0) {
+        _error_print("%s: Not a valid ISO9660 level 1 name\n", name);
+
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < _root->child_count; i++) {
+        if ((strcmp(_root->children[i]->name, iso_name)) == 0) {
+            _error_print("%s: Already exists\n", iso_name);
+
+            return -1;
+        }
+    }
+
+    node_t * const node = calloc(1, sizeof(node_t));
+
+    node->name = strdup(iso_name);
+    node->image_path = strdup(iso_name);
+    node->parent = _root;
+    node->directory = false;
+    node->level = _root->level + 1;
+
+    _root->children = realloc(_root->children,
+        (_root->child_count + 1) * sizeof(node_t *));
+    _root->children[_root->child_count] = node;
+    _root->child_count++;
+
+    qsort(_root->children, _root->child_count, sizeof(node_t *), _node_compare);
+
+    _index_node = node;
+
+    return 0;
+}
+
+static int
+_index_write(void)
+{
+    const uint32_t count = (_dir_count - 1) + _file_count;
+
+    uint8_t * const data = calloc(1, _index_node->size);
+
+    _be32_write(&data[0], INDEX_MAGIC);
+    _be32_write(&data[4], count);
+
+    uint8_t *entry;
+    entry = &data[INDEX_HEADER_SIZE];
+
+    for (uint32_t i = 0; i < count; i++) {
+        /* Skip the root directory */
+        const node_t * const node = (i < (_dir_count - 1))
+            ? _dirs[i + 1]
+            : _files[i - (_dir_count - 1)];
+
+        _be32_write(&entry[0], _index_hash(node->image_path));
+        _be32_write(&entry[4], node->lba + FAD_OFFSET);
+        _be32_write(&entry[8], node->size);
+
+        entry[12] = node->directory ? INDEX_TYPE_DIRECTORY : INDEX_TYPE_FILE;
+        /* Levels in the index start from 0 in the root directory */
+        entry[13] = node->level - 2;
+
+        entry += INDEX_ENTRY_SIZE;
+    }
+
+    uint8_t * const entries = &data[INDEX_HEADER_SIZE];
+
+    qsort(entries, count, INDEX_ENTRY_SIZE, _index_entry_compare);
+
+    for (uint32_t i = 1; i < count; i++) {
+        if ((memcmp(&entries[(i - 1) * INDEX_ENTRY_SIZE],
+                    &entries[i * INDEX_ENTRY_SIZE], 4)) == 0) {
+            _error_print("%s: Two paths hash the same\n", _index_node->name);
+
+            free(data);
+
+            return -1;
+        }
+    }
+
+    _index_node->data = data;
+
+    return 0;
+}
+
+/* FNV-1a of the upper case path, same as cdfs_path_hash() */
+static uint32_t
+_index_hash(const char *image_path)
+{
+    uint32_t hash;
+    hash = INDEX_HASH_INIT;
+
+    for (const char *s = image_path; *s != '\0'; s++) {
+        hash = (hash ^ (uint8_t)toupper((unsigned char)*s)) * INDEX_HASH_PRIME;
+    }
+
+    return hash;
+}
+
+/* The hash is big endian, so comparing bytes orders by hash */
+static int
+_index_entry_compare(const void *a, const void *b)
+{
+    return memcmp(a, b, 4);
+}
+
+static int
+_order_read(const char *order_filename, uint32_t *lba)
+{
+    FILE *fp;
+
+    if ((fp = fopen(order_filename, "r")) == NULL) {
+        _error_print("%s: %s\n", order_filename, strerror(errno));
+
+        return -1;
+    }
+
+    char line[LINE_SIZE];
+    uint32_t line_number;
+    line_number = 0;
+
+    while ((fgets(line, sizeof(line), fp)) != NULL) {
+        line_number++;
+
+        char *path;
+        path = strtok(line, " \t\r\n");
+
+        if ((path == NULL) || (*path == '#')) {
+            continue;
+        }
+
+        while (*path == '/') {
+            path++;
+        }
+
+        /* Match regardless of case and version */
+        for (char *s = path; *s != '\0'; s++) {
+            *s = toupper((unsigned char)*s);
+
+            if (*s == ';') {
+                *s = '\0';
+                break;
+            }
+        }
+
+        node_t * const file = _file_find(path);
+
+        if ((file == NULL) || file->directory) {
+            (void)fprintf(stderr, "%s: Warning: %s:%" PRIu32 ": %s: No such file\n",
+                PROGNAME, order_filename, line_number, path);
+
+            continue;
+        }
+
+        /* A trace may list a file more than once. Only the first time counts */
+        _file_place(file, lba);
+    }
+
+    (void)fclose(fp);
+
+    return 0;
+}
+
+static node_t *
+_file_find(const char *image_path)
+{
+    for (uint32_t i = 0; i < _file_count; i++) {
+        if ((strcmp(_files[i]->image_path, image_path)) == 0) {
+            return _files[i];
+        }
+    }
+
+    return NULL;
+}
+
+static void
+_file_place(node_t *file, uint32_t *lba)
+{
+    if (file->placed) {
+        return;
+    }
+
+    file->placed = true;
+    file->lba = *lba;
+
+    /* Empty files take no sectors */
+    *lba += _sector_count_round(file->size);
+
+    (void)printf("%8" PRIu32 " %10" PRIu32 " %s\n", file->lba, file->size,
+        file->image_path);
+}
+
+static int
+_image_write(const char *ip_bin_path, const char *image_path)
+{
+    uint8_t * const header = calloc(PATH_TABLE_SECTOR, SECTOR_SIZE);
+
+    FILE *ip_bin_fp;
+
+    if ((ip_bin_fp = fopen(ip_bin_path, "rb")) == NULL) {
+        _error_print("%s: %s\n", ip_bin_path, strerror(errno));
+
+        return -1;
+    }
+
+    const size_t ip_bin_size = fread(header, 1, SYSTEM_AREA_SIZE + 1, ip_bin_fp);
+
+    (void)fclose(ip_bin_fp);
+
+    if (ip_bin_size > SYSTEM_AREA_SIZE) {
+        _error_print("%s: Larger than the system area\n", ip_bin_path);
+
+        return -1;
+    }
+
+    _pvd_write(&header[PVD_SECTOR * SECTOR_SIZE]);
+    _terminator_write(&header[TERMINATOR_SECTOR * SECTOR_SIZE]);
+
+    FILE *fp;
+
+    if ((fp = fopen(image_path, "wb+")) == NULL) {
+        _error_print("%s: %s\n", image_path, strerror(errno));
+
+        return -1;
+    }
+
+    int ret;
+    ret = 0;
+
+    (void)fwrite(header, SECTOR_SIZE, PATH_TABLE_SECTOR, fp);
+
+    free(header);
+
+    const size_t path_table_size = _path_table_sector_count * SECTOR_SIZE;
+
+    uint8_t * const path_table = calloc(1, path_table_size);
+
+    _path_table_write(path_table, false);
+    (void)fwrite(path_table, 1, path_table_size, fp);
+
+    (void)memset(path_table, 0, path_table_size);
+
+    _path_table_write(path_table, true);
+    (void)fwrite(path_table, 1, path_table_size, fp);
+
+    free(path_table);
+
+    for (uint32_t i = 0; i < _dir_count; i++) {
+        const node_t * const dir = _dirs[i];
+
+        uint8_t * const buffer = calloc(1, dir->size);
+
+        _dir_write(buffer, dir);
+
+        if ((fseek(fp, (long)dir->lba * SECTOR_SIZE, SEEK_SET)) != 0) {
+            ret = -1;
+        } else {
+            (void)fwrite(buffer, 1, dir->size, fp);
+        }
+
+        free(buffer);
+    }
+
+    uint8_t * const buffer = malloc(SECTOR_SIZE);
+
+    for (uint32_t i = 0; (i < _file_count) && (ret == 0); i++) {
+        const node_t * const file = _files[i];
+
+        if (file->data != NULL) {
+            if ((fseek(fp, (long)file->lba * SECTOR_SIZE, SEEK_SET)) != 0) {
+                ret = -1;
+            } else if ((fwrite(file->data, 1, file->size, fp)) != file->size) {
+                ret = -1;
+            }
+
+            continue;
+        }
+
+        FILE *file_fp;
+
+        if ((file_fp = fopen(file->host_path, "rb")) == NULL) {
+            _error_print("%s: %s\n", file->host_path, strerror(errno));
+
+            ret = -1;
+            break;
+        }
+
+        if ((fseek(fp, (long)file->lba * SECTOR_SIZE, SEEK_SET)) != 0) {
+            ret = -1;
+        }
+
+        size_t read_size;
+
+        while ((ret == 0) &&
+               ((read_size = fread(buffer, 1, SECTOR_SIZE, file_fp)) > 0)) {
+            if ((fwrite(buffer, 1, read_size, fp)) != read_size) {
+                ret = -1;
+            }
+        }
+
+        (void)fclose(file_fp);
+    }
+
+    /* Pad out the image to the volume size */
+    if ((ret == 0) &&
+        ((fseek(fp, ((long)_volume_sector_count * SECTOR_SIZE) - 1, SEEK_SET)) == 0)) {
+        (void)fputc(0x00, fp);
+    }
+
+    free(buffer);
+
+    if ((ferror(fp)) || (ret != 0)) {
+        _error_print("%s: %s\n", image_path, strerror(errno));
+
+        ret = -1;
+    }
+
+    (void)fclose(fp);
+
+    return ret;
+}
+
+static void
+_pvd_write(uint8_t *sector)
+{
+    sector[0] = 1;
+    (void)memcpy(&sector[1], "CD001", 5);
+    sector[6] = 1;
+
+    _string_write(&sector[8], SYSTEM_ID, 32);
+    _string_write(&sector[40], "", 32);
+
+    _both_32_write(&sector[80], _volume_sector_count);
+
+    _both_16_write(&sector[120], 1);
+    _both_16_write(&sector[124], 1);
+    _both_16_write(&sector[128], SECTOR_SIZE);
+
+    _both_32_write(&sector[132], _path_table_size);
+
+    _le32_write(&sector[140], PATH_TABLE_SECTOR);
+    _le32_write(&sector[144], 0);
+    _be32_write(&sector[148], PATH_TABLE_SECTOR + _path_table_sector_count);
+    _be32_write(&sector[152], 0);
+
+    (void)_dir_record_write(&sector[156], _root, "\0", 1);
+
+    _string_write(&sector[190], "", 128);
+    _string_write(&sector[318], PUBLISHER_ID, 128);
+    _string_write(&sector[446], PUBLISHER_ID, 128);
+    _string_write(&sector[574], PUBLISHER_ID, 128);
+
+    _string_write(&sector[702], COPYRIGHT_FILE_ID, 37);
+    _string_write(&sector[739], ABSTRACT_FILE_ID, 37);
+    _string_write(&sector[776], BIBLIO_FILE_ID, 37);
+
+    _long_date_write(&sector[813], false);
+    _long_date_write(&sector[830], false);
+    _long_date_write(&sector[847], true);
+    _long_date_write(&sector[864], true);
+
+    sector[881] = 1;
+}
+
+static void
+_terminator_write(uint8_t *sector)
+{
+    sector[0] = 255;
+    (void)memcpy(&sector[1], "CD001", 5);
+    sector[6] = 1;
+}
+
+static void
+_path_table_write(uint8_t *buffer, bool big_endian)
+{
+    uint8_t *p;
+    p = buffer;
+
+    for (uint32_t i = 0; i < _dir_count; i++) {
+        const node_t * const dir = _dirs[i];
+
+        const uint32_t id_len = (i == 0) ? 1 : strlen(dir->name);
+        const uint16_t parent_number =
+            (dir->parent != NULL) ? dir->parent->dir_number : 1;
+
+        p[0] = id_len;
+        p[1] = 0;
+
+        if (big_endian) {
+            _be32_write(&p[2], dir->lba);
+            _be16_write(&p[6], parent_number);
+        } else {
+            _le32_write(&p[2], dir->lba);
+            _le16_write(&p[6], parent_number);
+        }
+
+        if (i == 0) {
+            p[8] = 0x00;
+        } else {
+            (void)memcpy(&p[8], dir->name, id_len);
+        }
+
+        p += 8 + id_len + (id_len & 1);
+    }
+}
+
+static void
+_dir_write(uint8_t *buffer, const node_t *dir)
+{
+    uint32_t offset;
+    offset = 0;
+
+    offset += _dir_record_write(&buffer[offset], dir, "\0", 1);
+    offset += _dir_record_write(&buffer[offset],
+        (dir->parent != NULL) ? dir->parent : dir, "\1", 1);
+
+    for (uint32_t i = 0; i < dir->child_count; i++) {
+        const node_t * const child = dir->children[i];
+
+        char id[16];
+
+        (void)snprintf(id, sizeof(id), "%s%s", child->name,
+            child->directory ? "" : ";1");
+
+        const uint32_t id_len = _child_id_len(child);
+        const uint32_t sector_left = SECTOR_SIZE - (offset % SECTOR_SIZE);
+
+        if (_record_size(id_len) > sector_left) {
+            offset += sector_left;
+        }
+
+        offset += _dir_record_write(&buffer[offset], child, id, id_len);
+    }
+}
+
+static uint32_t
+_dir_record_write(uint8_t *record, const node_t *node, const char *id,
+    uint32_t id_len)
+{
+    const uint32_t record_size = _record_size(id_len);
+
+    record[0] = record_size;
+    record[1] = 0;
+
+    _both_32_write(&record[2], node->lba);
+    _both_32_write(&record[10], node->size);
+    _short_date_write(&record[18]);
+
+    record[25] = node->directory ? FILE_FLAG_DIRECTORY : 0x00;
+    record[26] = 0;
+    record[27] = 0;
+
+    _both_16_write(&record[28], 1);
+
+    record[32] = id_len;
+    (void)memcpy(&record[33], id, id_len);
+
+    return record_size;
+}
+
+static void
+_both_16_write(uint8_t *buffer, uint16_t value)
+{
+    _le16_write(&buffer[0], value);
+    _be16_write(&buffer[2], value);
+}
+
+static void
+_both_32_write(uint8_t *buffer, uint32_t value)
+{
+    _le32_write(&buffer[0], value);
+    _be32_write(&buffer[4], value);
+}
+
+static void
+_le16_write(uint8_t *buffer, uint16_t value)
+{
+    buffer[0] = value & 0xFF;
+    buffer[1] = (value >> 8) & 0xFF;
+}
+
+static void
+_le32_write(uint8_t *buffer, uint32_t value)
+{
+    buffer[0] = value & 0xFF;
+    buffer[1] = (value >> 8) & 0xFF;
+    buffer[2] = (value >> 16) & 0xFF;
+    buffer[3] = (value >> 24) & 0xFF;
+}
+
+static void
+_be16_write(uint8_t *buffer, uint16_t value)
+{
+    buffer[0] = (value >> 8) & 0xFF;
+    buffer[1] = value & 0xFF;
+}
+
+static void
+_be32_write(uint8_t *buffer, uint32_t value)
+{
+    buffer[0] = (value >> 24) & 0xFF;
+    buffer[1] = (value >> 16) & 0xFF;
+    buffer[2] = (value >> 8) & 0xFF;
+    buffer[3] = value & 0xFF;
+}
+
+/* Strings are padded with spaces */
+static void
+_string_write(uint8_t *buffer, const char *s, size_t size)
+{
+    const size_t len = strlen(s);
+
+    (void)memset(buffer, ' ', size);
+    (void)memcpy(buffer, s, (len < size) ? len : size);
+}
+
+static void
+_long_date_write(uint8_t *buffer, bool unset)
+{
+    if (unset) {
+        (void)memset(buffer, '0', 16);
+    } else {
+        char date[64];
+
+        (void)snprintf(date, sizeof(date), "%04d%02d%02d%02d%02d%02d00",
+            _tm.tm_year + 1900, _tm.tm_mon + 1, _tm.tm_mday, _tm.tm_hour,
+            _tm.tm_min, _tm.tm_sec);
+
+        (void)memcpy(buffer, date, 16);
+    }
+
+    /* GMT offset */
+    buffer[16] = 0;
+}
+
+static void
+_short_date_write(uint8_t *buffer)
+{
+    buffer[0] = _tm.tm_year;
+    buffer[1] = _tm.tm_mon + 1;
+    buffer[2] = _tm.tm_mday;
+    buffer[3] = _tm.tm_hour;
+    buffer[4] = _tm.tm_min;
+    buffer[5] = _tm.tm_sec;
+    buffer[6] = 0;
+}
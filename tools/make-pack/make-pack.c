@@ -0,0 +1,492 @@
+/*
+ * Copyright (c) Israel Jacquez
+ * See LICENSE for details.
+ *
+ * Israel Jacquez <mrkotfw@gmail.com>
+ */
+
+#define PROGNAME "make-pack"
+
+#include <sys/stat.h>
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Must match libyaul/kernel/fs/pack/pack.h */
+#define PACK_MAGIC         (0x5041434BUL)
+
+#define PACK_CODEC_NONE              (0)
+#define PACK_CODEC_LZ                (1)
+#define PACK_CODEC_PRS               (2)
+#define PACK_CODEC_RLE               (3)
+#define PACK_CODEC_HUFFMAN           (4)
+#define PACK_CODEC_LZ4               (5)
+#define PACK_CODEC_HUFFMAN_CANONICAL (6)
+
+#define PACK_HEADER_SIZE   (16)
+#define PACK_ENTRY_SIZE    (20)
+
+/* Must match libyaul/kernel/fs/cd/cdfs.h */
+#define SECTOR_SIZE        (2048)
+
+#define HASH_INIT          (0x811C9DC5UL)
+#define HASH_PRIME         (0x01000193UL)
+
+#define LINE_SIZE          (4096)
+
+typedef struct {
+    const char *name;
+    const char *program;
+    uint8_t codec;
+} codec_t;
+
+typedef struct {
+    char *name;
+    char *path;
+    uint32_t hash;
+    uint32_t sector;
+    uint32_t size;
+    uint32_t unpacked_size;
+    uint8_t codec;
+    uint8_t *buffer;
+} entry_t;
+
+static const codec_t _codecs[] = {
+    { "none",              NULL,             PACK_CODEC_NONE              },
+    { "lz",                "bcl_lz",         PACK_CODEC_LZ                },
+    { "prs",               "bcl_prs",        PACK_CODEC_PRS               },
+    { "rle",               "bcl_rle",        PACK_CODEC_RLE               },
+    { "huffman",           "bcl_huffman",    PACK_CODEC_HUFFMAN           },
+    { "lz4",               "bcl_lz4",        PACK_CODEC_LZ4               },
+    { "huffman-canonical", "bcl_huffman -c", PACK_CODEC_HUFFMAN_CANONICAL }
+};
+
+static entry_t *_entries = NULL;
+static uint32_t _entries_count = 0;
+
+static void _usage_print(void);
+static void _error_print(const char *format, ...);
+
+static int _list_read(const char *list_filename);
+static int _entry_load(entry_t *entry, const codec_t *codec,
+    const char *tmp_filename);
+static int _pack_write(const char *out_filename);
+
+static uint8_t *_file_read(const char *filename, uint32_t *size);
+static uint32_t _path_hash(const char *path);
+static const codec_t *_codec_find(const char *name);
+static int _entry_hash_compare(const void *a, const void *b);
+static void _be32_write(uint8_t *buffer, uint32_t value);
+
+static inline uint32_t
+_sector_count_round(uint32_t size)
+{
+    return ((size + (SECTOR_SIZE - 1)) / SECTOR_SIZE);
+}
+
+int
+main(int argc, char *argv[])
+{
+    if (argc != 3) {
+        _usage_print();
+
+        return 1;
+    }
+
+    const char * const list_filename = argv[1];
+    const char * const out_filename = argv[2];
+
+    if ((_list_read(list_filename)) != 0) {
+        return 1;
+    }
+
+    if (_entries_count == 0) {
+        _error_print("%s: No entries\n", list_filename);
+
+        return 1;
+    }
+
+    if ((_pack_write(out_filename)) != 0) {
+        return 1;
+    }
+
+    return 0;
+}
+
+static void
+_usage_print(void)
+{
+    (void)fprintf(stderr,
+        "Usage: %s list-file out-file\n"
+        "\n"
+        "Each line of list-file is an entry:\n"
+        "  name path [none|lz|lz4|prs|rle|huffman|huffman-canonical]\n"
+        "\n"
+        "Entries are placed in the pack in the order they are listed, so list\n"
+        "entries that are loaded together next to one another. Compression uses\n"
+        "the bcl_* tools, which must be in PATH. Lines starting with '#' are\n"
+        "ignored.\n",
+        PROGNAME);
+}
+
+static void
+_error_print(const char *format, ...)
+{
+    va_list args;
+
+    va_start(args, format);
+
+    (void)fprintf(stderr, "Error: %s: ", PROGNAME);
+    (void)vfprintf(stderr, format, args);
+
+    va_end(args);
+}
+
+static int
+_list_read(const char *list_filename)
+{
+    FILE *fp;
+
+    if ((fp = fopen(list_filename, "r")) == NULL) {
+        _error_print("%s: %s\n", list_filename, strerror(errno));
+
+        return -1;
+    }
+
+    char tmp_filename[LINE_SIZE];
+
+    (void)snprintf(tmp_filename, sizeof(tmp_filename), "%s.tmp", list_filename);
+
+    char line[LINE_SIZE];
+    uint32_t line_number;
+    line_number = 0;
+
+    int ret;
+    ret = 0;
+
+    while ((fgets(line, sizeof(line), fp)) != NULL) {
+        line_number++;
+
+        char * const name = strtok(line, " \t\r\n");
+
+        if ((name == NULL) || (*name == '#')) {
+            continue;
+        }
+
+        char * const path = strtok(NULL, " \t\r\n");
+        char * const codec_name = strtok(NULL, " \t\r\n");
+
+        if (path == NULL) {
+            _error_print("%s:%" PRIu32 ": Missing path\n", list_filename,
+                line_number);
+
+            ret = -1;
+            break;
+        }
+
+        const codec_t * const codec =
+            _codec_find((codec_name != NULL) ? codec_name : "none");
+
+        if (codec == NULL) {
+            _error_print("%s:%" PRIu32 ": Unknown codec \"%s\"\n",
+                list_filename, line_number, codec_name);
+
+            ret = -1;
+            break;
+        }
+
+        entry_t *entries;
+
+        entries = realloc(_entries, (_entries_count + 1) * sizeof(entry_t));
+
+        if (entries == NULL) {
+            _error_print("%s\n", strerror(errno));
+
+            ret = -1;
+            break;
+        }
+
+        _entries = entries;
+
+        entry_t * const entry = &_entries[_entries_count];
+
+        (void)memset(entry, 0, sizeof(entry_t));
+
+        entry->name = strdup(name);
+        entry->path = strdup(path);
+        entry->hash = _path_hash(name);
+
+        if ((_entry_load(entry, codec, tmp_filename)) != 0) {
+            ret = -1;
+            break;
+        }
+
+        _entries_count++;
+    }
+
+    (void)fclose(fp);
+
+    return ret;
+}
+
+static int
+_entry_load(entry_t *entry, const codec_t *codec, const char *tmp_filename)
+{
+    if ((entry->buffer = _file_read(entry->path, &entry->size)) == NULL) {
+        return -1;
+    }
+
+    entry->unpacked_size = entry->size;
+    entry->codec = PACK_CODEC_NONE;
+
+    if ((codec->program == NULL) || (entry->size == 0)) {
+        return 0;
+    }
+
+    char command[3 * LINE_SIZE];
+
+    (void)snprintf(command, sizeof(command), "%s \"%s\" \"%s\"",
+        codec->program, entry->path, tmp_filename);
+
+    if ((system(command)) != 0) {
+        _error_print("%s: Failed to run %s\n", entry->path, codec->program);
+
+        return -1;
+    }
+
+    uint32_t compressed_size;
+    uint8_t * const compressed = _file_read(tmp_filename, &compressed_size);
+
+    (void)remove(tmp_filename);
+
+    if (compressed == NULL) {
+        return -1;
+    }
+
+    /* Only keep the compressed data when it saves at least a sector, as
+     * otherwise it costs decompression time for nothing */
+    if (_sector_count_round(compressed_size) >= _sector_count_round(entry->size)) {
+        free(compressed);
+
+        return 0;
+    }
+
+    free(entry->buffer);
+
+    entry->buffer = compressed;
+    entry->size = compressed_size;
+    entry->codec = codec->codec;
+
+    return 0;
+}
+
+static int
+_pack_write(const char *out_filename)
+{
+    const uint32_t toc_size =
+        PACK_HEADER_SIZE + (_entries_count * PACK_ENTRY_SIZE);
+    const uint32_t toc_sector_count = _sector_count_round(toc_size);
+
+    /* Lay out the data in list order */
+    uint32_t sector;
+    sector = toc_sector_count;
+
+    for (uint32_t i = 0; i < _entries_count; i++) {
+        _entries[i].sector = sector;
+
+        sector += _sector_count_round(_entries[i].size);
+    }
+
+    const uint32_t sector_count = sector;
+
+    uint8_t * const pack = calloc(sector_count, SECTOR_SIZE);
+
+    if (pack == NULL) {
+        _error_print("%s\n", strerror(errno));
+
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < _entries_count; i++) {
+        const entry_t * const entry = &_entries[i];
+
+        (void)memcpy(&pack[entry->sector * SECTOR_SIZE], entry->buffer,
+            entry->size);
+    }
+
+    /* The table of contents is sorted by hash */
+    qsort(_entries, _entries_count, sizeof(entry_t), _entry_hash_compare);
+
+    for (uint32_t i = 1; i < _entries_count; i++) {
+        if (_entries[i - 1].hash == _entries[i].hash) {
+            _error_print("\"%s\" and \"%s\" have the same hash\n",
+                _entries[i - 1].name, _entries[i].name);
+
+            free(pack);
+
+            return -1;
+        }
+    }
+
+    _be32_write(&pack[0], PACK_MAGIC);
+    _be32_write(&pack[4], _entries_count);
+    _be32_write(&pack[8], toc_sector_count);
+    _be32_write(&pack[12], sector_count);
+
+    for (uint32_t i = 0; i < _entries_count; i++) {
+        const entry_t * const entry = &_entries[i];
+
+        uint8_t * const toc_entry =
+            &pack[PACK_HEADER_SIZE + (i * PACK_ENTRY_SIZE)];
+
+        _be32_write(&toc_entry[0], entry->hash);
+        _be32_write(&toc_entry[4], entry->sector);
+        _be32_write(&toc_entry[8], entry->size);
+        _be32_write(&toc_entry[12], entry->unpacked_size);
+        toc_entry[16] = entry->codec;
+
+        (void)printf("%08" PRIX32 " %6" PRIu32 " %8" PRIu32 " -> %8" PRIu32 " %s\n",
+            entry->hash, entry->sector, entry->unpacked_size, entry->size,
+            entry->name);
+    }
+
+    FILE *fp;
+    int ret;
+    ret = 0;
+
+    if ((fp = fopen(out_filename, "wb+")) == NULL) {
+        _error_print("%s: %s\n", out_filename, strerror(errno));
+
+        ret = -1;
+    } else {
+        if ((fwrite(pack, SECTOR_SIZE, sector_count, fp)) != sector_count) {
+            _error_print("%s: %s\n", out_filename, strerror(errno));
+
+            ret = -1;
+        }
+
+        (void)fclose(fp);
+    }
+
+    free(pack);
+
+    return ret;
+}
+
+static uint8_t *
+_file_read(const char *filename, uint32_t *size)
+{
+    FILE *fp;
+
+    if ((fp = fopen(filename, "rb")) == NULL) {
+        _error_print("%s: %s\n", filename, strerror(errno));
+
+        return NULL;
+    }
+
+    struct stat file_stat;
+
+    if ((fstat(fileno(fp), &file_stat)) != 0) {
+        _error_print("%s: %s\n", filename, strerror(errno));
+
+        (void)fclose(fp);
+
+        return NULL;
+    }
+
+    *size = file_stat.st_size;
+
+    /* Allocate at least one byte so that empty files are valid */
+    uint8_t * const buffer = malloc(*size + 1);
+
+    if (buffer == NULL) {
+        _error_print("%s\n", strerror(errno));
+
+        (void)fclose(fp);
+
+        return NULL;
+    }
+
+    if ((fread(buffer, 1, *size, fp)) != *size) {
+        _error_print("%s: %s\n", filename, strerror(errno));
+
+        free(buffer);
+
+        (void)fclose(fp);
+
+        return NULL;
+    }
+
+    (void)fclose(fp);
+
+    return buffer;
+}
+
+/* Same as cdfs_path_hash() */
+static uint32_t
+_path_hash(const char *path)
+{
+    if (*path == '/') {
+        path++;
+    }
+
+    uint32_t hash;
+    hash = HASH_INIT;
+
+    for (; *path != '\0'; path++) {
+        char c;
+        c = *path;
+
+        if ((c >= 'a') && (c <= 'z')) {
+            c -= 'a' - 'A';
+        }
+
+        hash = (hash ^ (uint8_t)c) * HASH_PRIME;
+    }
+
+    return hash;
+}
+
+static const codec_t *
+_codec_find(const char *name)
+{
+    for (uint32_t i = 0; i < (sizeof(_codecs) / sizeof(_codecs[0])); i++) {
+        if ((strcmp(_codecs[i].name, name)) == 0) {
+            return &_codecs[i];
+        }
+    }
+
+    return NULL;
+}
+
+static int
+_entry_hash_compare(const void *a, const void *b)
+{
+    const entry_t * const entry_a = a;
+    const entry_t * const entry_b = b;
+
+    if (entry_a->hash < entry_b->hash) {
+        return -1;
+    }
+
+    if (entry_a->hash > entry_b->hash) {
+        return 1;
+    }
+
+    return 0;
+}
+
+static void
+_be32_write(uint8_t *buffer, uint32_t value)
+{
+    buffer[0] = (value >> 24) & 0xFF;
+    buffer[1] = (value >> 16) & 0xFF;
+    buffer[2] = (value >> 8) & 0xFF;
+    buffer[3] = value & 0xFF;
+}